@@ -0,0 +1,583 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Engine benchmarks, built as SDL3DBench. Runs a few scenarios and writes the results as JSON,
+// so runs can be diffed against a stored baseline to catch regressions.
+// Headless by default (no window, no GPU needed). Use --render to also draw with OpenGL, Mesa's llvmpipe works fine:
+// xvfb-run ./SDL3DBench --render
+
+#include <Game.hpp>
+#include <Utils.hpp>
+#include <Definitions.hpp>
+#include <SimpleTimer.hpp>
+#include <ShadedObject.hpp>
+#include <PhysicsBody.hpp>
+#include <SceneSnapshot.hpp>
+#include <ObjectGeometryGroup.hpp>
+#include <MeshOptimizer.hpp>
+#include <JobSystem.hpp>
+
+#include <Box2D/Box2D.h>
+#include <SDL.h>
+
+#include <algorithm> // For std::sort
+#include <atomic>
+#include <cmath> // For ceil()
+#include <cstdlib> // For atoi, malloc and free
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory> // For smart pointers
+#include <new> // For std::bad_alloc
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+	#include <windows.h>
+	#include <psapi.h>
+
+	#ifdef _MSC_VER
+		#pragma comment(lib, "psapi.lib")
+	#endif
+#endif
+
+#define BENCH_DEFAULT_COUNT 1000 // Objects or bodies in scenarios that have some
+#define BENCH_DEFAULT_WARMUP_ITERATIONS 30 // Not measured, lets caches and allocators settle
+#define BENCH_DEFAULT_OBJ_FILE "suzanne.obj"
+#define BENCH_RESOURCE_NAME "bench" // Name of the shared geometry group, shader and texture
+#define BENCH_SCRIPT_NAME "bench"
+#define BENCH_SCRIPT_FILE BENCH_SCRIPT_NAME ".lua" // Copied next to the game's scripts when building
+
+// Counts every C++ allocation in the program (Lua and C libraries use malloc directly, those aren't counted)
+std::atomic<Uint64> gAllocationCount(0);
+
+void* operator new(std::size_t size)
+{
+	gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	void* pointer = std::malloc(size ? size : 1);
+
+	if(!pointer)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+namespace
+{
+struct BenchOptions
+{
+	std::vector<std::string> scenarios; // Empty for all of them
+	int count;
+	int iterations; // 0 for each scenario's default
+	int warmupIterations;
+	std::string OBJFile;
+	std::string outputFile; // Empty for stdout
+	bool render;
+};
+
+struct ScenarioResult
+{
+	std::string name;
+	int count;
+	int iterations;
+
+	double stepsPerSecond;
+	double minMs;
+	double averageMs;
+	double p50Ms;
+	double p90Ms;
+	double p99Ms;
+	double maxMs;
+
+	Uint64 setupAllocations;
+	Uint64 stepAllocations;
+	long peakRSSKB; // -1 if we can't know on this system
+};
+
+// Peak resident memory of the process, in KB
+long getPeakRSSKB()
+{
+#if defined(__linux__)
+	std::ifstream status("/proc/self/status");
+	std::string line;
+
+	while(std::getline(status, line))
+	{
+		if(line.compare(0, 6, "VmHWM:") == 0)
+			return std::atol(line.c_str() + 6);
+	}
+
+	return -1;
+#elif defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+
+	return -1;
+#else
+	return -1;
+#endif
+}
+
+// So each scenario gets its own peak instead of the biggest one so far
+// Only Linux can do this (4.0 and up), elsewhere the peak is for the whole run
+void resetPeakRSS()
+{
+#if defined(__linux__)
+	std::ofstream clearRefs("/proc/self/clear_refs");
+
+	if(clearRefs)
+		clearRefs << "5";
+#endif
+}
+
+double getPercentile(const std::vector<Uint64>& sortedTimes, double percentile)
+{
+	std::size_t index = static_cast<std::size_t>(std::ceil(sortedTimes.size() * percentile));
+	index = index > 0 ? index - 1 : 0;
+
+	return static_cast<double>(sortedTimes[index]) / 1000000.0; // To ms
+}
+
+// Sets everything up, then times each step on its own. Setup functions return the step function.
+ScenarioResult runScenario(const std::string& name, int count, int iterations, const BenchOptions& options,
+	const std::function<std::function<void()>()>& setup)
+{
+	ScenarioResult result;
+	result.name = name;
+	result.count = count;
+	result.iterations = iterations;
+
+	Utils::LOGPRINT("Benchmark '" + name + "' (" + std::to_string(count) + ", " + std::to_string(iterations) + " iterations).");
+
+	resetPeakRSS();
+
+	Uint64 allocationsBefore = gAllocationCount.load();
+	std::function<void()> step = setup();
+	result.setupAllocations = gAllocationCount.load() - allocationsBefore;
+
+	for(int i = 0; i < options.warmupIterations; i++)
+		step();
+
+	std::vector<Uint64> times;
+	times.reserve(iterations);
+
+	allocationsBefore = gAllocationCount.load();
+	Uint64 startTime = SimpleTimer::getCurrentNanoseconds();
+
+	for(int i = 0; i < iterations; i++)
+	{
+		Uint64 stepStartTime = SimpleTimer::getCurrentNanoseconds();
+		step();
+		times.push_back(SimpleTimer::getCurrentNanoseconds() - stepStartTime);
+	}
+
+	Uint64 totalTime = SimpleTimer::getCurrentNanoseconds() - startTime;
+	result.stepAllocations = gAllocationCount.load() - allocationsBefore; // Times were reserved, push_back() doesn't allocate
+
+	std::sort(times.begin(), times.end());
+
+	Uint64 timesSum = 0;
+	for(Uint64 time : times)
+		timesSum += time;
+
+	result.stepsPerSecond = totalTime ? iterations / (static_cast<double>(totalTime) / 1000000000.0) : 0.0;
+	result.minMs = static_cast<double>(times.front()) / 1000000.0;
+	result.averageMs = static_cast<double>(timesSum) / times.size() / 1000000.0;
+	result.p50Ms = getPercentile(times, 0.50);
+	result.p90Ms = getPercentile(times, 0.90);
+	result.p99Ms = getPercentile(times, 0.99);
+	result.maxMs = static_cast<double>(times.back()) / 1000000.0;
+	result.peakRSSKB = getPeakRSSKB();
+
+	return result;
+}
+
+// Draws what the entity manager sees, and waits for the GPU so its time is counted
+void renderEntities(Game& game, EntityManager& entityManager, SceneSnapshot& scene, RenderQueue& renderQueue)
+{
+	scene.clear();
+	entityManager.snapshot(scene, 1.0f);
+
+	if(Utils::isHeadless())
+		return;
+
+	scene.viewportSize = glm::ivec2(game.getSize());
+	scene.backgroundColor = game.getGraphicsBackgroundColor();
+	scene.render(renderQueue);
+
+	glFinish();
+}
+
+// Scenarios
+// Each one owns what it creates (captured in the step function), so nothing leaks into the next one
+
+// N objects using the same geometry, shader and texture. Steps and snapshots them (and renders with --render).
+std::function<void()> setupShadedObjects(Game& game, int count)
+{
+	ResourceManager& resourceManager = game.getResourceManager();
+
+	std::shared_ptr<EntityManager> entityManager(new EntityManager(glm::vec2(0.0f), 1 / static_cast<float>(DEFAULT_GAME_STEPS_PER_SECOND)));
+	std::shared_ptr<SceneSnapshot> scene(new SceneSnapshot());
+	std::shared_ptr<RenderQueue> renderQueue(new RenderQueue());
+
+	ResourceManager::objectGeometryGroup_pointer group = resourceManager.findObjectGeometryGroup(BENCH_RESOURCE_NAME);
+	ResourceManager::shaderPointer shader = resourceManager.findShader(BENCH_RESOURCE_NAME);
+	ResourceManager::texturePointer texture = resourceManager.findTexture(BENCH_RESOURCE_NAME);
+
+	std::shared_ptr<ObjectGeometry> objectGeometry = group->getObjectGeometries().front();
+
+	int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+
+	for(int i = 0; i < count; i++)
+	{
+		// Ignored by the physics engine, we only want to measure moving them around and drawing them
+		EntityManager::objectPointer object(new ShadedObject(objectGeometry, shader, texture, false, PHYSICS_BODY_IGNORED));
+
+		PhysicsBody& physicsBody = object->getPhysicsBody();
+		physicsBody.setPosition(glm::vec3((i % side) * 3.0f, 0.0f, (i / side) * -3.0f));
+		physicsBody.setVelocity(glm::vec3(0.0f, 0.1f, 0.0f));
+
+		entityManager->addObject(object);
+	}
+
+	Camera& camera = entityManager->getGameCamera();
+	camera.setAspectRatio(static_cast<float>(game.getSize().x) / game.getSize().y);
+	camera.getPhysicsBody().setPosition(glm::vec3(side * 1.5f, 10.0f, 10.0f));
+
+	return [&game, entityManager, scene, renderQueue]()
+	{
+		entityManager->step();
+		renderEntities(game, *entityManager, *scene, *renderQueue);
+	};
+}
+
+// N dynamic circles in the same world, all going towards the center so they collide
+std::function<void()> setupPhysicsBodies(int count)
+{
+	using physicsBodyVector = std::vector<std::unique_ptr<PhysicsBody>>;
+
+	std::shared_ptr<b2World> world(new b2World(b2Vec2(0.0f, 0.0f))); // Top-down, like the game
+	std::shared_ptr<physicsBodyVector> bodies(new physicsBodyVector());
+
+	int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+	float halfSize = side * 0.5f;
+
+	for(int i = 0; i < count; i++)
+	{
+		std::unique_ptr<PhysicsBody> body(new PhysicsBody(0.4f, PHYSICS_BODY_DYNAMIC));
+
+		glm::vec3 position((i % side) - halfSize, 0.0f, (i / side) - halfSize);
+
+		body->setPosition(position);
+		body->addToWorld(world.get());
+		body->setVelocity(-position);
+
+		bodies->push_back(std::move(body));
+	}
+
+	float timeStep = 1 / static_cast<float>(DEFAULT_GAME_STEPS_PER_SECOND);
+
+	return [world, bodies, timeStep]()
+	{
+		// Same as EntityManager::step()
+		for(auto& body : *bodies)
+			body->step(timeStep);
+
+		world->Step(timeStep, 6, 2);
+	};
+}
+
+// Parses the OBJ file again each iteration (and uploads it with --render)
+std::function<void()> setupOBJLoad(Game& game, const std::string& OBJFile)
+{
+	std::string path = game.getResourceManager().getFullResourcePath(OBJFile);
+
+	return [path]()
+	{
+		ObjectGeometryGroup group("bench", path);
+	};
+}
+
+// Optimizes a copy of the OBJ file's geometries each iteration, like parseOBJFile() does when loading
+std::function<void()> setupMeshOptimize(Game& game, const std::string& OBJFile)
+{
+	std::string path = game.getResourceManager().getFullResourcePath(OBJFile);
+	std::shared_ptr<ObjectGeometryGroup::geometryDataVector> geometries(new ObjectGeometryGroup::geometryDataVector);
+
+	bool wasEnabled = MeshOptimizer::isEnabledOnLoad();
+	MeshOptimizer::setEnabledOnLoad(false);
+	ObjectGeometryGroup::parseOBJFile(path, "bench", *geometries);
+	MeshOptimizer::setEnabledOnLoad(wasEnabled);
+
+	return [geometries]()
+	{
+		for(const auto& geometry : *geometries)
+		{
+			ObjectGeometryGroup::GeometryData copy = geometry;
+			MeshOptimizer::optimize(copy.indices, copy.positions, copy.UVs, copy.normals);
+		}
+	};
+}
+
+std::function<void()> setupTextureLoad(Game& game, const std::string& textureFile, int type)
+{
+	std::string path = game.getResourceManager().getFullResourcePath(textureFile);
+
+	return [path, type]()
+	{
+		Texture texture("bench", path, type);
+	};
+}
+
+// Calls a Lua function from C++ each iteration. gameStep goes through the objects, like a real script would.
+std::function<void()> setupLuaStep(Game& game, int count, const std::string& functionName)
+{
+	ResourceManager& resourceManager = game.getResourceManager();
+	EntityManager& entityManager = game.getEntityManager();
+
+	ResourceManager::scriptPointer script = resourceManager.findScript(BENCH_SCRIPT_NAME);
+
+	if(!script)
+	{
+		script = resourceManager.addScript(BENCH_SCRIPT_NAME, BENCH_SCRIPT_FILE);
+		script->bindInterface(game);
+		script->run();
+	}
+
+	// Objects left by the last Lua scenario
+	while(!entityManager.getObjects().empty())
+		entityManager.removeObject(entityManager.getObjects().size() - 1);
+
+	std::shared_ptr<ObjectGeometry> objectGeometry =
+		resourceManager.findObjectGeometryGroup(BENCH_RESOURCE_NAME)->getObjectGeometries().front();
+
+	for(int i = 0; i < count; i++)
+	{
+		EntityManager::objectPointer object(new ShadedObject(objectGeometry, resourceManager.findShader(BENCH_RESOURCE_NAME),
+			resourceManager.findTexture(BENCH_RESOURCE_NAME), false, PHYSICS_BODY_IGNORED));
+
+		object->getPhysicsBody().setPosition(glm::vec3(static_cast<float>(i), 0.0f, 0.0f));
+		entityManager.addObject(object);
+	}
+
+	return [script, functionName]()
+	{
+		script->runFunction(functionName);
+	};
+}
+
+std::string resultsToJSON(const std::vector<ScenarioResult>& results, const BenchOptions& options)
+{
+	std::ostringstream json;
+	json.setf(std::ios::fixed);
+	json.precision(4);
+
+	json << "{\n";
+	json << "\t\"engine\": \"" ENGINE_NAME "\",\n";
+	json << "\t\"version\": \"" ENGINE_VERSION "\",\n";
+	json << "\t\"render\": " << (options.render ? "true" : "false") << ",\n";
+	json << "\t\"scenarios\": [";
+
+	for(std::size_t i = 0; i < results.size(); i++)
+	{
+		const ScenarioResult& result = results[i];
+
+		json << (i == 0 ? "\n" : ",\n");
+		json << "\t\t{\n";
+		json << "\t\t\t\"name\": \"" << result.name << "\",\n";
+		json << "\t\t\t\"count\": " << result.count << ",\n";
+		json << "\t\t\t\"iterations\": " << result.iterations << ",\n";
+		json << "\t\t\t\"stepsPerSecond\": " << result.stepsPerSecond << ",\n";
+		json << "\t\t\t\"frameTimeMs\": {\"min\": " << result.minMs << ", \"average\": " << result.averageMs
+			<< ", \"p50\": " << result.p50Ms << ", \"p90\": " << result.p90Ms << ", \"p99\": " << result.p99Ms
+			<< ", \"max\": " << result.maxMs << "},\n";
+		json << "\t\t\t\"allocations\": {\"setup\": " << result.setupAllocations << ", \"steps\": " << result.stepAllocations
+			<< ", \"perStep\": " << static_cast<double>(result.stepAllocations) / result.iterations << "},\n";
+		json << "\t\t\t\"peakRSSKB\": " << result.peakRSSKB << "\n";
+		json << "\t\t}";
+	}
+
+	json << "\n\t]\n}\n";
+
+	return json.str();
+}
+
+bool shouldRun(const BenchOptions& options, const std::string& scenario)
+{
+	return options.scenarios.empty() || std::find(options.scenarios.begin(), options.scenarios.end(), scenario) != options.scenarios.end();
+}
+
+// Returns the amount of iterations to do
+int getIterations(const BenchOptions& options, int defaultIterations)
+{
+	return options.iterations > 0 ? options.iterations : defaultIterations;
+}
+}
+
+int main(int argc, char **argv)
+{
+	Utils::clearDataOutput();
+	Utils::setLogLevel(LOG_LEVEL_WARNING); // Loading messages would only slow things down
+
+	BenchOptions options;
+	options.count = BENCH_DEFAULT_COUNT;
+	options.iterations = 0;
+	options.warmupIterations = BENCH_DEFAULT_WARMUP_ITERATIONS;
+	options.OBJFile = BENCH_DEFAULT_OBJ_FILE;
+	options.render = false;
+
+	// Command line options
+	// --scenario NAME: only run this scenario, can be repeated
+	// --count N: objects/bodies in the scenarios that have some
+	// --iterations N: measured iterations for all scenarios
+	// --warmup N: iterations done before measuring
+	// --obj FILE: OBJ file for obj_load and mesh_optimize, in the resources directory
+	// --output FILE: write the JSON there instead of the standard output
+	// --render: create a window and an OpenGL context, and render the scenes
+	for(int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+
+		if(argument == "--scenario" && i + 1 < argc)
+			options.scenarios.push_back(argv[++i]);
+		else if(argument == "--count" && i + 1 < argc)
+			options.count = std::max(1, atoi(argv[++i]));
+		else if(argument == "--iterations" && i + 1 < argc)
+			options.iterations = std::max(1, atoi(argv[++i]));
+		else if(argument == "--warmup" && i + 1 < argc)
+			options.warmupIterations = std::max(0, atoi(argv[++i]));
+		else if(argument == "--obj" && i + 1 < argc)
+			options.OBJFile = argv[++i];
+		else if(argument == "--output" && i + 1 < argc)
+			options.outputFile = argv[++i];
+		else if(argument == "--render")
+			options.render = true;
+		else
+			Utils::WARN("Unknown command line argument '" + argument + "', ignoring it.");
+	}
+
+	std::vector<ScenarioResult> results;
+
+	{
+		Game game;
+		game.setHeadless(!options.render);
+		game.setThreadedRendering(false); // We render and wait ourselves
+
+		if(!game.init())
+			return 1;
+
+		char* basePathPointer = SDL_GetBasePath();
+		game.getResourceManager().setBasePath(basePathPointer ? basePathPointer : "");
+		SDL_free(basePathPointer);
+
+		// Shared by the object scenarios
+		ResourceManager& resourceManager = game.getResourceManager();
+		resourceManager.addObjectGeometryGroup(BENCH_RESOURCE_NAME, BENCH_DEFAULT_OBJ_FILE);
+		resourceManager.addShader(BENCH_RESOURCE_NAME, "shaded.v.glsl", "shaded.f.glsl");
+		resourceManager.addTexture(BENCH_RESOURCE_NAME, "suzanne.dds", TEXTURE_DDS);
+
+		if(shouldRun(options, "shaded_objects"))
+		{
+			results.push_back(runScenario("shaded_objects", options.count, getIterations(options, 600), options,
+				[&game, &options]() {return setupShadedObjects(game, options.count);}));
+		}
+
+		if(shouldRun(options, "physics_bodies"))
+		{
+			results.push_back(runScenario("physics_bodies", options.count, getIterations(options, 600), options,
+				[&options]() {return setupPhysicsBodies(options.count);}));
+		}
+
+		if(shouldRun(options, "obj_load"))
+		{
+			results.push_back(runScenario("obj_load", 1, getIterations(options, 50), options,
+				[&game, &options]() {return setupOBJLoad(game, options.OBJFile);}));
+		}
+
+		if(shouldRun(options, "mesh_optimize"))
+		{
+			results.push_back(runScenario("mesh_optimize", 1, getIterations(options, 50), options,
+				[&game, &options]() {return setupMeshOptimize(game, options.OBJFile);}));
+		}
+
+		if(shouldRun(options, "bmp_load"))
+		{
+			results.push_back(runScenario("bmp_load", 1, getIterations(options, 100), options,
+				[&game]() {return setupTextureLoad(game, "test.bmp", TEXTURE_BMP);}));
+		}
+
+		if(shouldRun(options, "dds_load"))
+		{
+			results.push_back(runScenario("dds_load", 1, getIterations(options, 100), options,
+				[&game]() {return setupTextureLoad(game, "suzanne.dds", TEXTURE_DDS);}));
+		}
+
+		if(shouldRun(options, "lua_call"))
+		{
+			results.push_back(runScenario("lua_call", 0, getIterations(options, 10000), options,
+				[&game]() {return setupLuaStep(game, 0, "gameStepEmpty");}));
+		}
+
+		if(shouldRun(options, "lua_game_step"))
+		{
+			results.push_back(runScenario("lua_game_step", options.count, getIterations(options, 600), options,
+				[&game, &options]() {return setupLuaStep(game, options.count, MAIN_SCRIPT_FUNCTION_STEP);}));
+		}
+	} // Resources are freed here, while we still have a context
+
+	std::string json = resultsToJSON(results, options);
+
+	if(options.outputFile.empty())
+	{
+		std::cout << json;
+	} else
+	{
+		std::ofstream file(options.outputFile, std::ios::out | std::ios::trunc);
+
+		if(file)
+			file << json;
+		else
+			Utils::WARN("Cannot open '" + options.outputFile + "' to write the results!");
+	}
+
+	JobSystem::stop(); // ~Game doesn't, running workers would abort the program when destroyed
+	SDL_Quit();
+	Utils::closeLogFile();
+
+	return 0;
+}
\ No newline at end of file
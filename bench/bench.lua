@@ -0,0 +1,21 @@
+-- Used by SDL3DBench, see bench/SDL3DBench.cpp
+-- Copied in the scripts directory when building
+
+local game = getGame()
+local entityManager = game:getEntityManager()
+
+total = 0
+
+-- Nothing to do, only measures calling Lua from C++
+function gameStepEmpty()
+end
+
+-- Close to what a real gameStep() does, goes through the objects and reads their physics bodies
+function gameStep()
+	local objects = entityManager:getObjects()
+
+	for i,v in ipairs(objects) do
+		local position = v:getPhysicsBody():getPosition()
+		total = total + position.x
+	end
+end
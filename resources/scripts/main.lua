@@ -11,6 +11,10 @@ local musicButtonPressedLastFrame = false
 function gameInit()
 	test.foo()
 	Utils.logprint("Hello, init from lua!")
+	
+	-- Physics shapes of all objects, drawn at once
+	entityManager:setDebugShapeShader(resourceManager:findShader("basic"))
+	entityManager:setDebugShapesVisible(true)
 end
 
 function gameStep()
@@ -18,16 +22,8 @@ function gameStep()
 	
 	local camera = entityManager:getGameCamera()
 	
-	local shader = resourceManager:findShader("basic");
-	local objects = entityManager:getObjects()
-	
 	doControls();
 	
-	for i,v in ipairs(objects) do
-		local physicsBody = v:getPhysicsBody()
-		physicsBody:renderDebugShape(shader, camera)
-	end
-	
 	local buildingPosition = test.building:getPhysicsBody():getPosition()
 	test.building:getPhysicsBody():setPosition(Vec3(buildingPosition.x, 0, 0))
 	
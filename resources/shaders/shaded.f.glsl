@@ -19,57 +19,72 @@
 
 // This file is heavily based off http://www.opengl-tutorial.org/, see SpecialThanks.txt
 
-// Per vertex lighting
+// Per fragment lighting, with every light of the frame
 
 #version 330 core
 
+#define MAX_LIGHTS 8 // Same as LIGHT_MAX_COUNT in Definitions.hpp!
+
 // Interpolated values from the vertex shader
 in vec2 UV;
 in vec3 normal_cameraspace;
-in vec3 lightDirection_cameraspace;
-in vec3 vertexPosition_worldspace;
-in vec3 eyeDirection_cameraspace;
+in vec3 vertexPosition_cameraspace;
 
 out vec3 color;
 
+struct Light
+{
+	vec4 position_cameraspace; // w is unused
+	vec4 diffuseColor; // w is the power
+	vec4 specularColor; // w is unused
+};
+
+// Same for the whole frame, see RenderQueue::LightsUniforms
+layout(std140) uniform Lights
+{
+	int lightCount;
+	Light lights[MAX_LIGHTS];
+};
+
 // Values that stay constant for the whole mesh
 uniform sampler2D textureSampler;
-//uniform vec3 lightColor;
-//uniform float lightPower
 
 void main()
 {
-	//DEBUG
-	vec3 lightPosition_worldspace = vec3(400, 400, 400);
-	vec3 lightColor = vec3(1.0, 1.0, 1.0);
-	float lightPower = 300000.0;
-	
 	vec3 textureColor = texture(textureSampler, UV).rgb;
 
 	vec3 materialDiffuseColor = textureColor;
 	vec3 materialAmbientColor = vec3(0.5, 0.5, 0.5) * materialDiffuseColor;
 	vec3 materialSpecularColor = vec3(1.0, 1.0, 1.0);
 	
-	float squareDistance = pow(length(lightPosition_worldspace - vertexPosition_worldspace), 2);
-	
 	vec3 n = normalize(normal_cameraspace); // Normal of fragment
-	vec3 ld = normalize(lightDirection_cameraspace); // Direction of the light (from the fragment to the light)
-	
-	float cosTheta = clamp(dot(n, ld), 0, 1); // Always positive! Otherwise we have a negative color.
 	
 	// From vertex towards the camera
-	vec3 E = normalize(eyeDirection_cameraspace);
-	// Direction in which the triangle reflects the light
-	vec3 R = reflect(-ld, n);
-	float cosAlpha = clamp(dot(E, R), 0, 1);
+	vec3 E = normalize(vec3(0, 0, 0) - vertexPosition_cameraspace);
 	
-	color = 
 	// Ambient : simulates indirect lighting
-	materialAmbientColor +
-	// Diffuse : "color" of the object
-	// In GLSL, multiplications are just the multiplications of the vector's components
-	materialDiffuseColor * lightColor * lightPower * cosTheta / squareDistance +
-	// Specular " reflective highlight, like a mirror
-	// Multiplying by cos theta removes annoying artefacts http://www.gamedev.net/topic/672374-blinn-phong-artifact-in-shader/
-	materialSpecularColor * lightColor * lightPower * pow(cosAlpha, 5) / squareDistance * cosTheta;
+	color = materialAmbientColor;
+	
+	for(int i = 0; i < lightCount; i++)
+	{
+		vec3 lightDirection_cameraspace = lights[i].position_cameraspace.xyz - vertexPosition_cameraspace; // From the fragment to the light
+		float lightPower = lights[i].diffuseColor.w;
+		
+		float squareDistance = dot(lightDirection_cameraspace, lightDirection_cameraspace);
+		vec3 ld = normalize(lightDirection_cameraspace);
+		
+		float cosTheta = clamp(dot(n, ld), 0, 1); // Always positive! Otherwise we have a negative color.
+		
+		// Direction in which the triangle reflects the light
+		vec3 R = reflect(-ld, n);
+		float cosAlpha = clamp(dot(E, R), 0, 1);
+		
+		color +=
+		// Diffuse : "color" of the object
+		// In GLSL, multiplications are just the multiplications of the vector's components
+		materialDiffuseColor * lights[i].diffuseColor.rgb * lightPower * cosTheta / squareDistance +
+		// Specular " reflective highlight, like a mirror
+		// Multiplying by cos theta removes annoying artefacts http://www.gamedev.net/topic/672374-blinn-phong-artifact-in-shader/
+		materialSpecularColor * lights[i].specularColor.rgb * lightPower * pow(cosAlpha, 5) / squareDistance * cosTheta;
+	}
 }
\ No newline at end of file
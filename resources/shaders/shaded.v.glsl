@@ -26,38 +26,34 @@ layout(location = 0) in vec3 vertexPosition_modelspace;
 layout(location = 1) in vec2 vertexUV;
 layout(location = 2) in vec3 vertexNormal_modelspace;
 
+// Same for the whole frame, see RenderQueue::CameraUniforms
+layout(std140) uniform Camera
+{
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjectionMatrix;
+};
+
 // Values that stay constant for the whole mesh
 uniform mat4 MVP;
 uniform mat4 modelMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 projectionMatrix;
-uniform mat4 normalMatrix;
+uniform mat3 normalMatrix; // Inverse transpose of the model matrix, model space
 
 // Output data
 out vec2 UV; // Proxy, sends UV coord to fragment shader
 out vec3 normal_cameraspace;
-out vec3 lightDirection_cameraspace;
-out vec3 vertexPosition_worldspace;
-out vec3 eyeDirection_cameraspace;
+out vec3 vertexPosition_cameraspace; // Lights are in camera space too
 
 void main()
 {
-	//DEBUG
-	vec3 lightPosition_worldspace = vec3(400, 400, 400);
-	
 	// UV of the vertex
 	UV = vertexUV;
 	
-	vertexPosition_worldspace = (modelMatrix * vec4(vertexPosition_modelspace, 1)).xyz;
-	
-	vec3 vertexPosition_cameraspace = (viewMatrix * modelMatrix * vec4(vertexPosition_modelspace, 1)).xyz;
-	// Vector from vertex to camera
-	eyeDirection_cameraspace = vec3(0, 0, 0) - vertexPosition_cameraspace;
-	
-	vec3 lightPosition_cameraspace = (viewMatrix * vec4(lightPosition_worldspace, 1)).xyz;
-	lightDirection_cameraspace = lightPosition_cameraspace + eyeDirection_cameraspace; // Vector from vertex to light
+	vec4 vertexPosition_worldspace = modelMatrix * vec4(vertexPosition_modelspace, 1);
+	vertexPosition_cameraspace = (viewMatrix * vertexPosition_worldspace).xyz;
 	
-	normal_cameraspace = (normalMatrix * vec4(vertexNormal_modelspace, 0.0)).xyz;
+	// The view matrix has no scaling, so its rotation part is enough for normals
+	normal_cameraspace = mat3(viewMatrix) * (normalMatrix * vertexNormal_modelspace);
 	
 	// Output position of the vertex
 	gl_Position = MVP * vec4(vertexPosition_modelspace, 1);
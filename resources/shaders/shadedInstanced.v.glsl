@@ -0,0 +1,60 @@
+//// Copyright 2015 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Instanced version of shaded.v.glsl, see RenderQueue::drawElementsInstanced()
+// The normal matrix is in model space here (inverse transpose of the model matrix), so it doesn't change with the camera.
+
+#version 330 core
+
+// Input vertex data, different for all executions
+layout(location = 0) in vec3 vertexPosition_modelspace;
+layout(location = 1) in vec2 vertexUV;
+layout(location = 2) in vec3 vertexNormal_modelspace;
+
+// Different for each instance
+layout(location = 3) in mat4 instanceModelMatrix; // Takes locations 3 to 6, one per column
+layout(location = 7) in mat3 instanceNormalMatrix; // Takes locations 7 to 9
+
+// Same for the whole frame, see RenderQueue::CameraUniforms
+layout(std140) uniform Camera
+{
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjectionMatrix;
+};
+
+// Output data
+out vec2 UV; // Proxy, sends UV coord to fragment shader
+out vec3 normal_cameraspace;
+out vec3 vertexPosition_cameraspace; // Lights are in camera space too
+
+void main()
+{
+	// UV of the vertex
+	UV = vertexUV;
+	
+	vec4 vertexPosition = instanceModelMatrix * vec4(vertexPosition_modelspace, 1);
+	vertexPosition_cameraspace = (viewMatrix * vertexPosition).xyz;
+	
+	// The view matrix has no scaling, so its rotation part is enough for normals
+	normal_cameraspace = mat3(viewMatrix) * (instanceNormalMatrix * vertexNormal_modelspace);
+	
+	// Output position of the vertex
+	gl_Position = viewProjectionMatrix * vertexPosition;
+}
\ No newline at end of file
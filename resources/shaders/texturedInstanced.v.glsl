@@ -0,0 +1,49 @@
+//// Copyright 2015 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Instanced version of textured.v.glsl, see RenderQueue::drawElementsInstanced()
+
+#version 330 core
+
+// Input vertex data, different for all executions
+layout(location = 0) in vec3 vertexPosition_modelspace;
+layout(location = 1) in vec2 vertexUV;
+
+// Different for each instance
+layout(location = 3) in mat4 instanceModelMatrix; // Takes locations 3 to 6, one per column
+
+// Same for the whole frame, see RenderQueue::CameraUniforms
+layout(std140) uniform Camera
+{
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjectionMatrix;
+};
+
+// Output data
+out vec2 UV; // Proxy, sends UV coord to fragment shader
+
+void main()
+{
+	// Output position of the vertex
+	gl_Position = viewProjectionMatrix * instanceModelMatrix * vec4(vertexPosition_modelspace, 1);
+	
+	// UV of the vertex
+	UV = vertexUV;
+}
\ No newline at end of file
@@ -39,6 +39,8 @@ Camera::Camera() // Constructor
 
 	mNearClippingDistance = 0.05f;
 	mFarClippingPlaneDistance = 100.0f; // 100 meters max
+
+	mLODBias = 0.0f;
 }
 
 Camera::~Camera()
@@ -100,11 +102,28 @@ float Camera::getFarClippingDistance()
 	return mFarClippingPlaneDistance;
 }
 
+// 1 uses one level less detailed everywhere, -1 one more. Raise it to keep the frame rate of dense scenes.
+void Camera::setLODBias(float bias)
+{
+	mLODBias = bias;
+}
+
+float Camera::getLODBias() const
+{
+	return mLODBias;
+}
+
 glm::mat4 Camera::getViewMatrix() const
+{
+	return getViewMatrix(1.0f); // Current position
+}
+
+// See PhysicsBody::getInterpolatedPosition()
+glm::mat4 Camera::getViewMatrix(float interpolation) const
 {
 	const PhysicsBody& physicsBody = getPhysicsBody();
 
-	glm::vec3 position = physicsBody.getPosition() * PHYSICS_PIXELS_PER_METER;
+	glm::vec3 position = physicsBody.getInterpolatedPosition(interpolation) * PHYSICS_PIXELS_PER_METER;
 	glm::vec3 vec3Direction;
 
 	if(mDirection.w==1) // Is a position
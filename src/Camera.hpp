@@ -39,6 +39,8 @@ private:
 	float mAspectRatio;
 	float mNearClippingDistance; // In meters
 	float mFarClippingPlaneDistance;
+
+	float mLODBias; // Added to the level of detail of everything it sees, positive is less detailed
 public:
 	Camera();
 	~Camera() override;
@@ -56,7 +58,11 @@ public:
 	void setFarClippingDistance(float distance);
 	float getFarClippingDistance();
 
+	void setLODBias(float bias);
+	float getLODBias() const;
+
 	glm::mat4 getViewMatrix() const;
+	glm::mat4 getViewMatrix(float interpolation) const;
 	glm::mat4 getProjectionMatrix() const;
 };
 
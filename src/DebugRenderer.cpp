@@ -0,0 +1,64 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <DebugRenderer.hpp>
+
+#include <Definitions.hpp>
+#include <Profiler.hpp>
+
+#include <cstddef> // For std::size_t
+
+DebugRenderer::DebugRenderer()
+{
+	mVertexArray = 0;
+}
+
+void DebugRenderer::render(const std::vector<glm::vec3>& lines, const Shader& shader, const glm::mat4& viewProjectionMatrix, StreamingBuffer& buffer)
+{
+	if(lines.empty())
+		return;
+
+	PROFILE_ZONE("DebugRenderer::render");
+
+	std::size_t offset = buffer.write(lines.data(), lines.size() * sizeof(glm::vec3));
+
+	if(mVertexArray == 0) // We are on the drawing context now
+	{
+		glGenVertexArrays(1, &mVertexArray);
+		glBindVertexArray(mVertexArray);
+		glEnableVertexAttribArray(0);
+	} else
+	{
+		glBindVertexArray(mVertexArray);
+	}
+
+	// The lines aren't at the same place each frame
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.getID());
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)offset);
+
+	glUseProgram(shader.getID());
+	shader.setUniform(SHADER_UNIFORM_MVP, viewProjectionMatrix); // Lines are already in world space
+	shader.setUniform(SHADER_UNIFORM_COLOR, glm::vec3(0.0f, 1.0f, 0.0f));
+
+	glDisable(GL_CULL_FACE); // Must re-enable after!
+
+	glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(lines.size()));
+
+	glEnable(GL_CULL_FACE);
+}
\ No newline at end of file
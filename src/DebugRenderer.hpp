@@ -0,0 +1,47 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Draws the physics debug shapes of a frame as lines, all of them in one draw call.
+// The lines are written in the frame's streaming buffer (see StreamingBuffer), the VAO points to wherever they are.
+
+#ifndef DEBUG_RENDERER_HPP
+#define DEBUG_RENDERER_HPP
+
+#include <Shader.hpp>
+#include <StreamingBuffer.hpp>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class DebugRenderer
+{
+private:
+	GLuint mVertexArray; // Created on the drawing context, deleted with it
+
+public:
+	DebugRenderer();
+
+	// Lines are in world space, two points per line. The shader needs MVP and color, like basic.v.glsl.
+	// Call between the streaming buffer's beginFrame() and endFrame().
+	void render(const std::vector<glm::vec3>& lines, const Shader& shader, const glm::mat4& viewProjectionMatrix, StreamingBuffer& buffer);
+};
+
+#endif /* DEBUG_RENDERER_HPP */
\ No newline at end of file
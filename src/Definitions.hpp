@@ -33,9 +33,82 @@
 #define GRAPHICS_OPENGL_MAJOR_VERSION 3
 #define GRAPHICS_OPENGL_MINOR_VERSION 3
 
+#define GRAPHICS_MAX_DEBUG_MESSAGES_PER_ID 10 // After that, the same OpenGL debug message is not logged anymore
+
 #define GRAPHICS_RASTERIZE_FACE GL_FRONT_AND_BACK
 #define GRAPHICS_RASTERIZE_MODE GL_FILL
 
+// Vertex layouts, which attributes a shader reads. See ObjectGeometry::getVertexArray().
+#define VERTEX_LAYOUT_POSITIONS 0 // Location 0
+#define VERTEX_LAYOUT_TEXTURED 1 // Locations 0 and 1 (UVs)
+#define VERTEX_LAYOUT_SHADED 2 // Locations 0, 1 and 2 (normals)
+#define VERTEX_LAYOUT_COUNT 3
+
+// How ObjectGeometry keeps its vertices on the GPU, see ObjectGeometry::PackedVertex
+#define VERTEX_FORMAT_SEPARATE 0 // One float buffer per attribute, 32-bit indices
+#define VERTEX_FORMAT_PACKED 1 // One interleaved buffer with compact attributes, 16-bit indices when possible
+#define VERTEX_FORMAT_MAX_SHORT_INDEX_VERTICES 65536 // Geometry with more vertices needs 32-bit indices
+
+// Big shared buffers for packed geometry, see GeometryArena
+#define GEOMETRY_ARENA_DEFAULT_ENABLED true
+#define GEOMETRY_ARENA_PAGE_VERTICES (256 * 1024) // 5 MB of packed vertices, bigger geometry gets a page of its own
+#define GEOMETRY_ARENA_PAGE_INDEX_SIZE (4 * 1024 * 1024) // In bytes
+#define GEOMETRY_ARENA_INDEX_ALIGNMENT 4 // Bytes, so 16 and 32-bit indices can share a buffer
+#define GEOMETRY_ARENA_SORT_RANGE_BITS 8 // Low bits of ObjectGeometry::getSortID() for the geometry, the page is above
+
+// Load time mesh optimization, see MeshOptimizer
+#define MESH_OPTIMIZER_DEFAULT_ON_LOAD true // .obj files are optimized when they are parsed
+#define MESH_OPTIMIZER_CACHE_SIZE 16 // Post-transform cache entries we optimize for (and simulate for the ACMR)
+#define MESH_OPTIMIZER_OVERDRAW_THRESHOLD 1.05f // Clusters are cut smaller if their ACMR stays under this times the original one
+
+// Levels of detail, simplified versions of a geometry (see MeshOptimizer::generateLODs() and ObjectGeometry::getLOD())
+#define LOD_DEFAULT_ON_LOAD true // .obj files get their levels when they are parsed
+#define LOD_MAX_LEVELS 4 // Including the full geometry
+#define LOD_TRIANGLE_RATIO 0.5f // Each level aims for this many of the triangles of the full geometry times the last level's ratio
+#define LOD_MIN_REDUCTION 0.8f // A level is only kept if it has at most this many of the last level's triangles
+#define LOD_MIN_TRIANGLES 64 // Smaller geometry isn't worth simplifying
+#define LOD_MAX_ERROR 0.01f // Of the bounding sphere radius, for level 1. Doubles for each next level, like the screen size halves.
+#define LOD_SCREEN_SIZE 0.25f // Of the screen height, objects smaller than this use level 1. Each next level is at half the size.
+#define LOD_HYSTERESIS 0.1f // Objects only change level when they are this much past the size, so they don't flicker
+
+// Per-instance attributes of instanced VAOs, see RenderQueue::InstanceData
+#define VERTEX_INSTANCE_MODEL_MATRIX_LOCATION 3 // mat4, takes 4 locations (one per column)
+#define VERTEX_INSTANCE_NORMAL_MATRIX_LOCATION 7 // mat3, takes 3 locations
+
+// Frustum culling, see Frustum::classifySpheres()
+#define FRUSTUM_OUTSIDE 0
+#define FRUSTUM_INSIDE 1
+#define FRUSTUM_INTERSECTS 2 // Touches a plane, might be visible
+
+// Render passes, drawn in this order (see RenderQueue)
+#define RENDER_PASS_OPAQUE 0
+
+#define RENDER_QUEUE_MAX_DEPTH 1000.0f // Further objects are all sorted as if they were this far
+#define RENDER_QUEUE_MIN_INSTANCES 2 // Objects that can be drawn together are instanced when there are at least this many
+
+// Uniform blocks shared by all shaders, see Shader::bindUniformBlocks()
+#define UNIFORM_BLOCK_CAMERA_NAME "Camera"
+#define UNIFORM_BLOCK_CAMERA_BINDING 0
+#define UNIFORM_BLOCK_LIGHTS_NAME "Lights"
+#define UNIFORM_BLOCK_LIGHTS_BINDING 1
+
+// Per frame data (instances, uniform blocks, debug lines), see StreamingBuffer
+#define STREAMING_BUFFER_FRAME_COUNT 3 // Frames that can be in flight at once, each has its own region of the buffer
+#define STREAMING_BUFFER_DEFAULT_REGION_SIZE (1024 * 1024) // Bytes per frame, grows if needed
+#define STREAMING_BUFFER_DEFAULT_ALIGNMENT 16 // Enough for any vertex attribute
+
+// Uniforms the engine sets itself, looked up once when the shader is linked (see Shader::setUniform())
+#define SHADER_UNIFORM_MVP 0
+#define SHADER_UNIFORM_MODEL_MATRIX 1
+#define SHADER_UNIFORM_NORMAL_MATRIX 2
+#define SHADER_UNIFORM_TEXTURE_SAMPLER 3
+#define SHADER_UNIFORM_COLOR 4
+#define SHADER_UNIFORM_COUNT 5
+
+// Lights
+#define LIGHT_MAX_COUNT 8 // Sent to the shaders each frame, the closest ones are kept. Same as MAX_LIGHTS in shaded.f.glsl!
+#define LIGHT_MIN_INTENSITY (1.0f / 256.0f) // Lights are skipped when everything they can reach is dimmer than this
+
 // Defines how many chunk sounds can exist. A super high number exceeding memory could segfault!
 #define MAX_SOUND_CHANNELS 50
 
@@ -44,6 +117,8 @@
 #define DEFAULT_GAME_WINDOW_WIDTH 800
 #define DEFAULT_GAME_WINDOW_HEIGHT 600
 #define DEFAULT_GAME_MAX_FRAMES_PER_SECOND 60
+#define DEFAULT_GAME_STEPS_PER_SECOND 120
+#define DEFAULT_GAME_MAX_STEPS_PER_FRAME 10 // Past this, the game slows down instead of trying to catch up
 
 // Files and paths
 #define LOG_FILE "Log.txt"
@@ -66,6 +141,40 @@
 #define SOUND_MUSIC 0
 #define SOUND_CHUNK 1 // Short sound effects would use this type
 
+// Job system
+#define JOB_SYSTEM_MAX_WORKERS 64
+#define JOB_SYSTEM_SPIN_COUNT 64 // Times an idle worker yields before going to sleep
+#define JOB_SYSTEM_SNAPSHOT_GRAIN_SIZE 128 // Objects per chunk when snapshotting the scene
+#define SNAPSHOT_BATCH_SIZE 64 // Objects transformed and culled at once in a chunk, kept on the stack
+
+// Frame pacing, times in nanoseconds
+#define FRAME_PACER_MIN_SPIN 200000 // Always spin at least this long before the deadline
+#define FRAME_PACER_MAX_SPIN 4000000 // Never spin longer, even if SDL_Delay() is very late
+#define FRAME_PACER_INITIAL_SLEEP_OVERSHOOT 1000000 // Until we know better
+#define FRAME_PACER_HISTOGRAM_BUCKET_LENGTH 250000
+#define FRAME_PACER_HISTOGRAM_BUCKETS 200 // Up to 50 ms
+
+// The scene is drawn in a RenderTarget, then scaled to the window
+#define RENDER_TARGET_BLIT_FILTER GL_LINEAR // When the scene is smaller than the window
+#define CAPTURE_FRAME_NUMBER_DIGITS 6 // Frame numbers in capture file names are padded with zeros, so they sort
+#define GPU_TIMER_QUERY_COUNT 4 // Frames measured at once, results are only read once they are ready so we never wait
+
+// Internal resolution from the GPU frame time, see DynamicResolution
+#define DYNAMIC_RESOLUTION_DEFAULT_ENABLED false
+#define DYNAMIC_RESOLUTION_DEFAULT_TARGET_FPS 60
+#define DYNAMIC_RESOLUTION_DEFAULT_MIN_SCALE 0.5f // Of the window size, on each axis
+#define DYNAMIC_RESOLUTION_DEFAULT_MAX_SCALE 1.0f
+#define DYNAMIC_RESOLUTION_HEADROOM 0.85f // Aims for this much of the frame time, the CPU, the blit and the swap need some too
+#define DYNAMIC_RESOLUTION_TOLERANCE 0.1f // GPU times this close to the aim don't change anything
+#define DYNAMIC_RESOLUTION_MAX_STEP 0.1f // Biggest change of the scale at once
+#define DYNAMIC_RESOLUTION_ADJUST_INTERVAL 15 // Frames between changes, GPU times come a few frames late
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.1f // Weight of each new GPU time in the average
+
+// Input recorder modes
+#define INPUT_RECORDER_IDLE 0
+#define INPUT_RECORDER_RECORDING 1
+#define INPUT_RECORDER_REPLAYING 2
+
 // Physics
 #define PHYSICS_PIXELS_PER_METER 10.0f // Float
 
@@ -0,0 +1,140 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <DynamicResolution.hpp>
+
+#include <Definitions.hpp>
+#include <Utils.hpp>
+
+#include <algorithm> // For std::min() and std::max()
+#include <cmath> // For std::sqrt()
+
+DynamicResolution::DynamicResolution()
+{
+	mEnabled = DYNAMIC_RESOLUTION_DEFAULT_ENABLED;
+	mTargetFramesPerSecond = DYNAMIC_RESOLUTION_DEFAULT_TARGET_FPS;
+	mMinScale = DYNAMIC_RESOLUTION_DEFAULT_MIN_SCALE;
+	mMaxScale = DYNAMIC_RESOLUTION_DEFAULT_MAX_SCALE;
+
+	mScale = mMaxScale;
+	mAverageGPUTime = 0.0f;
+	mFramesSinceChange = 0;
+}
+
+void DynamicResolution::update(float gpuFrameTime)
+{
+	if(gpuFrameTime <= 0.0f) // Timer queries not supported, or no result yet
+		return;
+
+	if(mAverageGPUTime <= 0.0f)
+		mAverageGPUTime = gpuFrameTime;
+	else
+		mAverageGPUTime += (gpuFrameTime - mAverageGPUTime) * DYNAMIC_RESOLUTION_SMOOTHING;
+
+	if(!mEnabled || ++mFramesSinceChange < DYNAMIC_RESOLUTION_ADJUST_INTERVAL)
+		return;
+
+	float aim = (1000.0f / mTargetFramesPerSecond) * DYNAMIC_RESOLUTION_HEADROOM;
+	float ratio = aim / mAverageGPUTime;
+
+	if(std::abs(ratio - 1.0f) <= DYNAMIC_RESOLUTION_TOLERANCE) // Close enough
+		return;
+
+	float scale = mScale * std::sqrt(ratio);
+	scale = std::max(mScale - DYNAMIC_RESOLUTION_MAX_STEP, std::min(scale, mScale + DYNAMIC_RESOLUTION_MAX_STEP));
+	scale = std::max(mMinScale, std::min(scale, mMaxScale));
+
+	if(scale != mScale)
+	{
+		// Guess what the new size will cost, instead of waiting for the average to catch up
+		mAverageGPUTime *= (scale * scale) / (mScale * mScale);
+		mScale = scale;
+	}
+
+	mFramesSinceChange = 0;
+}
+
+// At least one pixel
+glm::ivec2 DynamicResolution::getRenderSize(glm::ivec2 windowSize) const
+{
+	float scale = mEnabled ? mScale : 1.0f;
+
+	return glm::max(glm::ivec2(glm::round(glm::vec2(windowSize) * scale)), glm::ivec2(1));
+}
+
+void DynamicResolution::setEnabled(bool enabled)
+{
+	mEnabled = enabled;
+	mFramesSinceChange = 0;
+}
+
+bool DynamicResolution::isEnabled() const
+{
+	return mEnabled;
+}
+
+void DynamicResolution::setTargetFramesPerSecond(int targetFPS)
+{
+	if(targetFPS <= 0)
+	{
+		Utils::WARN("Dynamic resolution target of " + std::to_string(targetFPS) + " frames per second is invalid, ignoring it.");
+		return;
+	}
+
+	mTargetFramesPerSecond = targetFPS;
+}
+
+int DynamicResolution::getTargetFramesPerSecond() const
+{
+	return mTargetFramesPerSecond;
+}
+
+void DynamicResolution::setScaleRange(float minScale, float maxScale)
+{
+	if(minScale <= 0.0f || minScale > maxScale || maxScale > 1.0f)
+	{
+		Utils::WARN("Dynamic resolution scale range from " + std::to_string(minScale) + " to " + std::to_string(maxScale) +
+			" is invalid, it must be between 0 and 1. Ignoring it.");
+		return;
+	}
+
+	mMinScale = minScale;
+	mMaxScale = maxScale;
+	mScale = std::max(mMinScale, std::min(mScale, mMaxScale));
+}
+
+float DynamicResolution::getMinScale() const
+{
+	return mMinScale;
+}
+
+float DynamicResolution::getMaxScale() const
+{
+	return mMaxScale;
+}
+
+float DynamicResolution::getScale() const
+{
+	return mEnabled ? mScale : 1.0f;
+}
+
+float DynamicResolution::getAverageGPUTime() const
+{
+	return mAverageGPUTime;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Picks the size the scene is drawn at (see RenderTarget), from how long the GPU took for the last frames.
+// When the GPU is too slow for the target frame rate, the scene is drawn smaller and scaled up to the window,
+// when it has time to spare, it grows back up to the window size.
+//
+// The GPU time is mostly the fragments, so it follows the pixel count: the scale (on each axis) changes by the
+// square root of how far we are from the aim. Changes are spaced out and limited, so it doesn't bounce around.
+
+#ifndef DYNAMIC_RESOLUTION_HPP
+#define DYNAMIC_RESOLUTION_HPP
+
+#include <glm/glm.hpp>
+
+class DynamicResolution
+{
+private:
+	bool mEnabled;
+	int mTargetFramesPerSecond;
+	float mMinScale;
+	float mMaxScale;
+
+	float mScale; // Of the window size, on each axis
+	float mAverageGPUTime; // In milliseconds, 0 until we have one
+	int mFramesSinceChange;
+
+public:
+	DynamicResolution();
+
+	void update(float gpuFrameTime); // Once per frame, in milliseconds. 0 if unknown.
+	glm::ivec2 getRenderSize(glm::ivec2 windowSize) const;
+
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+	void setTargetFramesPerSecond(int targetFPS);
+	int getTargetFramesPerSecond() const;
+	void setScaleRange(float minScale, float maxScale); // From 0 to 1
+	float getMinScale() const;
+	float getMaxScale() const;
+
+	float getScale() const;
+	float getAverageGPUTime() const;
+};
+
+#endif /* DYNAMIC_RESOLUTION_HPP */
\ No newline at end of file
@@ -22,8 +22,11 @@
 #include <EntityManager.hpp>
 #include <Utils.hpp>
 #include <Definitions.hpp>
+#include <Profiler.hpp>
+#include <JobSystem.hpp>
 
 #include <algorithm> // For finding in vector
+#include <cmath> // For std::sqrt()
 #include <string>
 
 #include <Box2D/Box2D.h>
@@ -36,6 +39,12 @@ EntityManager::EntityManager(glm::vec2 gravity, float physicsTimePerStep)
 	mPhysicsVelocityIterations = 6;
 	mPhysicsPositionIterations = 2;
 
+	mFrustumCulling = true;
+
+	mDebugShapesVisible = false;
+	mVisibleObjectCount = 0;
+	mCulledObjectCount = 0;
+
 	mGameCamera.getPhysicsBody().addToWorld(&mPhysicsWorld); // Add it to the world
 }
 
@@ -166,8 +175,8 @@ EntityManager::lightVector& EntityManager::getLights()
 	return mLights;
 }
 
-// Set the number of seconds elapsed per frame (will be under 0 most of the time)
-// Allows us to do slow motion!
+// Set the number of seconds elapsed per step (will be under 1 most of the time)
+// By default, this is the real length of a step. Smaller values do slow motion!
 void EntityManager::setPhysicsTimePerStep(float time)
 {
 	mPhysicsTimePerStep = time;
@@ -179,10 +188,12 @@ float EntityManager::getPhysicsTimePerStep()
 }
 
 // Steps all entities
-// Divider will divide the step time, useful for calling this function multiple times per frame
-void EntityManager::step(float divider)
+// Always advances by the same amount of time, the game loop calls this as many times as needed to follow the clock
+void EntityManager::step()
 {
-	float time = mPhysicsTimePerStep / divider;
+	float time = mPhysicsTimePerStep;
+
+	PhysicsBody::clearQueuedDebugShapes(); // Scripts queue them again during the step if they want them
 
 	for(auto &object : mObjects)
 		object->getPhysicsBody().step(time);
@@ -192,13 +203,270 @@ void EntityManager::step(float divider)
 
 	mGameCamera.getPhysicsBody().step(time);
 
+	PROFILE_ZONE("b2World::Step");
 	mPhysicsWorld.Step(time, mPhysicsVelocityIterations, mPhysicsPositionIterations);
 }
 
-void EntityManager::render() // Renders all entities that can be rendered
+// Static
+// Spheres of the objects [begin, end[ of the scene, at most SNAPSHOT_BATCH_SIZE of them
+void EntityManager::computeBoundingSpheres(const SceneSnapshot& scene, int begin, int end, BoundingSpheres& spheres)
+{
+	int count = end - begin;
+
+	for(int i = 0; i < count; i++)
+	{
+		const ObjectSnapshot& object = scene.objects[begin + i];
+		const glm::mat4& modelMatrix = object.modelMatrix;
+
+		glm::vec4 center = modelMatrix * glm::vec4(object.objectGeometry->getBoundingSphereCenter(), 1.0f);
+
+		// The sphere grows with the biggest scaling of the model matrix
+		float squaredScale = std::max(glm::dot(glm::vec3(modelMatrix[0]), glm::vec3(modelMatrix[0])),
+			std::max(glm::dot(glm::vec3(modelMatrix[1]), glm::vec3(modelMatrix[1])), glm::dot(glm::vec3(modelMatrix[2]), glm::vec3(modelMatrix[2]))));
+
+		spheres.x[i] = center.x;
+		spheres.y[i] = center.y;
+		spheres.z[i] = center.z;
+		spheres.radius[i] = object.objectGeometry->getBoundingSphereRadius() * std::sqrt(squaredScale);
+	}
+}
+
+// Marks which objects of [begin, end[ can be seen in mObjectVisibility
+// Bounding spheres are tested all at once first (see Frustum::classifySpheres()), then boxes for the ones touching a plane.
+void EntityManager::cullObjects(const SceneSnapshot& scene, const Frustum& frustum, int begin, int end, const BoundingSpheres& spheres)
+{
+	if(!mFrustumCulling)
+	{
+		std::fill(mObjectVisibility.begin() + begin, mObjectVisibility.begin() + end, 1);
+		return;
+	}
+
+	unsigned char results[SNAPSHOT_BATCH_SIZE];
+	int count = end - begin;
+
+	frustum.classifySpheres(spheres.x, spheres.y, spheres.z, spheres.radius, count, results);
+
+	for(int i = 0; i < count; i++)
+	{
+		const ObjectSnapshot& object = scene.objects[begin + i];
+		bool visible = (results[i] == FRUSTUM_INSIDE);
+
+		if(results[i] == FRUSTUM_INTERSECTS)
+			visible = frustum.isBoxVisible(object.objectGeometry->getBoundsMin(), object.objectGeometry->getBoundsMax(), object.modelMatrix);
+
+		mObjectVisibility[begin + i] = visible ? 1 : 0;
+	}
+}
+
+// Picks the level of detail of the visible objects from their size on the screen (see LOD_SCREEN_SIZE).
+// An object only changes level once it is LOD_HYSTERESIS past the size where it would, so it doesn't flicker
+// between two levels when it stays around that size. Size scale is the projection's y scale, with the LOD bias.
+void EntityManager::selectLODs(SceneSnapshot& scene, int begin, int end, const BoundingSpheres& spheres, glm::vec3 cameraPosition, float sizeScale)
+{
+	for(int i = begin; i < end; i++)
+	{
+		if(!mObjectVisibility[i]) // Keeps its level for when it comes back
+			continue;
+
+		ObjectSnapshot& object = scene.objects[i];
+		int levelCount = object.objectGeometry->getLODCount();
+
+		if(levelCount <= 1)
+		{
+			mObjectLODLevels[i] = 0;
+			continue;
+		}
+
+		glm::vec3 center(spheres.x[i - begin], spheres.y[i - begin], spheres.z[i - begin]);
+		float radius = spheres.radius[i - begin];
+		float distance = glm::length(center - cameraPosition);
+
+		// Height of the sphere on the screen, 1 is the whole screen
+		float size = (distance > radius) ? radius * sizeScale / distance : LOD_SCREEN_SIZE * 2.0f;
+
+		// Levels level and level + 1 are split at LOD_SCREEN_SIZE / 2^level
+		int level = std::min(static_cast<int>(mObjectLODLevels[i]), levelCount - 1);
+
+		while(level > 0 && size > LOD_SCREEN_SIZE / (1 << (level - 1)) * (1.0f + LOD_HYSTERESIS))
+			level--;
+
+		while(level < levelCount - 1 && size < LOD_SCREEN_SIZE / (1 << level) * (1.0f - LOD_HYSTERESIS))
+			level++;
+
+		mObjectLODLevels[i] = static_cast<unsigned char>(level);
+
+		if(level > 0)
+			object.objectGeometry = object.objectGeometry->getLOD(level);
+	}
+}
+
+// Lights that are off, or that can't reach anything the camera sees, are left out.
+// If there are still more than the shaders can take, the closest ones to the camera are kept.
+void EntityManager::snapshotLights(SceneSnapshot& scene, const Frustum& frustum, float interpolation)
+{
+	scene.lights.clear();
+
+	for(auto& light : mLights)
+	{
+		if(!light->isOn() || light->getPower() <= 0.0f)
+			continue;
+
+		LightSnapshot lightSnapshot;
+		lightSnapshot.position = light->getPhysicsBody().getInterpolatedPosition(interpolation) * PHYSICS_PIXELS_PER_METER; // Like objects and the camera
+		lightSnapshot.diffuseColor = light->getDiffuseColor();
+		lightSnapshot.specularColor = light->getSpecularColor();
+		lightSnapshot.power = light->getPower();
+
+		// Light fades with the square of the distance, past this it is too dim to matter.
+		// Same units as the shaders (power / squared world distance), so the range is in world units too.
+		float range = std::sqrt(lightSnapshot.power / LIGHT_MIN_INTENSITY);
+		unsigned char result;
+
+		frustum.classifySpheres(&lightSnapshot.position.x, &lightSnapshot.position.y, &lightSnapshot.position.z, &range, 1, &result);
+
+		if(result != FRUSTUM_OUTSIDE)
+			scene.lights.push_back(lightSnapshot);
+	}
+
+	if(scene.lights.size() > LIGHT_MAX_COUNT)
+	{
+		glm::vec3 cameraPosition = glm::vec3(glm::inverse(scene.viewMatrix)[3]);
+
+		std::nth_element(scene.lights.begin(), scene.lights.begin() + LIGHT_MAX_COUNT, scene.lights.end(),
+			[&cameraPosition](const LightSnapshot& first, const LightSnapshot& second)
+		{
+			glm::vec3 firstDistance = first.position - cameraPosition;
+			glm::vec3 secondDistance = second.position - cameraPosition;
+
+			return glm::dot(firstDistance, firstDistance) < glm::dot(secondDistance, secondDistance);
+		});
+
+		scene.lights.resize(LIGHT_MAX_COUNT);
+	}
+}
+
+// Draws the physics shapes of all objects, see DebugRenderer
+// The shader is like basic.v.glsl (MVP and color)
+void EntityManager::setDebugShapesVisible(bool visible)
+{
+	mDebugShapesVisible = visible;
+}
+
+bool EntityManager::areDebugShapesVisible()
+{
+	return mDebugShapesVisible;
+}
+
+void EntityManager::setDebugShapeShader(Object::constShaderPointer shader)
+{
+	mDebugShapeShader = shader;
+}
+
+void EntityManager::setFrustumCulling(bool frustumCulling)
+{
+	mFrustumCulling = frustumCulling;
+}
+
+bool EntityManager::isFrustumCulling()
+{
+	return mFrustumCulling;
+}
+
+int EntityManager::getVisibleObjectCount()
+{
+	return mVisibleObjectCount;
+}
+
+int EntityManager::getCulledObjectCount()
+{
+	return mCulledObjectCount;
+}
+
+// Copies everything that can be rendered into the scene, see SceneSnapshot
+// Interpolation goes from 0 (last step) to 1 (current step)
+void EntityManager::snapshot(SceneSnapshot& scene, float interpolation)
 {
-	for(objectVector::iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+	PROFILE_ZONE("EntityManager::snapshot");
+
+	scene.viewMatrix = mGameCamera.getViewMatrix(interpolation);
+	scene.projectionMatrix = mGameCamera.getProjectionMatrix();
+
+	scene.objects.resize(mObjects.size()); // Reuses the memory of the last snapshot
+	mObjectVisibility.resize(mObjects.size());
+	mObjectLODLevels.resize(mObjects.size(), 0); // Objects added or removed since the last snapshot might start at another's level, it is fixed right away
+
+	// Once per frame
+	glm::mat4 viewProjectionMatrix = scene.projectionMatrix * scene.viewMatrix;
+	Frustum frustum(viewProjectionMatrix);
+
+	glm::vec3 cameraPosition = glm::vec3(glm::inverse(scene.viewMatrix)[3]);
+	float LODSizeScale = scene.projectionMatrix[1][1] * std::pow(2.0f, -mGameCamera.getLODBias()); // A bias of 1 is one level less detailed
+
+	// Objects only read themselves here, so they can be split between the workers
+	JobSystem::parallelFor(0, static_cast<int>(mObjects.size()), JOB_SYSTEM_SNAPSHOT_GRAIN_SIZE,
+		[this, &scene, interpolation, &viewProjectionMatrix, &frustum, &cameraPosition, LODSizeScale](int begin, int end)
 	{
-		(*it)->render(mGameCamera);
+		TransformBatch transforms;
+		BoundingSpheres spheres;
+
+		// In small batches, so the transforms and bounding spheres stay on the stack
+		for(int batchBegin = begin; batchBegin < end; batchBegin += SNAPSHOT_BATCH_SIZE)
+		{
+			int batchEnd = std::min(batchBegin + SNAPSHOT_BATCH_SIZE, end);
+
+			transforms.clear();
+
+			for(int i = batchBegin; i < batchEnd; i++)
+			{
+				const PhysicsBody& body = mObjects[i]->getPhysicsBody();
+
+				mObjects[i]->snapshot(scene.objects[i], interpolation);
+				transforms.add(body.getInterpolatedPosition(interpolation), body.getInterpolatedRotation(interpolation), body.getScaling());
+			}
+
+			transforms.compute(viewProjectionMatrix, &scene.objects[batchBegin]);
+
+			computeBoundingSpheres(scene, batchBegin, batchEnd, spheres);
+			cullObjects(scene, frustum, batchBegin, batchEnd, spheres);
+			selectLODs(scene, batchBegin, batchEnd, spheres, cameraPosition, LODSizeScale);
+		}
+	});
+
+	// Keep the visible ones, in the same order
+	std::size_t visibleCount = 0;
+
+	for(std::size_t i = 0; i < scene.objects.size(); i++)
+	{
+		if(!mObjectVisibility[i])
+			continue;
+
+		if(visibleCount != i)
+			scene.objects[visibleCount] = std::move(scene.objects[i]);
+
+		// After picking the LOD, and on this thread: compacting happens here too, so this place is covered by the frame's resource fence
+		scene.objects[visibleCount].arenaLocation = scene.objects[visibleCount].objectGeometry->getArenaLocation();
+
+		visibleCount++;
+	}
+
+	mVisibleObjectCount = static_cast<int>(visibleCount);
+	mCulledObjectCount = static_cast<int>(scene.objects.size() - visibleCount);
+
+	scene.objects.resize(visibleCount);
+
+	snapshotLights(scene, frustum, interpolation);
+
+	PhysicsBody::copyQueuedDebugLines(scene.debugLines, scene.debugLineShader);
+
+	// Every object at once, instead of scripts asking for each of them during each step
+	if(mDebugShapesVisible && mDebugShapeShader)
+	{
+		for(auto& object : mObjects)
+		{
+			const PhysicsBody& body = object->getPhysicsBody();
+			body.appendDebugLines(scene.debugLines, body.getInterpolatedPosition(interpolation).y, interpolation);
+		}
+
+		scene.debugLineShader = mDebugShapeShader;
 	}
 }
\ No newline at end of file
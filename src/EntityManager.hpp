@@ -23,6 +23,10 @@
 #include <Object.hpp>
 #include <Light.hpp>
 #include <Camera.hpp>
+#include <SceneSnapshot.hpp>
+#include <Frustum.hpp>
+#include <TransformBatch.hpp>
+#include <Definitions.hpp>
 
 #include <Box2D.h>
 #include <glm/glm.hpp>
@@ -51,6 +55,33 @@ private:
 	int mPhysicsVelocityIterations;
 	int mPhysicsPositionIterations;
 
+	// Frustum culling, see snapshot()
+	bool mFrustumCulling;
+	std::vector<unsigned char> mObjectVisibility; // Per object, for the last snapshot
+	int mVisibleObjectCount;
+	int mCulledObjectCount;
+
+	// Level of detail of each object, kept for the next snapshot (see selectLODs())
+	std::vector<unsigned char> mObjectLODLevels;
+
+	// Of a batch of objects in a snapshot, in world space
+	struct BoundingSpheres
+	{
+		float x[SNAPSHOT_BATCH_SIZE];
+		float y[SNAPSHOT_BATCH_SIZE];
+		float z[SNAPSHOT_BATCH_SIZE];
+		float radius[SNAPSHOT_BATCH_SIZE];
+	};
+
+	// See setDebugShapesVisible()
+	bool mDebugShapesVisible;
+	Object::constShaderPointer mDebugShapeShader;
+
+	static void computeBoundingSpheres(const SceneSnapshot& scene, int begin, int end, BoundingSpheres& spheres);
+	void cullObjects(const SceneSnapshot& scene, const Frustum& frustum, int begin, int end, const BoundingSpheres& spheres);
+	void selectLODs(SceneSnapshot& scene, int begin, int end, const BoundingSpheres& spheres, glm::vec3 cameraPosition, float sizeScale);
+	void snapshotLights(SceneSnapshot& scene, const Frustum& frustum, float interpolation);
+
 public:
 	EntityManager(glm::vec2 gravity, float physicsTimePerStep);
 	~EntityManager();
@@ -70,8 +101,17 @@ public:
 	void setPhysicsTimePerStep(float time);
 	float getPhysicsTimePerStep();
 
-	void step(float divider);
-	void render();
+	void setDebugShapesVisible(bool visible);
+	bool areDebugShapesVisible();
+	void setDebugShapeShader(Object::constShaderPointer shader);
+
+	void setFrustumCulling(bool frustumCulling);
+	bool isFrustumCulling();
+	int getVisibleObjectCount(); // In the last snapshot
+	int getCulledObjectCount();
+
+	void step();
+	void snapshot(SceneSnapshot& scene, float interpolation);
 };
 
 #endif /* ENTITY_MANAGER_HPP */
\ No newline at end of file
@@ -0,0 +1,247 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <FramePacer.hpp>
+
+#include <Definitions.hpp>
+#include <Utils.hpp>
+#include <Profiler.hpp>
+#include <SimpleTimer.hpp>
+
+#include <algorithm> // For std::min() and std::max()
+#include <cmath> // For std::sqrt()
+#include <string>
+#include <thread>
+
+FramePacer::FramePacer()
+	: mHistogram(FRAME_PACER_HISTOGRAM_BUCKETS, 0)
+{
+	mFrameLength = 1000000000 / DEFAULT_GAME_MAX_FRAMES_PER_SECOND;
+	mNextDeadline = 0;
+	mSleepOvershoot = FRAME_PACER_INITIAL_SLEEP_OVERSHOOT;
+
+	mLastFrameEnd = 0;
+	mFrameCount = 0;
+	mFrameTimeSum = 0.0;
+	mFrameTimeSquaredSum = 0.0;
+}
+
+// Sleeps most of the time, then spins for the last bit
+void FramePacer::sleepUntil(Uint64 deadline)
+{
+	while(true)
+	{
+		Uint64 now = SimpleTimer::getCurrentNanoseconds();
+
+		if(now >= deadline)
+			break;
+
+		Uint64 remaining = deadline - now;
+		Uint64 spinLength = std::max<Uint64>(mSleepOvershoot, FRAME_PACER_MIN_SPIN);
+
+		if(remaining <= spinLength + 1000000) // Less than 1 ms to sleep, SDL_Delay() can't do that
+		{
+			std::this_thread::yield(); // Still lets other threads (render thread, workers) run
+			continue;
+		}
+
+		Uint32 sleepLength = static_cast<Uint32>((remaining - spinLength) / 1000000); // Truncation, in miliseconds
+		SDL_Delay(sleepLength);
+
+		// Learn how late we wake up. Goes up right away, and back down slowly so one good sleep doesn't make us miss the next deadlines.
+		Uint64 slept = SimpleTimer::getCurrentNanoseconds() - now;
+		Uint64 overshoot = (slept > sleepLength * 1000000ull) ? slept - sleepLength * 1000000ull : 0;
+
+		mSleepOvershoot = std::max(overshoot, mSleepOvershoot - mSleepOvershoot / 16);
+		mSleepOvershoot = std::min<Uint64>(mSleepOvershoot, FRAME_PACER_MAX_SPIN); // Never burn more than that
+	}
+}
+
+void FramePacer::recordFrame(Uint64 frameEnd)
+{
+	if(mLastFrameEnd != 0)
+	{
+		Uint64 frameTime = frameEnd - mLastFrameEnd;
+		std::size_t bucket = std::min<Uint64>(frameTime / FRAME_PACER_HISTOGRAM_BUCKET_LENGTH, FRAME_PACER_HISTOGRAM_BUCKETS - 1);
+
+		mHistogram[bucket]++;
+		mFrameCount++;
+
+		double frameTimeMs = static_cast<double>(frameTime) / 1000000.0;
+		mFrameTimeSum += frameTimeMs;
+		mFrameTimeSquaredSum += frameTimeMs * frameTimeMs;
+	}
+
+	mLastFrameEnd = frameEnd;
+}
+
+void FramePacer::setMaxFramesPerSecond(int maxFPS)
+{
+	if(maxFPS < 0)
+	{
+		Utils::WARN("Max frames per second cannot be negative, use 0 for no cap!");
+		return;
+	}
+
+	setFrameLength(maxFPS > 0 ? 1000000000 / maxFPS : 0);
+}
+
+void FramePacer::setFrameLength(Uint64 frameLength)
+{
+	if(frameLength == mFrameLength)
+		return;
+
+	mFrameLength = frameLength;
+	mNextDeadline = 0; // Start over with the new length
+}
+
+Uint64 FramePacer::getFrameLength() const
+{
+	return mFrameLength;
+}
+
+void FramePacer::waitForNextFrame()
+{
+	if(mFrameLength > 0)
+	{
+		PROFILE_ZONE("Frame pacing");
+
+		Uint64 now = SimpleTimer::getCurrentNanoseconds();
+
+		// First frame, or more than a frame late (breakpoint, loading...): start over from now.
+		// A bit late is fine, the next frame will be a bit shorter to get back on schedule.
+		if(mNextDeadline == 0 || now >= mNextDeadline + mFrameLength)
+			mNextDeadline = now;
+		else
+			sleepUntil(mNextDeadline);
+
+		mNextDeadline += mFrameLength;
+	}
+
+	recordFrame(SimpleTimer::getCurrentNanoseconds());
+}
+
+void FramePacer::reset()
+{
+	mNextDeadline = 0;
+	mLastFrameEnd = 0; // Don't put the pause in the histogram
+}
+
+// Static
+// Adaptive VSync ("late swap tearing") waits for the screen like normal VSync, but swaps right away when
+// a frame is late. A slightly late frame then tears a bit instead of waiting a whole refresh (60 -> 30 FPS).
+// Not all drivers support it, fall back to normal VSync then.
+int FramePacer::setupVSync(bool enabled)
+{
+	if(!enabled)
+	{
+		SDL_GL_SetSwapInterval(0);
+		return 0;
+	}
+
+	if(SDL_GL_SetSwapInterval(-1) == 0)
+		return -1;
+
+	if(SDL_GL_SetSwapInterval(1) == 0)
+	{
+		Utils::LOGPRINT("Adaptive VSync is not supported, using normal VSync.");
+		return 1;
+	}
+
+	Utils::WARN("Cannot turn on VSync! SDL error: " + std::string(SDL_GetError()));
+	return 0;
+}
+
+int FramePacer::getFrameCount() const
+{
+	return static_cast<int>(mFrameCount);
+}
+
+float FramePacer::getAverageFrameTime() const
+{
+	if(mFrameCount == 0)
+		return 0.0f;
+
+	return static_cast<float>(mFrameTimeSum / mFrameCount);
+}
+
+float FramePacer::getFrameTimeJitter() const
+{
+	if(mFrameCount == 0)
+		return 0.0f;
+
+	double average = mFrameTimeSum / mFrameCount;
+	double variance = mFrameTimeSquaredSum / mFrameCount - average * average;
+
+	return static_cast<float>(std::sqrt(std::max(variance, 0.0))); // Rounding can make it slightly negative
+}
+
+float FramePacer::getFrameTimePercentile(float percentile) const
+{
+	if(mFrameCount == 0)
+		return 0.0f;
+
+	percentile = std::max(0.0f, std::min(percentile, 100.0f));
+	Uint64 wantedCount = static_cast<Uint64>(std::ceil(percentile / 100.0 * mFrameCount));
+	Uint64 count = 0;
+
+	for(std::size_t i = 0; i < mHistogram.size(); i++)
+	{
+		count += mHistogram[i];
+
+		if(count >= wantedCount && count > 0)
+			return static_cast<float>((i + 1) * FRAME_PACER_HISTOGRAM_BUCKET_LENGTH) / 1000000.0f;
+	}
+
+	return static_cast<float>(mHistogram.size() * FRAME_PACER_HISTOGRAM_BUCKET_LENGTH) / 1000000.0f;
+}
+
+void FramePacer::clearHistogram()
+{
+	std::fill(mHistogram.begin(), mHistogram.end(), 0);
+	mFrameCount = 0;
+	mFrameTimeSum = 0.0;
+	mFrameTimeSquaredSum = 0.0;
+	mLastFrameEnd = 0;
+}
+
+// Only the buckets that have frames, so the log stays short
+void FramePacer::logHistogram() const
+{
+	if(mFrameCount == 0)
+		return;
+
+	Utils::LOGPRINT("Frame times over " + std::to_string(mFrameCount) + " frames: average " + std::to_string(getAverageFrameTime()) +
+		" ms, jitter " + std::to_string(getFrameTimeJitter()) + " ms, p50 " + std::to_string(getFrameTimePercentile(50.0f)) +
+		" ms, p99 " + std::to_string(getFrameTimePercentile(99.0f)) + " ms.");
+
+	for(std::size_t i = 0; i < mHistogram.size(); i++)
+	{
+		if(mHistogram[i] == 0)
+			continue;
+
+		float bucketStart = static_cast<float>(i * FRAME_PACER_HISTOGRAM_BUCKET_LENGTH) / 1000000.0f;
+		float share = 100.0f * mHistogram[i] / mFrameCount;
+
+		std::string range = (i + 1 < mHistogram.size()) ?
+			std::to_string(bucketStart) + " ms" : std::to_string(bucketStart) + " ms and more";
+
+		Utils::LOGPRINT("  " + range + ": " + std::to_string(mHistogram[i]) + " frames (" + std::to_string(share) + "%)");
+	}
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Waits until the next frame should start, precisely enough for 60/120/144 Hz.
+// SDL_Delay() only has 1 ms granularity and often wakes up late, so the pacer sleeps until shortly before
+// the deadline, then spins (yielding) for the rest. The spin margin follows how late SDL_Delay() usually is,
+// so it stays short on systems with a good scheduler.
+//
+// Deadlines are spaced by exactly one frame length instead of being counted from the end of the last wait,
+// so frames don't slowly drift. When a frame is more than one frame late, the pacer starts over instead of catching up.
+//
+// Also keeps a histogram of frame times, see logHistogram().
+
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <SDL.h>
+
+#include <vector>
+
+class FramePacer
+{
+private:
+	Uint64 mFrameLength; // In nanoseconds, 0 for no cap
+	Uint64 mNextDeadline; // When the current frame should end, 0 if not started
+	Uint64 mSleepOvershoot; // How late SDL_Delay() usually wakes up, in nanoseconds. We spin at least that long.
+
+	Uint64 mLastFrameEnd; // For the histogram, 0 if no frame was done yet
+	std::vector<Uint32> mHistogram; // Frame counts, FRAME_PACER_HISTOGRAM_BUCKET_LENGTH wide buckets. The last one also has all longer frames.
+	Uint32 mFrameCount;
+	double mFrameTimeSum; // In miliseconds, for the average and jitter
+	double mFrameTimeSquaredSum;
+
+	void sleepUntil(Uint64 deadline);
+	void recordFrame(Uint64 frameEnd);
+
+public:
+	FramePacer();
+
+	void setMaxFramesPerSecond(int maxFPS); // 0 for no cap
+	void setFrameLength(Uint64 frameLength); // In nanoseconds, 0 for no cap
+	Uint64 getFrameLength() const;
+
+	void waitForNextFrame(); // Call once at the end of each frame
+	void reset(); // Next frame starts now, use after long pauses (loading...)
+
+	static int setupVSync(bool enabled); // Call with the context current. Returns the swap interval that was set.
+
+	// Times are in miliseconds
+	int getFrameCount() const;
+	float getAverageFrameTime() const;
+	float getFrameTimeJitter() const; // Standard deviation
+	float getFrameTimePercentile(float percentile) const; // Upper end of the bucket, percentile is from 0 to 100
+
+	void clearHistogram();
+	void logHistogram() const;
+};
+
+#endif /* FRAME_PACER_HPP */
\ No newline at end of file
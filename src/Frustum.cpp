@@ -0,0 +1,165 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <Frustum.hpp>
+
+#include <Definitions.hpp>
+
+#include <cmath> // For std::abs()
+
+// x86-64 always has SSE, 32-bit x86 only if the compiler was told so
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define FRUSTUM_USE_SSE
+	#include <xmmintrin.h>
+#endif
+
+Frustum::Frustum()
+{
+	setMatrix(glm::mat4(1.0f)); // The -1 to 1 cube
+}
+
+Frustum::Frustum(const glm::mat4& viewProjectionMatrix)
+{
+	setMatrix(viewProjectionMatrix);
+}
+
+// A point is inside when each of its clip coordinates is between -w and w.
+// Each of these comparisons is a plane, made of the matrix's last row plus or minus another row.
+void Frustum::setMatrix(const glm::mat4& viewProjectionMatrix)
+{
+	const glm::mat4& m = viewProjectionMatrix;
+
+	// glm is column major: m[column][row]
+	glm::vec4 rowX(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 rowY(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 rowZ(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 rowW(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	mPlanes[0] = rowW + rowX; // Left
+	mPlanes[1] = rowW - rowX; // Right
+	mPlanes[2] = rowW + rowY; // Bottom
+	mPlanes[3] = rowW - rowY; // Top
+	mPlanes[4] = rowW + rowZ; // Near
+	mPlanes[5] = rowW - rowZ; // Far
+
+	// Normalized, so distances to the planes are real distances we can compare to radiuses
+	for(int i = 0; i < 6; i++)
+	{
+		float length = glm::length(glm::vec3(mPlanes[i]));
+
+		if(length > 0.0f)
+			mPlanes[i] /= length;
+	}
+}
+
+const glm::vec4& Frustum::getPlane(int plane) const
+{
+	return mPlanes[plane];
+}
+
+void Frustum::classifySpheres(const float* x, const float* y, const float* z, const float* radius, int count, unsigned char* results) const
+{
+	int i = 0;
+
+#ifdef FRUSTUM_USE_SSE
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128 sphereX = _mm_loadu_ps(x + i);
+		__m128 sphereY = _mm_loadu_ps(y + i);
+		__m128 sphereZ = _mm_loadu_ps(z + i);
+		__m128 sphereRadius = _mm_loadu_ps(radius + i);
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), sphereRadius);
+
+		__m128 outside = _mm_setzero_ps(); // All bits set where a sphere is behind a plane
+		__m128 inside = _mm_cmpeq_ps(sphereX, sphereX); // All bits set where a sphere is in front of every plane so far (NaN never is)
+
+		for(int p = 0; p < 6; p++)
+		{
+			const glm::vec4& plane = mPlanes[p];
+
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(sphereX, _mm_set1_ps(plane.x)), _mm_mul_ps(sphereY, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(sphereZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, sphereRadius));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		int insideMask = _mm_movemask_ps(inside);
+
+		for(int j = 0; j < 4; j++)
+		{
+			if(outsideMask & (1 << j))
+				results[i + j] = FRUSTUM_OUTSIDE;
+			else if(insideMask & (1 << j))
+				results[i + j] = FRUSTUM_INSIDE;
+			else
+				results[i + j] = FRUSTUM_INTERSECTS;
+		}
+	}
+#endif
+
+	// What is left (or everything without SSE)
+	for(; i < count; i++)
+	{
+		unsigned char result = FRUSTUM_INSIDE;
+
+		for(int p = 0; p < 6; p++)
+		{
+			const glm::vec4& plane = mPlanes[p];
+			float distance = plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w;
+
+			if(distance < -radius[i])
+			{
+				result = FRUSTUM_OUTSIDE;
+				break;
+			}
+
+			if(distance < radius[i])
+				result = FRUSTUM_INTERSECTS;
+		}
+
+		results[i] = result;
+	}
+}
+
+// The box's half extents projected on each plane's normal give how far it reaches towards the plane
+bool Frustum::isBoxVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& modelMatrix) const
+{
+	glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+	glm::vec3 halfExtents = (boundsMax - boundsMin) * 0.5f;
+
+	glm::vec3 axisX = glm::vec3(modelMatrix[0]) * halfExtents.x;
+	glm::vec3 axisY = glm::vec3(modelMatrix[1]) * halfExtents.y;
+	glm::vec3 axisZ = glm::vec3(modelMatrix[2]) * halfExtents.z;
+
+	for(int p = 0; p < 6; p++)
+	{
+		glm::vec3 normal(mPlanes[p]);
+
+		float distance = glm::dot(normal, center) + mPlanes[p].w;
+		float reach = std::abs(glm::dot(normal, axisX)) + std::abs(glm::dot(normal, axisY)) + std::abs(glm::dot(normal, axisZ));
+
+		if(distance < -reach)
+			return false;
+	}
+
+	return true;
+}
\ No newline at end of file
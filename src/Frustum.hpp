@@ -0,0 +1,50 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// The six planes of what a camera sees, for throwing away objects that can't be on screen (culling).
+// Planes are taken straight from projection * view (Gribb & Hartmann), so they follow the field of view and clipping distances.
+//
+// Spheres are tested 4 at a time with SSE when the compiler has it. Give them as separate arrays (x[], y[], z[], radius[])
+// instead of an array of vec4s, so each SSE register holds the same value for 4 spheres.
+
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <glm/glm.hpp>
+
+class Frustum
+{
+private:
+	glm::vec4 mPlanes[6]; // Normal (xyz) points inside, w is the distance. Normalized.
+
+public:
+	Frustum();
+	explicit Frustum(const glm::mat4& viewProjectionMatrix);
+
+	void setMatrix(const glm::mat4& viewProjectionMatrix);
+	const glm::vec4& getPlane(int plane) const;
+
+	// Writes FRUSTUM_OUTSIDE, FRUSTUM_INSIDE or FRUSTUM_INTERSECTS for each sphere
+	void classifySpheres(const float* x, const float* y, const float* z, const float* radius, int count, unsigned char* results) const;
+
+	// Model space box transformed by the model matrix, tighter than a sphere for long objects
+	bool isBoxVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& modelMatrix) const;
+};
+
+#endif /* FRUSTUM_HPP */
\ No newline at end of file
@@ -23,13 +23,22 @@
 
 // Every function that calls OpenGL stuff must call bind() first
 
+// In headless mode there is no OpenGL context, so the data is simply kept in a vector instead.
+// Reading from the buffer still works, which physics shapes need.
+// Buffers that are read often can keep the same copy next to the OpenGL buffer (see setKeepsCPUCopy()),
+// glGetBufferSubData() has to wait for the GPU to be done with everything before it.
+// The size is always remembered, so getSize() and getLength() never ask the driver.
+
 #ifndef GPU_BUFFER_HPP
 #define GPU_BUFFER_HPP
 
 #include <glad/glad.h> // glad.h is compatible with C++
 #include <vector>
+#include <algorithm> // For std::copy
 #include <cstddef> // For std::size_t
 
+#include <Utils.hpp> // For headless mode
+
 template<typename bufferDataType>
 class GPUBuffer
 {
@@ -38,19 +47,34 @@ private:
 	bool mAutoBind;
 	GLenum mTarget; // The target to bind to
 
+	bool mIsCPUSide; // True in headless mode, the data is in mCPUData and OpenGL is never called
+	bool mKeepsCPUCopy; // The data is in mCPUData too, read from there
+	std::vector<bufferDataType> mCPUData;
+
+	// Of the last data set, so modify() can orphan mutable buffers
+	std::size_t mDataSize; // In bytes, getSize()
+	GLenum mUsage; // 0 if the storage is immutable
+
 public:
 	// Even if auto binding is not on, calling bind() will still bind to the default target
 	GPUBuffer(GLenum target = GL_ARRAY_BUFFER, bool autoBind = true)
 	{
 		setTarget(target);
 		mAutoBind = autoBind;
-
-		glGenBuffers(1, &mID); // 1 for 1 buffer
+		mIsCPUSide = Utils::isHeadless();
+		mKeepsCPUCopy = false;
+		mID = 0;
+		mDataSize = 0;
+		mUsage = GL_DYNAMIC_DRAW;
+
+		if(!mIsCPUSide)
+			glGenBuffers(1, &mID); // 1 for 1 buffer
 	}
 
 	~GPUBuffer()
 	{
-		glDeleteBuffers(1, &mID);
+		if(!mIsCPUSide)
+			glDeleteBuffers(1, &mID);
 	}
 
 	// Copy constructor, makes a new OpenGL buffer. Unbinds copy buffers!
@@ -61,15 +85,22 @@ public:
 
 		mAutoBind = other.mAutoBind;
 		setTarget(other.mTarget);
+		mIsCPUSide = other.mIsCPUSide;
+		mKeepsCPUCopy = other.mKeepsCPUCopy;
+		mID = 0;
+		mDataSize = other.mDataSize;
+		mUsage = other.mUsage;
+
+		if(mIsCPUSide)
+		{
+			mCPUData = other.mCPUData;
+			return;
+		}
 		
 		glGenBuffers(1, &mID);
 
-		// Code to make sure the data and the flags are the same
-		GLint isImmutable;
-		other.bind();
-		glGetBufferParameteriv(other.mTarget, GL_BUFFER_IMMUTABLE_STORAGE, &isImmutable);
-		
-		if(isImmutable)
+		// Code to make sure the data and the flags are the same. read() uses the other's copy if it has one.
+		if(other.mUsage == 0) // Immutable
 		{
 			GLint immutableFlags;
 			other.bind();
@@ -78,15 +109,11 @@ public:
 			setImmutableData(other.read(), immutableFlags);
 		} else
 		{
-			GLint usage;
-			other.bind();
-			glGetBufferParameteriv(other.mTarget, GL_BUFFER_USAGE, &usage);
-
-			setMutableData(other.read(), usage);
+			setMutableData(other.read(), other.mUsage);
 		}
 	}
 
-	const GLuint getID()
+	GLuint getID() const
 	{
 		return mID;
 	}
@@ -96,9 +123,39 @@ public:
 		mTarget = target;
 	}
 
+	bool isCPUSide() const
+	{
+		return mIsCPUSide;
+	}
+
+	// Keeps the data in memory only, like in headless mode. OpenGL is never called again. Call before setting the data.
+	void setCPUSide()
+	{
+		if(mIsCPUSide)
+			return;
+
+		glDeleteBuffers(1, &mID);
+		mID = 0;
+		mIsCPUSide = true;
+	}
+
+	// Call before setting the data. Costs the memory of the data, but reading is free.
+	void setKeepsCPUCopy(bool keepsCPUCopy)
+	{
+		mKeepsCPUCopy = keepsCPUCopy;
+
+		if(!mKeepsCPUCopy && !mIsCPUSide)
+			std::vector<bufferDataType>().swap(mCPUData); // Actually free it
+	}
+
+	bool keepsCPUCopy() const
+	{
+		return mKeepsCPUCopy || mIsCPUSide;
+	}
+
 	void bind(GLenum target) const
 	{
-		if(mAutoBind)
+		if(mAutoBind && !mIsCPUSide)
 			glBindBuffer(target, mID);
 	}
 
@@ -109,12 +166,10 @@ public:
 
 	std::size_t getSize() const // Returns the buffer's size, in bytes
 	{
-		GLint GLintBufferSize;
-
-		bind();
-		glGetBufferParameteriv(mTarget, GL_BUFFER_SIZE, &GLintBufferSize);
+		if(mIsCPUSide)
+			return Utils::getSizeOfVectorData(mCPUData);
 
-		return GLintBufferSize; // Implicit conversion to std::size_t
+		return mDataSize; // Same as GL_BUFFER_SIZE, without asking
 	}
 
 	int getLength() const // Get the amount of elements in the buffer
@@ -126,10 +181,21 @@ public:
 
 	void setMutableData(const std::vector<bufferDataType>& data, GLenum usage)
 	{
+		if(mIsCPUSide)
+		{
+			mCPUData = data;
+			return;
+		}
+
+		if(mKeepsCPUCopy)
+			mCPUData = data;
+
 		bind();
 
 		// Vector.size() returns the amount of elements
-		glBufferData(mTarget, sizeof(bufferDataType) * data.size(), data.data(), usage);
+		mDataSize = sizeof(bufferDataType) * data.size();
+		mUsage = usage;
+		glBufferData(mTarget, mDataSize, data.data(), usage);
 	}
 
 	// Uses defaut usage, easier Lua binding have a function overload to do it
@@ -141,8 +207,20 @@ public:
 
 	void setImmutableData(const std::vector<bufferDataType>& data, GLenum immutableFlags) // immutableFlags being a bitwise operation
 	{
+		if(mIsCPUSide)
+		{
+			mCPUData = data;
+			return;
+		}
+
+		if(mKeepsCPUCopy)
+			mCPUData = data;
+
 		bind();
-		glBufferStorage(mTarget, sizeof(bufferDataType) * data.size(), data.data(), immutableFlags);
+
+		mDataSize = sizeof(bufferDataType) * data.size();
+		mUsage = 0;
+		glBufferStorage(mTarget, mDataSize, data.data(), immutableFlags);
 	}
 
 	// Easier Lua binding, see setMutableData(data)
@@ -154,6 +232,15 @@ public:
 
 	std::vector<bufferDataType> read(GLintptr offset, GLsizeiptr size) const
 	{
+		if(mIsCPUSide || mKeepsCPUCopy)
+		{
+			// Offset and size are in bytes, like OpenGL
+			std::size_t first = (std::min)(static_cast<std::size_t>(offset) / sizeof(bufferDataType), mCPUData.size());
+			std::size_t last = (std::min)(first + static_cast<std::size_t>(size) / sizeof(bufferDataType), mCPUData.size());
+
+			return std::vector<bufferDataType>(mCPUData.begin() + first, mCPUData.begin() + last);
+		}
+
 		bind();
 		std::vector<bufferDataType> data(size / sizeof(bufferDataType)); // Allocate
 		glGetBufferSubData(mTarget, offset, size, data.data());
@@ -167,12 +254,41 @@ public:
 		return read(0, getSize());
 	}
 
+	// No copy, but empty if the buffer doesn't keep the data (see keepsCPUCopy())
+	const std::vector<bufferDataType>& getCPUData() const
+	{
+		return mCPUData;
+	}
+
 	// If the buffer is immutable, make sure you gave the right immutableFlags to make it changeable
 	// Will replace the bytes starting at offset
+	// Replacing all of a mutable buffer orphans it: glBufferSubData() would wait for the GPU to be done drawing the old data.
+	// Data rewritten every frame should rather go in a StreamingBuffer.
 	void modify(GLintptr offset, const std::vector<bufferDataType>& data)
 	{
+		if(mIsCPUSide || mKeepsCPUCopy)
+		{
+			std::size_t first = static_cast<std::size_t>(offset) / sizeof(bufferDataType);
+
+			if(first + data.size() > mCPUData.size()) // OpenGL would give an error here too
+			{
+				Utils::WARN("Cannot modify buffer past its end!");
+				return;
+			}
+
+			std::copy(data.begin(), data.end(), mCPUData.begin() + first);
+
+			if(mIsCPUSide)
+				return;
+		}
+
 		bind();
-		glBufferSubData(mTarget, offset, sizeof(bufferDataType) * data.size(), data.data());
+		std::size_t size = sizeof(bufferDataType) * data.size();
+
+		if(offset == 0 && size == mDataSize && mUsage != 0)
+			glBufferData(mTarget, size, data.data(), mUsage); // New memory, same name, VAOs using it are fine
+		else
+			glBufferSubData(mTarget, offset, size, data.data());
 	}
 
 };
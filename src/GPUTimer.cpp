@@ -0,0 +1,86 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <GPUTimer.hpp>
+
+GPUTimer::GPUTimer()
+{
+	for(int i = 0; i < GPU_TIMER_QUERY_COUNT; i++)
+	{
+		mQueries[i] = 0;
+		mIsPending[i] = false;
+	}
+
+	mNextQuery = 0;
+
+	mIsTiming = false;
+	mLastTime = 0;
+}
+
+// Oldest first, so the last time is always the newest one ready
+void GPUTimer::readResults()
+{
+	for(int i = 0; i < GPU_TIMER_QUERY_COUNT; i++)
+	{
+		int index = (mNextQuery + i) % GPU_TIMER_QUERY_COUNT;
+
+		if(!mIsPending[index])
+			continue;
+
+		GLint isAvailable = GL_FALSE;
+		glGetQueryObjectiv(mQueries[index], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+
+		if(!isAvailable)
+			break; // Newer ones won't be ready either
+
+		glGetQueryObjectui64v(mQueries[index], GL_QUERY_RESULT, &mLastTime);
+		mIsPending[index] = false;
+	}
+}
+
+void GPUTimer::begin()
+{
+	if(mQueries[0] == 0) // First time, on the right context
+		glGenQueries(GPU_TIMER_QUERY_COUNT, mQueries);
+
+	readResults();
+
+	if(mIsPending[mNextQuery]) // The GPU is more than GPU_TIMER_QUERY_COUNT frames behind, skip this one
+		return;
+
+	glBeginQuery(GL_TIME_ELAPSED, mQueries[mNextQuery]);
+	mIsTiming = true;
+}
+
+void GPUTimer::end()
+{
+	if(!mIsTiming)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+
+	mIsPending[mNextQuery] = true;
+	mNextQuery = (mNextQuery + 1) % GPU_TIMER_QUERY_COUNT;
+	mIsTiming = false;
+}
+
+GLuint64 GPUTimer::getLastTime() const
+{
+	return mLastTime;
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Measures how long the GPU takes to draw a frame, with GL_TIME_ELAPSED queries.
+// Results come a few frames late, so there are a few queries in a ring and they are only read once ready:
+// waiting for them would stall the CPU until the GPU catches up, which is the opposite of what we want.
+//
+// Queries aren't shared between contexts, like RenderTarget it lives on the context that draws.
+
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include <Definitions.hpp>
+
+#include <glad/glad.h>
+
+class GPUTimer
+{
+private:
+	GLuint mQueries[GPU_TIMER_QUERY_COUNT];
+	bool mIsPending[GPU_TIMER_QUERY_COUNT]; // Ended but not read yet
+	int mNextQuery;
+
+	bool mIsTiming; // Between begin() and end()
+	GLuint64 mLastTime; // In nanoseconds, 0 if nothing was measured yet
+
+	void readResults();
+
+public:
+	GPUTimer();
+
+	void begin(); // Only one at a time, time queries can't be nested
+	void end();
+
+	GLuint64 getLastTime() const;
+};
+
+#endif /* GPU_TIMER_HPP */
\ No newline at end of file
@@ -18,7 +18,7 @@
 ///////////////////////////////////////////////////////////////////////
 
 // UNITS:
-// Frame related stuff: miliseconds
+// Frame related stuff: nanoseconds (miliseconds for the frame cap)
 // Other times: seconds
 // Coords: meters
 // Angles: degrees
@@ -28,11 +28,14 @@
 #include <Definitions.hpp> 
 #include <Utils.hpp>
 #include <SimpleTimer.hpp> // For game loop
+#include <Profiler.hpp>
+#include <JobSystem.hpp>
 
 #include <LuaRef.h> // For getting references from scripts
 #include <SDL_mixer.h>
 
 #include <string> // No .h for c++
+#include <algorithm> // For std::max()
 
 #include <math.h>
 #include <memory> // For smart pointers
@@ -45,21 +48,32 @@
 // http://glew.sourceforge.net/basic.html
 
 Game::Game()
-	: mEntityManager(glm::vec2(0.0f),  1 / static_cast<float>(DEFAULT_GAME_MAX_FRAMES_PER_SECOND))
+	: mEntityManager(glm::vec2(0.0f),  1 / static_cast<float>(DEFAULT_GAME_STEPS_PER_SECOND))
 {
 	mName = DEFAULT_GAME_NAME; // Copy string
 
 	mSize.x = DEFAULT_GAME_WINDOW_WIDTH;
 	mSize.y = DEFAULT_GAME_WINDOW_HEIGHT;
 
-	// Limits the frames per second
-	// Time in miliseconds
-	mMaxFramesPerSecond = DEFAULT_GAME_MAX_FRAMES_PER_SECOND; // Truncation
+	// Limits the frames per second, see updateFramePacing()
+	mMaxFramesPerSecond = DEFAULT_GAME_MAX_FRAMES_PER_SECOND;
+	mVSync = true;
+	mSwapInterval = 0; // Set in init()
 	mLastFrameTime = 0;
 
-	// This is the length of a step, used for movement and everything, in ms. 8 ms makes 120 steps per second.
-	// If the time of one frame is smaller than this value (ex: faster screens in the future), the game will slow down.
-	mStepLength = 8;
+	// This is the length of a step, used for movement and everything, in ns. 120 steps per second makes ~8.3 ms.
+	// Steps are fixed, the time left over from a frame is kept for the next one (see doMainLoop())
+	mStepLength = 1000000000 / DEFAULT_GAME_STEPS_PER_SECOND;
+	mStepAccumulator = 0;
+	mMaxStepsPerFrame = DEFAULT_GAME_MAX_STEPS_PER_FRAME;
+
+	mHeadlessRealTime = false;
+	mMaxSteps = 0; // No limit
+	mStepCount = 0;
+
+	mOffscreen = false;
+	mCaptureInterval = 1;
+	mFrameCount = 0;
 
 	mGraphicsBackgroundColor = glm::vec3(0.0f, 0.0f, 1.0f);
 
@@ -69,6 +83,10 @@ Game::Game()
 	// These will be set later
 	mMainWindow = nullptr;
 	mMainContext = nullptr;
+	mResourceContext = nullptr;
+
+	mJobWorkerCount = JobSystem::getDefaultWorkerCount();
+	mThreadedRendering = true;
 }
 
 Game::~Game() // Deconstructor
@@ -160,14 +178,12 @@ bool Game::checkCompability()
 	}
 }
 
-void Game::setupGraphics() // VAO and OpenGL options
+void Game::setupGraphics() // OpenGL options
 {
 	// Make sure the OpenGL context extends over the whole screen
 	glViewport(0, 0, mSize.x, mSize.y);
 
-	GLuint vertexArrayID; // VAO - vertex array object
-	glGenVertexArrays(1, &vertexArrayID);
-	glBindVertexArray(vertexArrayID);
+	// VAOs belong to each geometry now, see ObjectGeometry::getVertexArray() and RenderQueue
 }
 
 void Game::initMainLoop() // Initialize a few things before the main loop
@@ -192,6 +208,14 @@ void Game::initMainLoop() // Initialize a few things before the main loop
 
 void Game::cleanUp() // Cleans up everything. Call before quitting
 {
+	if(!mProfilerTraceFile.empty())
+		Profiler::exportChromeTrace(mProfilerTraceFile);
+
+	mInputRecorder.stop(mStepCount);
+	JobSystem::stop();
+
+	mFramePacer.logHistogram();
+
 	// Quit
 	// From https://www.libsdl.org/projects/SDL_mixer/docs/SDL_mixer_10.html#SEC10
 	for(int i = 0; i < 1000; i++) // I don't like infinite loops
@@ -204,8 +228,18 @@ void Game::cleanUp() // Cleans up everything. Call before quitting
 
 	Mix_CloseAudio();
 
-	SDL_GL_DeleteContext(mMainContext);
-	SDL_DestroyWindow(mMainWindow);
+	mRenderThread.stop(); // Gives the main context back
+	mSceneSnapshot = SceneSnapshot(); // Drop resources while we have a context
+
+	if(mResourceContext)
+		SDL_GL_DeleteContext(mResourceContext);
+
+	if(mMainContext)
+		SDL_GL_DeleteContext(mMainContext);
+
+	if(mMainWindow)
+		SDL_DestroyWindow(mMainWindow);
+
 	SDL_Quit();
 
 	Utils::LOGPRINT("Game quit successfully.");
@@ -214,10 +248,15 @@ void Game::cleanUp() // Cleans up everything. Call before quitting
 
 void Game::doEvents()
 {
+	PROFILE_ZONE("Game::doEvents");
+
+	bool replaying = mInputRecorder.isReplaying(); // Keys come from the recording then, see step()
+
 	SDL_Event event;
 	while(SDL_PollEvent(&event))
 	{
-		mInputManager.updateKeyByEvent(event);
+		if(!replaying)
+			mInputManager.updateKeyByEvent(event);
 
 		if(event.type == SDL_QUIT)
 			quit();
@@ -226,37 +265,19 @@ void Game::doEvents()
 
 void Game::checkForErrors() // Call each frame for safety. Do not call after deleting the OpenGL context.
 {
-	const int maxGLErrors = 1000;
-	bool finishedGLErrors = false;
+	PROFILE_ZONE("Game::checkForErrors");
 
-	for(int i=0; i<maxGLErrors; i++) // Because meh, I don't like infinite loops
-	{
-		GLenum err = glGetError();
-		
-		if(err!=GL_NO_ERROR) // There is an error
-		{
-			if(err == GL_INVALID_ENUM)
-				Utils::WARN("OpenGL error: GL_INVALID_ENUM");
-			else if(err == GL_INVALID_VALUE)
-				Utils::WARN("OpenGL error: GL_INVALID_VALUE");
-			else if(err == GL_INVALID_OPERATION)
-				Utils::WARN("OpenGL error: GL_INVALID_OPERATION");
-			else if(err == GL_STACK_OVERFLOW)
-				Utils::WARN("OpenGL error: GL_STACK_OVERFLOW");
-			else if(err == GL_STACK_UNDERFLOW)
-				Utils::WARN("OpenGL error: GL_STACK_UNDERFLOW");
-			else if(err == GL_OUT_OF_MEMORY)
-				Utils::WARN("OpenGL error: GL_OUT_OF_MEMORY");
-		} else // No (more) errors!
-		{
-			finishedGLErrors = true;
-			break;
-		}
-	}
+	if(Utils::isHeadless()) // No GL, and SDL will complain about the missing video subsystem
+		return;
+
+	// With a debug callback, the driver tells us about errors, no need to ask it every frame
+	if(Utils::shouldPollGLErrors())
+		Utils::checkForGLErrors(); // Only for the context of this thread, the render thread checks its own
 
-	if(!finishedGLErrors)
-		// Is this even possible?
-		Utils::WARN("Over " + std::to_string(maxGLErrors) + " OpenGL errors?!");
+#ifdef NDEBUG
+	if(Utils::getGLErrorMode() != GRAPHICS_ERROR_MODE_STRICT) // Would only be logged in debug anyway
+		return;
+#endif
 
 	// SDL
 	// Most of the time the error will not be important since it includes internal diagnostics, so don't crash
@@ -264,7 +285,7 @@ void Game::checkForErrors() // Call each frame for safety. Do not call after del
 
 	if(!message.empty())
 	{
-		Utils::LOGPRINT("SDL message (most of the time you can ignore these): " + message);
+		Utils::LOGPRINT_DEBUG("SDL message (most of the time you can ignore these): " + message);
 		SDL_ClearError();
 	}
 }
@@ -274,70 +295,195 @@ float Game::calculateAspectRatio()
 	return (  static_cast<float>(mSize.x) / static_cast<float>(mSize.y)  );
 }
 
-void Game::step(float divider) // Movement and all
+// Of the display the window is on, 0 if unknown
+int Game::getRefreshRate()
 {
-	mEntityManager.step(divider);
+	if(!mMainWindow)
+		return 0;
 
-	// Run the script's step()
-	ResourceManager::scriptPointer mainScript = mResourceManager.findScript(MAIN_SCRIPT_NAME);
-	mainScript->runFunction(MAIN_SCRIPT_FUNCTION_STEP);
+	int displayIndex = SDL_GetWindowDisplayIndex(mMainWindow);
+	SDL_DisplayMode mode;
+
+	if(displayIndex < 0 || SDL_GetDesktopDisplayMode(displayIndex, &mode) != 0)
+		return 0;
+
+	return mode.refresh_rate;
 }
 
-void Game::resetGraphics()
+// With VSync, the swap already waits for the screen. Sleeping on top of it fights it: a frame that wakes up
+// just after the vertical blank waits a whole other refresh, and the game drops from 60 to 30 FPS.
+// So the pacer only caps when we want less frames than the screen shows.
+void Game::updateFramePacing()
 {
-	// Set clear color
-	glClearColor(mGraphicsBackgroundColor.r, mGraphicsBackgroundColor.g, mGraphicsBackgroundColor.b,
-		1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear both color buffers and depth (z-indexes) buffers to push a clean buffer when done
+	if(Utils::isHeadless()) // Steps are paced instead, see doHeadlessLoop()
+		return;
+
+	int refreshRate = getRefreshRate();
+	int maxFramesPerSecond = mMaxFramesPerSecond;
+
+	if(mSwapInterval != 0 && refreshRate > 0 && maxFramesPerSecond >= refreshRate)
+		maxFramesPerSecond = 0;
+
+	mFramePacer.setMaxFramesPerSecond(maxFramesPerSecond);
+}
+
+void Game::step() // Movement and all
+{
+	PROFILE_ZONE("Game::step");
+
+	// Input is recorded and replayed per step, frames aren't the same from one run to another
+	if(mInputRecorder.isReplaying())
+	{
+		if(!mInputRecorder.replayStep(mStepCount, mInputManager))
+		{
+			quit(); // Nothing left to replay
+			return;
+		}
+	} else if(mInputRecorder.isRecording())
+	{
+		mInputRecorder.recordStep(mStepCount, mInputManager);
+	}
+
+	mEntityManager.step();
 
-	// It looks like it's better to call these each frame
-	glEnable(GL_DEPTH_TEST);// Enable depth test (check if z is closer to the screen than last fragement's z)
-	glDepthFunc(GL_LESS); // Accept the fragment closer to the camera
+	// Run the script's step()
+	{
+		PROFILE_ZONE("Lua " MAIN_SCRIPT_FUNCTION_STEP);
 
-	// Cull triangles which normal is not towards the camera
-	// If there are holes in the model because of this, click the "invert normals" button in your 3D modeler.
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	glPolygonMode(GRAPHICS_RASTERIZE_FACE, GRAPHICS_RASTERIZE_MODE);
+		ResourceManager::scriptPointer mainScript = mResourceManager.findScript(MAIN_SCRIPT_NAME);
+		mainScript->runFunction(MAIN_SCRIPT_FUNCTION_STEP);
+	}
+
+	mStepCount++;
+
+	if(mMaxSteps > 0 && mStepCount >= mMaxSteps)
+		quit();
 }
 
-void Game::render()
+void Game::render(float interpolation)
 {
-	mEntityManager.render();
-	SDL_GL_SwapWindow(mMainWindow);
+	mEntityManager.snapshot(mSceneSnapshot, interpolation);
+
+	mSceneSnapshot.viewportSize = mSize;
+	mSceneSnapshot.backgroundColor = mGraphicsBackgroundColor;
+	mSceneSnapshot.offscreen = mOffscreen;
+
+	// GPU times are a few frames late anyway, whichever thread published them
+	if(!mOffscreen)
+		mDynamicResolution.update(RenderQueue::getLastFrameStats().gpuFrameTime);
+
+	mSceneSnapshot.renderSize = mOffscreen ? mSize : mDynamicResolution.getRenderSize(mSize);
+
+	if(!mCapturePrefix.empty() && mFrameCount % mCaptureInterval == 0)
+	{
+		std::string frameNumber = std::to_string(mFrameCount);
+		frameNumber.insert(0, std::max(0, CAPTURE_FRAME_NUMBER_DIGITS - static_cast<int>(frameNumber.size())), '0'); // So they sort
+
+		mSceneSnapshot.captureFile = mCapturePrefix + frameNumber + ".bmp";
+	} else
+	{
+		mSceneSnapshot.captureFile.clear();
+	}
+
+	mFrameCount++;
+
+	if(mRenderThread.isRunning())
+	{
+		// Resources created on our context this frame have to be done before the render thread uses them
+		mSceneSnapshot.resourceFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush(); // Make sure the fence is sent, or the render thread could wait forever
+
+		PROFILE_ZONE("RenderThread::submit"); // Waits if the render thread is still on the last frame
+		mRenderThread.submit(mSceneSnapshot);
+	} else
+	{
+		mSceneSnapshot.render(mRenderQueue);
+
+		if(!mOffscreen) // Nothing was drawn in the window
+		{
+			PROFILE_ZONE("SDL_GL_SwapWindow"); // Waits for VSync, and often for the GPU to catch up
+			SDL_GL_SwapWindow(mMainWindow);
+		}
+	}
 }
 
+// Fixed steps with an accumulator, see http://gafferongames.com/game-physics/fix-your-timestep/
 void Game::doMainLoop()
 {
-	SimpleTimer fpsTimer; // For calculating update delay and all
-	int currentTime = fpsTimer.start();
+	PROFILE_ZONE("Frame");
 
-	// Number of steps we need to do to be where we want to be
-	int numberOfStepsToDo = (currentTime - mLastFrameTime)/mStepLength;
+	Uint64 currentTime = SimpleTimer::getCurrentNanoseconds();
 
 	doEvents();
-	resetGraphics(); // Call before step if we want to do stuff in there
 
 	if(mLastFrameTime != 0) // Make sure everything is good before moving stuff!
 	{
-		for(int i = 0; i < numberOfStepsToDo; i++)
-			step(static_cast<float>(numberOfStepsToDo));
+		mStepAccumulator += currentTime - mLastFrameTime;
+
+		int stepsDone = 0;
+		while(mStepAccumulator >= mStepLength && stepsDone < mMaxStepsPerFrame && !mQuitting)
+		{
+			step();
+
+			mStepAccumulator -= mStepLength;
+			stepsDone++;
+		}
+
+		// Too far behind (breakpoint, window being dragged, slow computer...), drop the time we couldn't simulate.
+		// Trying to catch up would make the next frame even longer, and so on (spiral of death).
+		if(mStepAccumulator >= mStepLength)
+		{
+			Utils::LOGPRINT_DEBUG("Game loop can't keep up, dropping " + std::to_string(mStepAccumulator / mStepLength) + " steps.");
+			mStepAccumulator %= mStepLength; // Keep the partial step, it's still good for interpolating
+		}
 	}
 
-	render();
+	// Render where things are between the last step and the next one
+	float interpolation = static_cast<float>(mStepAccumulator) / static_cast<float>(mStepLength);
+
+	render(interpolation);
 	checkForErrors();
 
 	mLastFrameTime = currentTime;
 
-	int minTimePerFrame = 1000 / mMaxFramesPerSecond; // In miliseconds
+	mFramePacer.waitForNextFrame();
+}
+
+// The main loop without a window: no rendering and no frame cap.
+// Each iteration is exactly one step, and each step advances the (virtual) clock by mStepLength,
+// no matter how long it really took. Great for soak tests and server-side simulation.
+void Game::doHeadlessLoop()
+{
+	PROFILE_ZONE("Frame");
 
-	// If the frame took les ticks than the minimum, delay the next frame, virtually always does this.
-	if(fpsTimer.getTicks() < minTimePerFrame)
+	doEvents();
+	step(); // Same fixed step as when there is a window
+
+	// Follow the real clock if we were asked to, otherwise go as fast as possible
+	if(mHeadlessRealTime)
 	{
-		SDL_Delay(minTimePerFrame - fpsTimer.getTicks()); // Delay the remaining time for the ticks per frame wanted
+		mFramePacer.setFrameLength(mStepLength); // Does nothing if it didn't change
+		mFramePacer.waitForNextFrame();
 	}
 }
 
+// The main loop with a hidden window: one step and one frame per iteration, as fast as possible.
+// Frames only go to the render target (and to captures), so the same steps always give the same pictures,
+// even with a software renderer that could never keep up in real time (Mesa's llvmpipe on build machines).
+void Game::doOffscreenLoop()
+{
+	PROFILE_ZONE("Frame");
+
+	doEvents();
+	step();
+
+	if(mQuitting) // Don't render the step that ended it, like the headless loop
+		return;
+
+	render(1.0f); // Exactly at the step we just did
+	checkForErrors();
+}
+
 // Public Interface //
 
 // Initializes the game
@@ -346,8 +492,22 @@ bool Game::init()
 {	
 	Utils::LOGPRINT(std::string() + "Starting " + ENGINE_NAME + " v" + ENGINE_VERSION + "!");
 
-	// SDL_INIT_AUDIO for SDL_mixer
-	if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_AUDIO) < 0)
+	JobSystem::start(mJobWorkerCount);
+
+	Uint32 sdlFlags = SDL_INIT_EVENTS | SDL_INIT_AUDIO; // SDL_INIT_AUDIO for SDL_mixer
+
+	if(Utils::isHeadless())
+	{
+		Utils::LOGPRINT("Running headless, no window or OpenGL context will be created.");
+
+		// Servers normally don't have sound cards, but scripts still want to load and play sounds
+		SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+	} else
+	{
+		sdlFlags |= SDL_INIT_VIDEO;
+	}
+
+	if(SDL_Init(sdlFlags) < 0)
 	{
 		// Failed
 		Utils::CRASH_FROM_SDL("Unable to initialize SDL!");
@@ -372,13 +532,33 @@ bool Game::init()
 		return false;
 	}
 
+	if(Utils::isHeadless()) // We are done, no graphics
+	{
+		mThreadedRendering = false; // Nothing to render, and no context to give a render thread
+
+		Utils::LOGPRINT("Initialization finished!");
+		mInitialized = true;
+
+		return true;
+	}
+
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, GRAPHICS_OPENGL_MAJOR_VERSION);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, GRAPHICS_OPENGL_MINOR_VERSION);
 
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
 
-	mMainWindow = SDL_CreateWindow(mName.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, mSize.x, mSize.y, SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN);
+	// Debug contexts give better debug messages, but can be slower
+#ifdef NDEBUG
+	if(Utils::getGLErrorMode() == GRAPHICS_ERROR_MODE_STRICT)
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+#else
+	if(Utils::getGLErrorMode() != GRAPHICS_ERROR_MODE_POLLING)
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+#endif
+
+	mMainWindow = SDL_CreateWindow(mName.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, mSize.x, mSize.y,
+		SDL_WINDOW_OPENGL | (mOffscreen ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN));
 	
 	if(!mMainWindow) // If the window failed to create, crash
 	{
@@ -396,7 +576,8 @@ bool Game::init()
 		return false;
 	}
 
-	SDL_GL_SetSwapInterval(1); // Kind of VSync?
+	mSwapInterval = FramePacer::setupVSync(mVSync);
+	updateFramePacing();
 
 	if(!gladLoadGL()) // Load OpenGL at runtime. I don't use SDL's loader, so no need to use gladLoadGLLoader().
 	{
@@ -404,6 +585,8 @@ bool Game::init()
 		return false;
 	}
 
+	Utils::setupGLDebugOutput(); // Falls back to polling by itself
+
 	// Output OpenGL version
 	std::string glVersion;
 	glVersion = (const char* )glGetString(GL_VERSION);
@@ -419,6 +602,22 @@ bool Game::init()
 	setupGraphics();
 	checkForErrors();
 
+	if(mThreadedRendering)
+	{
+		// A second context, current on this thread, for loading resources while the render thread has the main one
+		SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+		mResourceContext = SDL_GL_CreateContext(mMainWindow); // Also makes it current
+
+		if(!mResourceContext)
+		{
+			Utils::WARN("Unable to create a shared OpenGL context, rendering on the main thread instead. SDL error: " + std::string(SDL_GetError()));
+			mThreadedRendering = false;
+		} else
+		{
+			Utils::setupGLDebugOutput(); // Debug output is per context
+		}
+	}
+
 	Utils::LOGPRINT("Initialization finished!");
 	mInitialized = true;
 
@@ -429,11 +628,65 @@ void Game::startMainLoop() // Starts the main loop
 {
 	if(mInitialized)
 	{
+		Profiler::setThreadName("Main");
 		initMainLoop();
 
-		while(!mQuitting) // While not quitting. mQuitting is set with quit()
+		if(!mInputReplayFile.empty() && mInputRecorder.startReplay(mInputReplayFile))
 		{
-			doMainLoop();
+			// Same steps as when recording, or the replay would do something else
+			if(mInputRecorder.getStepLength() != mStepLength)
+			{
+				Utils::LOGPRINT("Using the step length of the input recording (" + std::to_string(mInputRecorder.getStepLength()) + " ns).");
+
+				mStepLength = mInputRecorder.getStepLength();
+				mEntityManager.setPhysicsTimePerStep(static_cast<float>(mStepLength) / 1000000000.0f);
+			}
+		} else if(!mInputRecordFile.empty())
+		{
+			mInputRecorder.startRecording(mInputRecordFile, mStepLength);
+		}
+
+		if(mThreadedRendering && !mRenderThread.start(mMainWindow, mMainContext, mVSync))
+		{
+			// Take the main context back and do everything here
+			SDL_GL_MakeCurrent(mMainWindow, mMainContext);
+
+			SDL_GL_DeleteContext(mResourceContext);
+			mResourceContext = nullptr;
+			mThreadedRendering = false;
+		}
+
+		if(Utils::isHeadless())
+		{
+			SimpleTimer runTimer;
+			runTimer.start();
+
+			while(!mQuitting)
+				doHeadlessLoop();
+
+			int runTime = runTimer.getTicks();
+			float stepsPerSecond = runTime > 0 ? (mStepCount * 1000.0f) / runTime : 0.0f;
+
+			Utils::LOGPRINT("Headless run finished: " + std::to_string(mStepCount) + " steps in " + std::to_string(runTime) +
+				" ms (" + std::to_string(stepsPerSecond) + " steps per second).");
+		} else if(mOffscreen)
+		{
+			SimpleTimer runTimer;
+			runTimer.start();
+
+			while(!mQuitting)
+				doOffscreenLoop();
+
+			int runTime = runTimer.getTicks();
+
+			Utils::LOGPRINT("Offscreen run finished: " + std::to_string(mStepCount) + " steps and " + std::to_string(mFrameCount) +
+				" frames in " + std::to_string(runTime) + " ms.");
+		} else
+		{
+			while(!mQuitting) // While not quitting. mQuitting is set with quit()
+			{
+				doMainLoop();
+			}
 		}
 
 		cleanUp();
@@ -443,15 +696,151 @@ void Game::startMainLoop() // Starts the main loop
 	return; // Quit!
 }
 
+// 0 runs all jobs on the thread that adds them
+void Game::setJobWorkerCount(int workerCount)
+{
+	if(mInitialized)
+	{
+		Utils::WARN("Cannot change the amount of job workers after the game was initialized!");
+		return;
+	}
+
+	mJobWorkerCount = workerCount;
+}
+
+// Records the input of each step to this file, see InputRecorder
+void Game::setInputRecordFile(const std::string& filePath)
+{
+	mInputRecordFile = filePath;
+}
+
+// Replays the input recorded in this file instead of reading it from SDL, then quits
+void Game::setInputReplayFile(const std::string& filePath)
+{
+	mInputReplayFile = filePath;
+}
+
+bool Game::isReplayingInput()
+{
+	return mInputRecorder.isReplaying();
+}
+
 void Game::quit() // Call this when you want to quit to be clean
 {
 	mQuitting = true;
 }
 
+// No window, no OpenGL context and no rendering. Scripts and physics still run.
+// Must be called before init(), since resources need to know if they can talk to OpenGL.
+void Game::setHeadless(bool headless)
+{
+	if(mInitialized)
+	{
+		Utils::WARN("Cannot change headless mode after the game was initialized!");
+		return;
+	}
+
+	Utils::setHeadless(headless);
+}
+
+bool Game::isHeadless()
+{
+	return Utils::isHeadless();
+}
+
+// Rendering on another thread lets the next step run while the GPU draws, at the cost of one frame of latency.
+// On by default, falls back to the main thread if the OpenGL driver can't share contexts.
+void Game::setThreadedRendering(bool threadedRendering)
+{
+	if(mInitialized)
+	{
+		Utils::WARN("Cannot change threaded rendering after the game was initialized!");
+		return;
+	}
+
+	mThreadedRendering = threadedRendering;
+}
+
+bool Game::isRenderingOnThread()
+{
+	return mRenderThread.isRunning();
+}
+
+void Game::setHeadlessRealTime(bool realTime)
+{
+	mHeadlessRealTime = realTime;
+}
+
+// 0 for no limit
+void Game::setMaxSteps(int maxSteps)
+{
+	mMaxSteps = maxSteps;
+}
+
+int Game::getStepCount()
+{
+	return mStepCount;
+}
+
+// Exports the profiler's recording when the game quits, open it in chrome://tracing
+// Doesn't turn on the profiler, see Profiler::setEnabled()
+void Game::setProfilerTraceFile(const std::string& filePath)
+{
+	mProfilerTraceFile = filePath;
+}
+
+// Renders at a fixed size into a hidden window, nothing is shown. Steps and frames alternate as fast as possible
+// (see doOffscreenLoop()), with VSync off and no dynamic resolution. Use with setCapture() to get pictures out.
+// SDL still needs a video driver (Xvfb works), but any OpenGL 3.3 implementation will do, even a software one.
+void Game::setOffscreen(glm::ivec2 size)
+{
+	if(mInitialized)
+	{
+		Utils::WARN("Cannot render offscreen after the game was initialized!");
+		return;
+	}
+
+	if(size.x <= 0 || size.y <= 0)
+	{
+		Utils::WARN("Offscreen size " + std::to_string(size.x) + "x" + std::to_string(size.y) + " is invalid, ignoring it.");
+		return;
+	}
+
+	mVSync = false; // Nobody is looking
+	setSize(size);
+	mOffscreen = true; // After, the size is fixed from now on
+}
+
+bool Game::isOffscreen()
+{
+	return mOffscreen;
+}
+
+// Saves one frame out of interval to filePrefix + frame number + ".bmp", also works with a window.
+// Reading frames back waits for the GPU, so it slows everything down.
+void Game::setCapture(const std::string& filePrefix, int interval)
+{
+	if(interval <= 0)
+	{
+		Utils::WARN("Capture interval of " + std::to_string(interval) + " is invalid, capturing every frame.");
+		interval = 1;
+	}
+
+	mCapturePrefix = filePrefix;
+	mCaptureInterval = interval;
+}
+
+DynamicResolution& Game::getDynamicResolution()
+{
+	return mDynamicResolution;
+}
+
 void Game::setName(const std::string& name)
 {
 	mName = name;
-	SDL_SetWindowTitle(mMainWindow, name.c_str());
+
+	if(mMainWindow)
+		SDL_SetWindowTitle(mMainWindow, name.c_str());
 }
 
 std::string Game::getName()
@@ -462,11 +851,16 @@ std::string Game::getName()
 // Sets the game's size (width and height)
 void Game::setSize(glm::ivec2 size)
 {
+	if(mOffscreen) // Captures should always be the same size, whatever the scripts ask for
+	{
+		Utils::LOGPRINT_DEBUG("Rendering offscreen, ignoring the new game size.");
+		return;
+	}
+
 	mSize = size;
-	SDL_SetWindowSize(mMainWindow, size.x, size.y);
-	
-	// Resize the OpenGL viewport
-	glViewport(0, 0, size.x, size.y);
+
+	if(mMainWindow)
+		SDL_SetWindowSize(mMainWindow, size.x, size.y); // The viewport follows, see SceneSnapshot::render()
 
 	// Update camera
 	mEntityManager.getGameCamera().setAspectRatio(calculateAspectRatio());
@@ -477,23 +871,87 @@ glm::vec2 Game::getSize()
 	return mSize;
 }
 
+// 0 for no cap (VSync still applies)
 void Game::setMaxFramesPerSecond(int maxFPS)
 {
+	if(maxFPS < 0)
+	{
+		Utils::WARN("Max frames per second cannot be negative, use 0 for no cap!");
+		return;
+	}
+
 	mMaxFramesPerSecond = maxFPS;
+	updateFramePacing();
+}
+
+void Game::setVSync(bool vSync)
+{
+	if(mInitialized)
+	{
+		Utils::WARN("Cannot change VSync after the game was initialized!");
+		return;
+	}
+
+	mVSync = vSync;
+}
+
+bool Game::isVSyncOn()
+{
+	return mSwapInterval != 0;
+}
+
+FramePacer& Game::getFramePacer()
+{
+	return mFramePacer;
+}
+
+// Fewer steps per second is cheaper, rendering interpolates in between so movement stays smooth.
+// Also sets the physics time per step so that the game still runs at real speed.
+void Game::setStepsPerSecond(int stepsPerSecond)
+{
+	if(stepsPerSecond <= 0)
+	{
+		Utils::WARN("Steps per second must be over 0!");
+		return;
+	}
+
+	mStepLength = 1000000000 / stepsPerSecond;
+	mStepAccumulator = 0;
+	mEntityManager.setPhysicsTimePerStep(1 / static_cast<float>(stepsPerSecond));
+}
+
+int Game::getStepsPerSecond()
+{
+	return static_cast<int>(1000000000 / mStepLength);
+}
+
+// If a frame took longer than this amount of steps, the game slows down instead of trying to catch up
+void Game::setMaxStepsPerFrame(int maxSteps)
+{
+	if(maxSteps <= 0)
+	{
+		Utils::WARN("Max steps per frame must be over 0!");
+		return;
+	}
+
+	mMaxStepsPerFrame = maxSteps;
 }
 
 // Sets the game's main window position
 // The coords are the top left corner
 void Game::setMainWindowPosition(glm::ivec2 position)
 {
-	SDL_SetWindowPosition(mMainWindow, position.x, position.y);
+	if(mMainWindow)
+		SDL_SetWindowPosition(mMainWindow, position.x, position.y);
 }
 
 glm::ivec2 Game::getMainWindowPosition()
 {
 	int x = 0;
 	int y = 0;
-	SDL_GetWindowPosition(mMainWindow, &x, &y);
+
+	if(mMainWindow)
+		SDL_GetWindowPosition(mMainWindow, &x, &y);
 
 	return glm::ivec2(x, y);
 }
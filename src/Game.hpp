@@ -25,7 +25,12 @@
 
 #include <ResourceManager.hpp>
 #include <InputManager.hpp>
+#include <InputRecorder.hpp>
 #include <EntityManager.hpp>
+#include <SceneSnapshot.hpp>
+#include <RenderThread.hpp>
+#include <FramePacer.hpp>
+#include <DynamicResolution.hpp>
 
 #include <glm/glm.hpp>
 
@@ -36,10 +41,34 @@ private:
 	std::string mLogFile;
 
 	glm::ivec2 mSize;
-	int mMaxFramesPerSecond;
-	
-	int mLastFrameTime; // Time at last frame
-	int mStepLength;
+	int mMaxFramesPerSecond; // 0 for no cap
+	bool mVSync;
+	int mSwapInterval; // What was really set, see FramePacer::setupVSync()
+	FramePacer mFramePacer;
+
+	Uint64 mLastFrameTime; // Time at last frame, in nanoseconds
+	Uint64 mStepLength; // In nanoseconds
+	Uint64 mStepAccumulator; // Time not simulated yet, in nanoseconds. Always smaller than mStepLength after a frame.
+	int mMaxStepsPerFrame;
+
+	// Headless mode (see Utils::setHeadless())
+	bool mHeadlessRealTime; // If true, headless steps are spaced out to follow the real clock instead of running as fast as possible
+	int mMaxSteps; // Quit after this amount of steps, 0 for no limit
+	int mStepCount; // Steps done since the main loop started
+
+	// Rendering size, see RenderTarget
+	DynamicResolution mDynamicResolution; // Not used when offscreen
+	bool mOffscreen; // Hidden window, the scene is only drawn in the render target, at the window size
+	std::string mCapturePrefix; // If not empty, frames are saved to this + frame number + ".bmp"
+	int mCaptureInterval; // Save one frame out of this many
+	int mFrameCount; // Frames rendered since the main loop started
+
+	std::string mProfilerTraceFile; // If not empty, the profiler's trace is exported there when quitting
+
+	// Input recording, see InputRecorder
+	std::string mInputRecordFile; // If not empty, input is recorded there
+	std::string mInputReplayFile; // If not empty, input comes from there instead of SDL
+	InputRecorder mInputRecorder;
 
 	glm::vec3 mGraphicsBackgroundColor;
 
@@ -48,7 +77,15 @@ private:
 
 	// Pointers for SDL stuff needed
 	SDL_Window* mMainWindow; // We might have multiple windows one day
-	SDL_GLContext mMainContext; // OpenGl context
+	SDL_GLContext mMainContext; // OpenGl context, owned by the render thread if there is one
+	SDL_GLContext mResourceContext; // Shares with the main context, so this thread can still create resources. Null if not rendering on another thread.
+
+	int mJobWorkerCount; // Threads for the job system, see JobSystem.hpp
+
+	bool mThreadedRendering; // Render on another thread (if possible)
+	RenderThread mRenderThread;
+	SceneSnapshot mSceneSnapshot; // Built each frame
+	RenderQueue mRenderQueue; // When rendering on this thread
 
 	ResourceManager mResourceManager; // On stack, calls its constructor by itself and cleans (deconstructs) itself like magic.
 									  // But in this case, we need data from the user to create the resource manager, so we
@@ -68,11 +105,14 @@ private:
 	void checkForErrors();
 
 	float calculateAspectRatio();
+	int getRefreshRate();
+	void updateFramePacing();
 
-	void step(float divider);
-	void resetGraphics();
-	void render();
+	void step();
+	void render(float interpolation);
 	void doMainLoop();
+	void doHeadlessLoop();
+	void doOffscreenLoop();
 
 public:
 	Game();
@@ -83,6 +123,27 @@ public:
 	void startMainLoop();
 	void quit();
 
+	void setHeadless(bool headless); // Call before init()
+	void setThreadedRendering(bool threadedRendering); // Call before init()
+	void setJobWorkerCount(int workerCount); // Call before init()
+	bool isRenderingOnThread();
+	bool isHeadless();
+	void setHeadlessRealTime(bool realTime);
+	void setMaxSteps(int maxSteps);
+	int getStepCount();
+
+	void setProfilerTraceFile(const std::string& filePath);
+
+	void setOffscreen(glm::ivec2 size); // Call before init()
+	bool isOffscreen();
+	void setCapture(const std::string& filePrefix, int interval); // Empty prefix to stop
+	DynamicResolution& getDynamicResolution();
+
+	// Call before startMainLoop()
+	void setInputRecordFile(const std::string& filePath);
+	void setInputReplayFile(const std::string& filePath);
+	bool isReplayingInput();
+
 	// Useful for scripting and other things
 	void setName(const std::string& name);
 	std::string getName();
@@ -90,6 +151,12 @@ public:
 	glm::vec2 getSize();
 
 	void setMaxFramesPerSecond(int maxFPS);
+	void setVSync(bool vSync); // Call before init()
+	bool isVSyncOn();
+	FramePacer& getFramePacer();
+	void setStepsPerSecond(int stepsPerSecond);
+	int getStepsPerSecond();
+	void setMaxStepsPerFrame(int maxSteps);
 	void setMainWindowPosition(glm::ivec2 position);
 	glm::ivec2 getMainWindowPosition();
 	void reCenterMainWindow();
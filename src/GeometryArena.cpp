@@ -0,0 +1,435 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <GeometryArena.hpp>
+
+#include <ObjectGeometry.hpp> // For PackedVertex and the vertex attributes
+#include <Utils.hpp>
+
+#include <algorithm> // For std::sort() and std::max()
+#include <atomic>
+#include <iterator> // For std::prev()
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream> // For the compaction message
+#include <string>
+#include <vector>
+
+#define GEOMETRY_ARENA_VERTEX_SIZE sizeof(ObjectGeometry::PackedVertex)
+
+namespace GeometryArena
+{
+using freeBlockMap = std::map<std::size_t, std::size_t>; // Offset to size
+
+struct Page
+{
+	GLuint vertexBuffer;
+	GLuint indexBuffer;
+	std::size_t vertexCapacity; // In vertices
+	std::size_t indexCapacity; // In bytes
+
+	// Only touched with gMutex
+	freeBlockMap freeVertices; // In vertices
+	freeBlockMap freeIndices; // In bytes
+
+	GLuint vertexArrays[2][VERTEX_LAYOUT_COUNT]; // Only touched on the drawing context, 0 until needed
+
+	Page(std::size_t vertexCapacity, std::size_t indexCapacity);
+	~Page();
+
+	bool isEmpty() const;
+};
+
+std::mutex gMutex; // Protects everything below
+std::vector<std::shared_ptr<Page>> gPages; // That geometry can go in
+std::set<Range*> gRanges; // All of them, for compact()
+unsigned int gNextRangeID = 0;
+
+std::atomic<bool> gEnabled(GEOMETRY_ARENA_DEFAULT_ENABLED);
+
+// Same as ObjectGeometry, pages can be let go of on any thread
+std::mutex gOrphanedVertexArraysMutex;
+std::vector<GLuint> gOrphanedVertexArrays;
+
+// Page
+
+// Uses GL_COPY_WRITE_BUFFER, binding an element array buffer would change the bound VAO
+Page::Page(std::size_t vertexCapacity, std::size_t indexCapacity)
+	: vertexCapacity(vertexCapacity), indexCapacity(indexCapacity)
+{
+	glGenBuffers(1, &vertexBuffer);
+	glGenBuffers(1, &indexBuffer);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * GEOMETRY_ARENA_VERTEX_SIZE, nullptr, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity, nullptr, GL_STATIC_DRAW);
+
+	freeVertices[0] = vertexCapacity;
+	freeIndices[0] = indexCapacity;
+
+	for(int i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+		vertexArrays[0][i] = vertexArrays[1][i] = 0;
+}
+
+// Buffers are shared between contexts, VAOs aren't (see deleteOrphanedVertexArrays())
+Page::~Page()
+{
+	glDeleteBuffers(1, &vertexBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+
+	std::lock_guard<std::mutex> lock(gOrphanedVertexArraysMutex);
+
+	for(int instanced = 0; instanced < 2; instanced++)
+	{
+		for(int i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+		{
+			if(vertexArrays[instanced][i] != 0)
+				gOrphanedVertexArrays.push_back(vertexArrays[instanced][i]);
+		}
+	}
+}
+
+bool Page::isEmpty() const
+{
+	return freeVertices.size() == 1 && freeVertices.begin()->second == vertexCapacity;
+}
+
+// First fit, returns false if no block is big enough
+static bool takeBlock(freeBlockMap& freeBlocks, std::size_t size, std::size_t& offset)
+{
+	for(freeBlockMap::iterator block = freeBlocks.begin(); block != freeBlocks.end(); ++block)
+	{
+		if(block->second < size)
+			continue;
+
+		offset = block->first;
+		std::size_t sizeLeft = block->second - size;
+
+		freeBlocks.erase(block);
+
+		if(sizeLeft > 0)
+			freeBlocks[offset + size] = sizeLeft;
+
+		return true;
+	}
+
+	return false;
+}
+
+// Merges it with the free blocks right before and after it
+static void giveBlock(freeBlockMap& freeBlocks, std::size_t offset, std::size_t size)
+{
+	freeBlockMap::iterator next = freeBlocks.lower_bound(offset);
+
+	if(next != freeBlocks.end() && offset + size == next->first)
+	{
+		size += next->second;
+		next = freeBlocks.erase(next);
+	}
+
+	if(next != freeBlocks.begin())
+	{
+		freeBlockMap::iterator previous = std::prev(next);
+
+		if(previous->first + previous->second == offset)
+		{
+			previous->second += size;
+			return;
+		}
+	}
+
+	freeBlocks[offset] = size;
+}
+
+// Finds room on a page, or makes a new one. Call with gMutex.
+static std::shared_ptr<const Location> place(std::size_t vertexCount, std::size_t indexSize)
+{
+	indexSize = (indexSize + GEOMETRY_ARENA_INDEX_ALIGNMENT - 1) & ~static_cast<std::size_t>(GEOMETRY_ARENA_INDEX_ALIGNMENT - 1);
+
+	std::shared_ptr<Page> page;
+	std::size_t vertexOffset = 0;
+	std::size_t indexOffset = 0;
+
+	for(const auto& existingPage : gPages)
+	{
+		if(!takeBlock(existingPage->freeVertices, vertexCount, vertexOffset))
+			continue;
+
+		if(!takeBlock(existingPage->freeIndices, indexSize, indexOffset))
+		{
+			giveBlock(existingPage->freeVertices, vertexOffset, vertexCount);
+			continue;
+		}
+
+		page = existingPage;
+		break;
+	}
+
+	if(!page) // Bigger than usual if the geometry doesn't fit in one
+	{
+		page = std::make_shared<Page>(std::max(vertexCount, static_cast<std::size_t>(GEOMETRY_ARENA_PAGE_VERTICES)),
+			std::max(indexSize, static_cast<std::size_t>(GEOMETRY_ARENA_PAGE_INDEX_SIZE)));
+		gPages.push_back(page);
+
+		takeBlock(page->freeVertices, vertexCount, vertexOffset);
+		takeBlock(page->freeIndices, indexSize, indexOffset);
+	}
+
+	std::shared_ptr<Location> location = std::make_shared<Location>();
+	location->page = page;
+	location->vertexBuffer = page->vertexBuffer;
+	location->baseVertex = static_cast<GLint>(vertexOffset);
+	location->vertexCount = static_cast<GLsizei>(vertexCount);
+	location->indexOffset = indexOffset;
+	location->indexSize = indexSize;
+
+	return location;
+}
+
+// Call with gMutex
+static void release(const Location& location)
+{
+	Page& page = *location.page;
+
+	giveBlock(page.freeVertices, static_cast<std::size_t>(location.baseVertex), static_cast<std::size_t>(location.vertexCount));
+	giveBlock(page.freeIndices, location.indexOffset, location.indexSize);
+
+	if(page.isEmpty()) // Let go of its buffers once nothing draws from it anymore
+	{
+		gPages.erase(std::remove(gPages.begin(), gPages.end(), location.page), gPages.end());
+	}
+}
+
+// Call with gMutex
+static Stats computeStats()
+{
+	Stats stats;
+	std::size_t freeSize = 0;
+	std::size_t largestFreeBlocks = 0; // Sum of the largest of each buffer
+
+	for(const auto& page : gPages)
+	{
+		stats.capacity += page->vertexCapacity * GEOMETRY_ARENA_VERTEX_SIZE + page->indexCapacity;
+
+		std::size_t largestVertexBlock = 0;
+		std::size_t largestIndexBlock = 0;
+
+		for(const auto& block : page->freeVertices)
+			largestVertexBlock = std::max(largestVertexBlock, block.second * GEOMETRY_ARENA_VERTEX_SIZE);
+
+		for(const auto& block : page->freeIndices)
+			largestIndexBlock = std::max(largestIndexBlock, block.second);
+
+		for(const auto& block : page->freeVertices)
+			freeSize += block.second * GEOMETRY_ARENA_VERTEX_SIZE;
+
+		for(const auto& block : page->freeIndices)
+			freeSize += block.second;
+
+		stats.freeBlockCount += static_cast<int>(page->freeVertices.size() + page->freeIndices.size());
+		stats.largestFreeBlock = std::max(stats.largestFreeBlock, std::max(largestVertexBlock, largestIndexBlock));
+		largestFreeBlocks += largestVertexBlock + largestIndexBlock;
+	}
+
+	stats.pageCount = static_cast<int>(gPages.size());
+	stats.geometryCount = static_cast<int>(gRanges.size());
+	stats.usedSize = stats.capacity - freeSize;
+	stats.fragmentation = (freeSize > 0) ? 1.0f - static_cast<float>(largestFreeBlocks) / static_cast<float>(freeSize) : 0.0f;
+
+	return stats;
+}
+
+// Range
+
+Range::Range(std::shared_ptr<const Location> location, unsigned int id)
+	: mLocation(location), mID(id)
+{
+	// Do nothing
+}
+
+Range::~Range()
+{
+	std::lock_guard<std::mutex> lock(gMutex);
+
+	gRanges.erase(this);
+	release(*mLocation); // Nothing moves it while we have the lock
+}
+
+std::shared_ptr<const Location> Range::getLocation() const
+{
+	return std::atomic_load(&mLocation);
+}
+
+void Range::setLocation(std::shared_ptr<const Location> location)
+{
+	std::atomic_store(&mLocation, location);
+}
+
+unsigned int Range::getID() const
+{
+	return mID;
+}
+
+// Stats
+
+Stats::Stats()
+{
+	pageCount = 0;
+	geometryCount = 0;
+
+	capacity = 0;
+	usedSize = 0;
+	freeBlockCount = 0;
+	largestFreeBlock = 0;
+
+	fragmentation = 0.0f;
+}
+
+// Index size is in bytes, 16 or 32-bit indices (see ObjectGeometry::getIndexType()). Needs a current context.
+std::shared_ptr<Range> allocate(const void* vertices, GLsizei vertexCount, const void* indices, std::size_t indexSize)
+{
+	if(!isEnabled() || vertexCount <= 0 || indexSize == 0)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(gMutex);
+
+	std::shared_ptr<const Location> location = place(static_cast<std::size_t>(vertexCount), indexSize);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, location->vertexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, location->baseVertex * GEOMETRY_ARENA_VERTEX_SIZE,
+		vertexCount * GEOMETRY_ARENA_VERTEX_SIZE, vertices);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, location->page->indexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, location->indexOffset, indexSize, indices);
+
+	std::shared_ptr<Range> range(new Range(location, gNextRangeID++));
+	gRanges.insert(range.get());
+
+	return range;
+}
+
+// Moves all geometry to new pages, one right after the other, so there are no holes left.
+// Copies on the GPU with glCopyBufferSubData(), call with a current context.
+// Frames that are being drawn keep the old pages alive until they are done with them (see Range::getLocation()).
+// Only frames snapshotted after this use the new places, the copies are done by the time their resource fence is.
+void compact()
+{
+	if(Utils::isHeadless())
+		return;
+
+	std::lock_guard<std::mutex> lock(gMutex);
+
+	Stats before = computeStats();
+
+	if(before.pageCount == 0)
+		return;
+
+	// Biggest first, the small ones fill what is left of the pages
+	std::vector<Range*> ranges(gRanges.begin(), gRanges.end());
+
+	std::sort(ranges.begin(), ranges.end(), [](const Range* first, const Range* second)
+	{
+		return first->getLocation()->vertexCount > second->getLocation()->vertexCount;
+	});
+
+	std::vector<std::shared_ptr<Page>> oldPages;
+	oldPages.swap(gPages); // Kept alive until everything is copied
+
+	for(Range* range : ranges)
+	{
+		std::shared_ptr<const Location> oldLocation = range->getLocation();
+		std::shared_ptr<const Location> newLocation = place(static_cast<std::size_t>(oldLocation->vertexCount), oldLocation->indexSize);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, oldLocation->vertexBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, newLocation->vertexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+			oldLocation->baseVertex * GEOMETRY_ARENA_VERTEX_SIZE, newLocation->baseVertex * GEOMETRY_ARENA_VERTEX_SIZE,
+			oldLocation->vertexCount * GEOMETRY_ARENA_VERTEX_SIZE);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, oldLocation->page->indexBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, newLocation->page->indexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, oldLocation->indexOffset, newLocation->indexOffset, oldLocation->indexSize);
+
+		range->setLocation(newLocation);
+	}
+
+	Stats after = computeStats();
+
+	std::ostringstream message;
+	message.precision(3);
+	message << "Compacted geometry arena: " << before.pageCount << " -> " << after.pageCount << " pages, "
+		<< before.usedSize / 1024 << " KB used of " << before.capacity / 1024 << " -> " << after.capacity / 1024
+		<< ", fragmentation " << before.fragmentation << " -> " << after.fragmentation << ".";
+
+	Utils::LOGPRINT(message.str());
+}
+
+Stats getStats()
+{
+	std::lock_guard<std::mutex> lock(gMutex);
+	return computeStats();
+}
+
+void setEnabled(bool enabled)
+{
+	gEnabled.store(enabled);
+}
+
+bool isEnabled()
+{
+	return gEnabled.load() && !Utils::isHeadless();
+}
+
+// One VAO per page and layout, shared by all of its geometry
+GLuint getVertexArray(const Location& location, int layout, bool instanced)
+{
+	Page& page = *location.page;
+	GLuint& vertexArray = page.vertexArrays[instanced ? 1 : 0][layout];
+
+	if(vertexArray == 0)
+	{
+		glGenVertexArrays(1, &vertexArray);
+		glBindVertexArray(vertexArray);
+
+		glBindBuffer(GL_ARRAY_BUFFER, page.vertexBuffer);
+		ObjectGeometry::setPackedVertexAttributes(layout);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.indexBuffer);
+
+		if(instanced)
+			ObjectGeometry::setInstanceAttributes();
+	}
+
+	return vertexArray;
+}
+
+void deleteOrphanedVertexArrays()
+{
+	std::lock_guard<std::mutex> lock(gOrphanedVertexArraysMutex);
+
+	if(gOrphanedVertexArrays.empty())
+		return;
+
+	glDeleteVertexArrays(static_cast<GLsizei>(gOrphanedVertexArrays.size()), gOrphanedVertexArrays.data());
+	gOrphanedVertexArrays.clear();
+}
+}
\ No newline at end of file
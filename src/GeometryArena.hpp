@@ -0,0 +1,109 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Sub-allocates packed geometry (see VERTEX_FORMAT_PACKED) from a few big vertex and index buffers, its pages.
+// Geometries on the same page share their VAOs, so drawing one after the other binds nothing: each draw starts
+// at its own place in the page with glDrawElementsBaseVertex(). RenderQueue sorts draws by page, and draws runs of
+// objects that only differ by their geometry with one glMultiDrawElementsBaseVertex() (see SceneSnapshot::batchObjects()).
+//
+// Each page has a free list for its vertices and one for its indices (first fit, merged back when freed).
+// Freed geometry leaves holes, see getStats(). compact() packs everything that is left into new pages,
+// ResourceManager::clearObjectGeometryGroups() calls it since that usually frees most of the arena at once.
+//
+// Geometry is added and freed on the thread that creates it (with the current context), the arena has a mutex for that.
+// Compacting moves geometry while another thread might be drawing it: each Range points to an immutable Location,
+// swapped all at once. Snapshots read it on the thread that compacts (see ObjectSnapshot::arenaLocation), so a frame is only
+// drawn from places its resource fence covers, and it keeps their pages alive.
+//
+// Off in headless mode, there is no OpenGL. Like ObjectGeometry, VAOs are created on the context that draws.
+
+#ifndef GEOMETRY_ARENA_HPP
+#define GEOMETRY_ARENA_HPP
+
+#include <Definitions.hpp>
+
+#include <glad/glad.h>
+
+#include <cstddef> // For std::size_t
+#include <memory> // For smart pointers
+
+namespace GeometryArena
+{
+struct Page; // See GeometryArena.cpp
+
+// Where a geometry is, never changes once made
+struct Location
+{
+	std::shared_ptr<Page> page;
+	GLuint vertexBuffer; // Of the page, for sorting draws
+
+	GLint baseVertex; // Added to each index
+	GLsizei vertexCount;
+	std::size_t indexOffset; // In bytes, in the page's index buffer
+	std::size_t indexSize; // Same
+};
+
+// One geometry's part of the arena, given back when this is destroyed
+class Range
+{
+private:
+	std::shared_ptr<const Location> mLocation;
+	unsigned int mID; // Unique (until it wraps around), kept when compacting. For sorting draws.
+
+public:
+	Range(std::shared_ptr<const Location> location, unsigned int id);
+	Range(const Range& other) = delete;
+	Range& operator=(const Range& other) = delete;
+	~Range();
+
+	std::shared_ptr<const Location> getLocation() const; // From any thread
+	void setLocation(std::shared_ptr<const Location> location); // Only compact() moves ranges
+	unsigned int getID() const;
+};
+
+struct Stats
+{
+	int pageCount;
+	int geometryCount;
+
+	std::size_t capacity; // In bytes, vertices and indices of all pages
+	std::size_t usedSize;
+	int freeBlockCount;
+	std::size_t largestFreeBlock; // In bytes, vertices or indices
+
+	// 0 if the free space of each buffer is in one block, close to 1 if it is in many small holes
+	float fragmentation;
+
+	Stats();
+};
+
+// Returns null if the arena is off or the geometry is empty, keep your own buffers then
+std::shared_ptr<Range> allocate(const void* vertices, GLsizei vertexCount, const void* indices, std::size_t indexSize);
+
+void compact();
+Stats getStats();
+
+void setEnabled(bool enabled); // For geometry created after this
+bool isEnabled();
+
+GLuint getVertexArray(const Location& location, int layout, bool instanced); // Call on the drawing context only
+void deleteOrphanedVertexArrays(); // Call on the drawing context, see ~Page()
+}
+
+#endif /* GEOMETRY_ARENA_HPP */
\ No newline at end of file
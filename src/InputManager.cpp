@@ -64,6 +64,20 @@ bool InputManager::isKeyPressed(int sdlKey)
 	return got->second;
 }
 
+const InputManager::keyStateMap& InputManager::getKeyStates() const
+{
+	return mKeys;
+}
+
+// Ignores keys that aren't registered, nobody would ask for them anyway
+void InputManager::setKeyPressed(int sdlKey, bool pressed)
+{
+	sdlKeyMap::iterator sdlKeyIt = mKeys.find(sdlKey);
+
+	if(sdlKeyIt != mKeys.end())
+		sdlKeyIt->second = pressed;
+}
+
 // Call each frame! Takes an event, and checks and updates keys.
 // One event can only talk about one key, so iterate through the SDL events and call this each time
 void InputManager::updateKeyByEvent(SDL_Event event)
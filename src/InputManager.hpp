@@ -28,8 +28,11 @@
 
 class InputManager
 {
+public:
+	using keyStateMap = std::map<int, bool>; // Key, is pressed
+
 private:
-	using sdlKeyMap = std::map<int, bool>; // Using a non-const key seems to be more compatible with different implementations
+	using sdlKeyMap = keyStateMap; // Using a non-const key seems to be more compatible with different implementations
 	using sdlKeyMapPair = std::pair<int, bool>;
 
 	sdlKeyMap mKeys;
@@ -43,6 +46,10 @@ public:
 	void registerKeys(const keyVector& keys);
 	bool isKeyPressed(int sdlKey);
 
+	// For recording and replaying input (see InputRecorder)
+	const keyStateMap& getKeyStates() const;
+	void setKeyPressed(int sdlKey, bool pressed);
+
 	void updateKeyByEvent(SDL_Event event);
 };
 
@@ -0,0 +1,265 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <InputRecorder.hpp>
+
+#include <Definitions.hpp>
+#include <Utils.hpp>
+
+#include <cstring> // For memcmp()
+#include <vector>
+
+#define INPUT_RECORDING_MAGIC "SDL3DINP"
+#define INPUT_RECORDING_MAGIC_LENGTH 8
+#define INPUT_RECORDING_VERSION 1
+
+#define INPUT_RECORDING_RECORD_HEADER_SIZE 6 // Uint32 step + Uint16 change count
+#define INPUT_RECORDING_CHANGE_SIZE 5 // Int32 key + Uint8 pressed
+
+InputRecorder::InputRecorder()
+{
+	mMode = INPUT_RECORDER_IDLE;
+	mFile = nullptr;
+	mStepLength = 0;
+
+	mNextRecordStep = 0;
+	mNextRecordChangeCount = 0;
+}
+
+InputRecorder::~InputRecorder()
+{
+	if(mMode == INPUT_RECORDER_RECORDING)
+		Utils::WARN("Input recording '" + mFilePath + "' was not stopped, it will not be usable!");
+
+	closeFile();
+}
+
+void InputRecorder::closeFile()
+{
+	if(mFile)
+	{
+		SDL_RWclose(mFile);
+		mFile = nullptr;
+	}
+
+	mMode = INPUT_RECORDER_IDLE;
+}
+
+// Reads the step and change count of the next record
+// Returns false if the file ends before that
+bool InputRecorder::readRecordHeader()
+{
+	Sint64 position = SDL_RWtell(mFile);
+	Sint64 size = SDL_RWsize(mFile);
+
+	if(position < 0 || size < 0 || size - position < INPUT_RECORDING_RECORD_HEADER_SIZE)
+		return false;
+
+	mNextRecordStep = SDL_ReadLE32(mFile);
+	mNextRecordChangeCount = SDL_ReadLE16(mFile);
+
+	if(size - SDL_RWtell(mFile) < static_cast<Sint64>(mNextRecordChangeCount) * INPUT_RECORDING_CHANGE_SIZE)
+		return false;
+
+	return true;
+}
+
+// Step length is written in the file, a replay needs the same one to do the same thing
+bool InputRecorder::startRecording(const std::string& filePath, Uint64 stepLength)
+{
+	if(mMode != INPUT_RECORDER_IDLE)
+	{
+		Utils::WARN("Already recording or replaying input, cannot record to '" + filePath + "'!");
+		return false;
+	}
+
+	mFile = SDL_RWFromFile(filePath.c_str(), "wb");
+
+	if(!mFile)
+	{
+		Utils::WARN("Cannot open '" + filePath + "' to record input! SDL error: " + std::string(SDL_GetError()));
+		return false;
+	}
+
+	SDL_RWwrite(mFile, INPUT_RECORDING_MAGIC, 1, INPUT_RECORDING_MAGIC_LENGTH);
+	SDL_WriteLE32(mFile, INPUT_RECORDING_VERSION);
+	SDL_WriteLE64(mFile, stepLength);
+
+	mMode = INPUT_RECORDER_RECORDING;
+	mFilePath = filePath;
+	mStepLength = stepLength;
+	mRecordedKeys.clear();
+
+	Utils::LOGPRINT("Recording input to '" + filePath + "'.");
+	return true;
+}
+
+bool InputRecorder::startReplay(const std::string& filePath)
+{
+	if(mMode != INPUT_RECORDER_IDLE)
+	{
+		Utils::WARN("Already recording or replaying input, cannot replay '" + filePath + "'!");
+		return false;
+	}
+
+	mFile = SDL_RWFromFile(filePath.c_str(), "rb");
+
+	if(!mFile)
+	{
+		Utils::WARN("Cannot open input recording '" + filePath + "'! SDL error: " + std::string(SDL_GetError()));
+		return false;
+	}
+
+	char magic[INPUT_RECORDING_MAGIC_LENGTH];
+
+	if(SDL_RWread(mFile, magic, 1, INPUT_RECORDING_MAGIC_LENGTH) != INPUT_RECORDING_MAGIC_LENGTH
+		|| std::memcmp(magic, INPUT_RECORDING_MAGIC, INPUT_RECORDING_MAGIC_LENGTH) != 0)
+	{
+		Utils::WARN("'" + filePath + "' is not an input recording!");
+		closeFile();
+		return false;
+	}
+
+	Uint32 version = SDL_ReadLE32(mFile);
+
+	if(version != INPUT_RECORDING_VERSION)
+	{
+		Utils::WARN("Input recording '" + filePath + "' is version " + std::to_string(version) +
+			", only version " + std::to_string(INPUT_RECORDING_VERSION) + " is supported!");
+		closeFile();
+		return false;
+	}
+
+	mStepLength = SDL_ReadLE64(mFile);
+
+	if(mStepLength == 0 || !readRecordHeader())
+	{
+		Utils::WARN("Input recording '" + filePath + "' is empty or corrupted!");
+		closeFile();
+		return false;
+	}
+
+	mMode = INPUT_RECORDER_REPLAYING;
+	mFilePath = filePath;
+
+	Utils::LOGPRINT("Replaying input from '" + filePath + "'.");
+	return true;
+}
+
+// Step count is the amount of steps done since recording started, so replays end at the same step
+void InputRecorder::stop(Uint32 stepCount)
+{
+	if(mMode == INPUT_RECORDER_RECORDING)
+	{
+		// End record
+		SDL_WriteLE32(mFile, stepCount);
+		SDL_WriteLE16(mFile, 0);
+
+		Utils::LOGPRINT("Recorded " + std::to_string(stepCount) + " steps of input to '" + mFilePath + "'.");
+	}
+
+	closeFile();
+}
+
+bool InputRecorder::isRecording() const
+{
+	return mMode == INPUT_RECORDER_RECORDING;
+}
+
+bool InputRecorder::isReplaying() const
+{
+	return mMode == INPUT_RECORDER_REPLAYING;
+}
+
+Uint64 InputRecorder::getStepLength() const
+{
+	return mStepLength;
+}
+
+// Call before each step, writes the keys that changed since the last record
+void InputRecorder::recordStep(Uint32 step, const InputManager& inputManager)
+{
+	if(mMode != INPUT_RECORDER_RECORDING)
+		return;
+
+	std::vector<InputManager::keyStateMap::value_type> changes;
+
+	for(const auto& key : inputManager.getKeyStates())
+	{
+		InputManager::keyStateMap::iterator recordedKey = mRecordedKeys.find(key.first);
+
+		// Keys start released, like in InputManager
+		bool wasPressed = (recordedKey != mRecordedKeys.end()) ? recordedKey->second : false;
+
+		if(key.second != wasPressed)
+		{
+			changes.push_back(key);
+			mRecordedKeys[key.first] = key.second;
+		}
+	}
+
+	if(changes.empty()) // Nothing to write, most steps
+		return;
+
+	SDL_WriteLE32(mFile, step);
+	SDL_WriteLE16(mFile, static_cast<Uint16>(changes.size())); // There will never be 65535 keys registered
+
+	for(const auto& change : changes)
+	{
+		SDL_WriteLE32(mFile, static_cast<Uint32>(change.first));
+		SDL_WriteU8(mFile, change.second ? 1 : 0);
+	}
+}
+
+// Call before each step instead of reading real input
+// Returns false when the recording is over
+bool InputRecorder::replayStep(Uint32 step, InputManager& inputManager)
+{
+	if(mMode != INPUT_RECORDER_REPLAYING)
+		return false;
+
+	if(mNextRecordChangeCount == 0 && step >= mNextRecordStep) // End record
+	{
+		Utils::LOGPRINT("Input replay of '" + mFilePath + "' finished after " + std::to_string(step) + " steps.");
+		closeFile();
+
+		return false;
+	}
+
+	if(step < mNextRecordStep) // Nothing changed
+		return true;
+
+	for(Uint16 i = 0; i < mNextRecordChangeCount; i++)
+	{
+		int key = static_cast<int>(SDL_ReadLE32(mFile));
+		bool pressed = (SDL_ReadU8(mFile) != 0);
+
+		inputManager.setKeyPressed(key, pressed);
+	}
+
+	if(!readRecordHeader())
+	{
+		Utils::WARN("Input recording '" + mFilePath + "' ends too early, it might be truncated!");
+		closeFile();
+
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Records the input state of each step to a file, and plays it back later instead of the real input.
+// With fixed steps, a replay runs exactly the same steps with exactly the same input, great for comparing performance.
+//
+// File format (little endian):
+// Header: "SDL3DINP", Uint32 version, Uint64 step length in nanoseconds
+// Then one record per step where keys changed: Uint32 step, Uint16 change count, and for each change Int32 key, Uint8 pressed
+// The last record has no changes, its step is the amount of steps recorded.
+
+#ifndef INPUT_RECORDER_HPP
+#define INPUT_RECORDER_HPP
+
+#include <InputManager.hpp>
+
+#include <SDL.h>
+
+#include <string>
+
+class InputRecorder
+{
+private:
+	int mMode; // INPUT_RECORDER_IDLE, INPUT_RECORDER_RECORDING or INPUT_RECORDER_REPLAYING
+	std::string mFilePath;
+	SDL_RWops* mFile;
+
+	Uint64 mStepLength; // Of the recording, in nanoseconds
+
+	InputManager::keyStateMap mRecordedKeys; // Key states as of the last record, when recording
+
+	// Next record, when replaying
+	Uint32 mNextRecordStep;
+	Uint16 mNextRecordChangeCount;
+
+	bool readRecordHeader();
+	void closeFile();
+
+public:
+	InputRecorder();
+	~InputRecorder();
+
+	bool startRecording(const std::string& filePath, Uint64 stepLength);
+	bool startReplay(const std::string& filePath);
+	void stop(Uint32 stepCount);
+
+	bool isRecording() const;
+	bool isReplaying() const;
+	Uint64 getStepLength() const;
+
+	void recordStep(Uint32 step, const InputManager& inputManager);
+	bool replayStep(Uint32 step, InputManager& inputManager);
+};
+
+#endif /* INPUT_RECORDER_HPP */
\ No newline at end of file
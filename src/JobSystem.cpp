@@ -0,0 +1,446 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <JobSystem.hpp>
+
+#include <Definitions.hpp>
+#include <Utils.hpp>
+#include <Profiler.hpp>
+
+#include <algorithm> // For std::min
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace JobSystem
+{
+struct Job
+{
+	jobFunction function;
+	std::atomic<int> pendingDependencies; // Plus one while the job is being added, so it can't start too early
+
+	std::atomic<bool> done;
+	std::mutex continuationsMutex; // Protects everything below
+	bool finished; // Same as done, but checked under the lock so continuations are never forgotten
+	std::vector<std::shared_ptr<Job>> continuations; // Jobs that depend on this one
+};
+
+using jobPointer = std::shared_ptr<Job>;
+
+// Mutexes are fine here, each deque is mostly used by one thread so they are rarely contended
+struct JobQueue
+{
+	std::mutex mutex;
+	std::deque<jobPointer> jobs;
+};
+
+// Queue 0 is shared by the threads that aren't workers, workers have the others.
+// What workers touch is never freed: after exit() from a job, they are detached and keep running while statics are destroyed.
+std::vector<std::unique_ptr<JobQueue>>& gQueues = *new std::vector<std::unique_ptr<JobQueue>>;
+std::vector<std::thread> gWorkers;
+std::atomic<bool> gStopping(false);
+
+std::atomic<int> gQueuedJobs(0); // In all queues
+std::atomic<int> gSleepingWorkers(0);
+std::mutex& gSleepMutex = *new std::mutex;
+std::condition_variable& gSleepCondition = *new std::condition_variable;
+
+thread_local int tQueueIndex = 0;
+thread_local unsigned int tStealSeed = 0; // Where to start looking, so workers don't all rob the same one
+
+// Destroyed before the workers (reverse order), when exit() is called or main() returns
+struct ShutdownGuard
+{
+	~ShutdownGuard()
+	{
+		if(gWorkers.empty())
+			return;
+
+		if(!isWorkerThread())
+		{
+			stop();
+			return;
+		}
+
+		// exit() from a job, nobody can wait for the workers. The process is going away anyway, and what they use stays alive.
+		gStopping.store(true);
+
+		for(auto& worker : gWorkers)
+			worker.detach();
+
+		gWorkers.clear();
+	}
+};
+
+ShutdownGuard gShutdownGuard;
+
+static void schedule(const jobPointer& job);
+
+static void execute(const jobPointer& job)
+{
+	job->function();
+	job->function = nullptr; // Let go of what it captured
+
+	std::vector<jobPointer> continuations;
+
+	{
+		std::lock_guard<std::mutex> lock(job->continuationsMutex);
+
+		job->finished = true;
+		job->done.store(true, std::memory_order_release);
+		continuations.swap(job->continuations);
+	}
+
+	for(const auto& continuation : continuations)
+	{
+		if(continuation->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			schedule(continuation);
+	}
+}
+
+static void push(const jobPointer& job)
+{
+	JobQueue& queue = *gQueues[tQueueIndex];
+
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+
+	gQueuedJobs.fetch_add(1);
+
+	if(gSleepingWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(gSleepMutex);
+		gSleepCondition.notify_one();
+	}
+}
+
+// Returns null if there was nothing to take
+static jobPointer pop()
+{
+	if(gQueues.empty() || gQueuedJobs.load(std::memory_order_relaxed) == 0)
+		return nullptr;
+
+	std::size_t queueCount = gQueues.size();
+
+	// Our own newest job first
+	{
+		JobQueue& queue = *gQueues[tQueueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if(!queue.jobs.empty())
+		{
+			jobPointer job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+
+			gQueuedJobs.fetch_sub(1);
+			return job;
+		}
+	}
+
+	// Steal the oldest job of someone else
+	tStealSeed = tStealSeed * 1103515245 + 12345;
+	std::size_t start = tStealSeed % queueCount;
+
+	for(std::size_t i = 0; i < queueCount; i++)
+	{
+		std::size_t index = (start + i) % queueCount;
+
+		if(static_cast<int>(index) == tQueueIndex)
+			continue;
+
+		JobQueue& queue = *gQueues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if(!queue.jobs.empty())
+		{
+			jobPointer job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+
+			gQueuedJobs.fetch_sub(1);
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+// Returns false if there was nothing to run
+static bool runOneJob()
+{
+	jobPointer job = pop();
+
+	if(!job)
+		return false;
+
+	execute(job);
+	return true;
+}
+
+static void schedule(const jobPointer& job)
+{
+	if(gWorkers.empty()) // Nobody to give it to
+		execute(job);
+	else
+		push(job);
+}
+
+static void runWorker(int queueIndex)
+{
+	tQueueIndex = queueIndex;
+	tStealSeed = static_cast<unsigned int>(queueIndex);
+
+	Profiler::setThreadName("Worker " + std::to_string(queueIndex));
+
+	while(true)
+	{
+		if(runOneJob())
+			continue;
+
+		if(gStopping.load()) // Only once everything is done
+			break;
+
+		// Jobs often come in bursts, try a bit before going to sleep
+		bool foundJob = false;
+
+		for(int i = 0; i < JOB_SYSTEM_SPIN_COUNT && !foundJob; i++)
+		{
+			std::this_thread::yield();
+			foundJob = gQueuedJobs.load(std::memory_order_relaxed) > 0;
+		}
+
+		if(foundJob)
+			continue;
+
+		gSleepingWorkers.fetch_add(1);
+
+		{
+			std::unique_lock<std::mutex> lock(gSleepMutex);
+			gSleepCondition.wait(lock, []() {return gQueuedJobs.load() > 0 || gStopping.load();});
+		}
+
+		gSleepingWorkers.fetch_sub(1);
+	}
+}
+
+JobHandle::JobHandle()
+{
+	// Invalid
+}
+
+JobHandle::JobHandle(std::shared_ptr<Job> job)
+	: mJob(job)
+{
+	// Do nothing
+}
+
+bool JobHandle::isValid() const
+{
+	return mJob != nullptr;
+}
+
+bool JobHandle::isDone() const
+{
+	return !mJob || mJob->done.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<Job> JobHandle::getJob() const
+{
+	return mJob;
+}
+
+// One worker per core, minus one for the main thread (it helps when waiting)
+int getDefaultWorkerCount()
+{
+	int coreCount = static_cast<int>(std::thread::hardware_concurrency()); // 0 if unknown
+	return std::max(0, std::min(coreCount - 1, JOB_SYSTEM_MAX_WORKERS));
+}
+
+// 0 workers is fine, jobs then run on the thread that adds them
+bool start(int workerCount)
+{
+	if(!gWorkers.empty() || !gQueues.empty())
+	{
+		Utils::WARN("Job system already started!");
+		return false;
+	}
+
+	workerCount = std::max(0, std::min(workerCount, JOB_SYSTEM_MAX_WORKERS));
+
+	gStopping.store(false);
+
+	for(int i = 0; i < workerCount + 1; i++)
+		gQueues.push_back(std::unique_ptr<JobQueue>(new JobQueue));
+
+	tQueueIndex = 0;
+
+	for(int i = 1; i <= workerCount; i++)
+		gWorkers.push_back(std::thread(runWorker, i));
+
+	Utils::LOGPRINT("Job system started with " + std::to_string(workerCount) + " workers.");
+	return true;
+}
+
+void stop()
+{
+	if(gQueues.empty())
+		return;
+
+	if(isWorkerThread())
+	{
+		Utils::WARN("Cannot stop the job system from one of its workers!");
+		return;
+	}
+
+	gStopping.store(true);
+
+	{
+		std::lock_guard<std::mutex> lock(gSleepMutex);
+		gSleepCondition.notify_all();
+	}
+
+	for(auto& worker : gWorkers)
+		worker.join();
+
+	gWorkers.clear();
+
+	while(runOneJob()) // Anything added by the last jobs
+		;
+
+	gQueues.clear();
+}
+
+int getWorkerCount()
+{
+	return static_cast<int>(gWorkers.size());
+}
+
+// Workers have their own queue, everyone else shares queue 0
+bool isWorkerThread()
+{
+	return tQueueIndex != 0;
+}
+
+JobHandle add(jobFunction function)
+{
+	return add(function, jobHandleVector());
+}
+
+JobHandle add(jobFunction function, const jobHandleVector& dependencies)
+{
+	jobPointer job(new Job);
+	job->function = std::move(function);
+	job->pendingDependencies.store(static_cast<int>(dependencies.size()) + 1);
+	job->done.store(false);
+	job->finished = false;
+
+	for(const auto& dependency : dependencies)
+	{
+		jobPointer dependencyJob = dependency.getJob();
+		bool dependencyFinished = true;
+
+		if(dependencyJob)
+		{
+			std::lock_guard<std::mutex> lock(dependencyJob->continuationsMutex);
+			dependencyFinished = dependencyJob->finished;
+
+			if(!dependencyFinished)
+				dependencyJob->continuations.push_back(job);
+		}
+
+		if(dependencyFinished)
+			job->pendingDependencies.fetch_sub(1);
+	}
+
+	// Our own extra dependency
+	if(job->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		schedule(job);
+
+	return JobHandle(job);
+}
+
+JobHandle then(const JobHandle& job, jobFunction function)
+{
+	return add(std::move(function), jobHandleVector(1, job));
+}
+
+// Runs other jobs until this one is done
+void wait(const JobHandle& job)
+{
+	while(!job.isDone())
+	{
+		if(!runOneJob())
+			std::this_thread::yield(); // Someone else is running it
+	}
+}
+
+void wait(const jobHandleVector& jobs)
+{
+	for(const auto& job : jobs)
+		wait(job);
+}
+
+// Calls function on chunks of grainSize elements (or less for the last one), on all workers and this thread.
+// Returns when everything is done. Chunks are taken one at a time, so uneven chunks balance out by themselves.
+void parallelFor(int begin, int end, int grainSize, const rangeFunction& function)
+{
+	if(end <= begin)
+		return;
+
+	grainSize = std::max(1, grainSize);
+
+	int chunkCount = (end - begin + grainSize - 1) / grainSize;
+	int helperCount = std::min(getWorkerCount(), chunkCount - 1);
+
+	if(helperCount <= 0) // Not worth it, or nobody to help
+	{
+		function(begin, end);
+		return;
+	}
+
+	std::shared_ptr<std::atomic<int>> nextChunk(new std::atomic<int>(begin));
+
+	// Safe to capture the function by reference, we wait for everyone before returning
+	auto runChunks = [nextChunk, end, grainSize, &function]()
+	{
+		while(true)
+		{
+			int chunkBegin = nextChunk->fetch_add(grainSize);
+
+			if(chunkBegin >= end)
+				break;
+
+			function(chunkBegin, std::min(chunkBegin + grainSize, end));
+		}
+	};
+
+	jobHandleVector helpers;
+	helpers.reserve(helperCount);
+
+	for(int i = 0; i < helperCount; i++)
+		helpers.push_back(add(runChunks));
+
+	runChunks();
+	wait(helpers);
+}
+}
\ No newline at end of file
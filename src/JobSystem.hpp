@@ -0,0 +1,82 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Runs small jobs on a pool of worker threads.
+// Each worker has its own deque: it takes its newest job first (cache is still warm), and when it runs out,
+// it steals the oldest job of another worker. Threads that aren't workers (the main thread) share one more deque.
+//
+// Jobs can depend on other jobs, they are only started when all of their dependencies are done (see then()).
+// Waiting on a job doesn't sleep, the waiting thread runs jobs until it is done ("wait and help").
+// With no workers (start(0) or before start()), jobs simply run right away on the thread that adds them.
+//
+// Jobs must not touch OpenGL or Lua, those only work on their own thread.
+//
+// Workers are stopped when the program exits if stop() wasn't called (crashes, early returns...),
+// destroying threads that are still running would abort the program.
+
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <functional>
+#include <memory> // For smart pointers
+#include <vector>
+
+namespace JobSystem
+{
+using jobFunction = std::function<void()>;
+using rangeFunction = std::function<void(int begin, int end)>; // Does [begin, end[
+
+struct Job; // See JobSystem.cpp
+
+// Keeps the job alive, copy it around freely
+class JobHandle
+{
+private:
+	std::shared_ptr<Job> mJob;
+
+public:
+	JobHandle();
+	explicit JobHandle(std::shared_ptr<Job> job);
+
+	bool isValid() const;
+	bool isDone() const; // True for invalid handles, there is nothing to wait for
+
+	std::shared_ptr<Job> getJob() const;
+};
+
+using jobHandleVector = std::vector<JobHandle>;
+
+int getDefaultWorkerCount();
+
+bool start(int workerCount); // Call on the main thread
+void stop(); // Finishes all jobs first. Does nothing on a worker, it can't wait for itself.
+int getWorkerCount();
+bool isWorkerThread();
+
+JobHandle add(jobFunction function);
+JobHandle add(jobFunction function, const jobHandleVector& dependencies);
+JobHandle then(const JobHandle& job, jobFunction function); // Continuation, runs when job is done
+
+void wait(const JobHandle& job);
+void wait(const jobHandleVector& jobs);
+
+void parallelFor(int begin, int end, int grainSize, const rangeFunction& function);
+}
+
+#endif /* JOB_SYSTEM_HPP */
\ No newline at end of file
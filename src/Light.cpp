@@ -25,6 +25,7 @@ Light::Light()
 	mSpecularColor = glm::vec3(0.0f, 0.0f, 0.0f);
 
 	mPower = 60.0f;
+	mOnState = true;
 }
 
 Light::Light(glm::vec3 position, glm::vec3 diffuseColor, glm::vec3 specularColor, float power)
@@ -35,6 +36,7 @@ Light::Light(glm::vec3 position, glm::vec3 diffuseColor, glm::vec3 specularColor
 	mSpecularColor = specularColor;
 
 	mPower = power;
+	mOnState = true;
 }
 
 Light::~Light()
@@ -0,0 +1,933 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <MeshOptimizer.hpp>
+
+#include <Definitions.hpp>
+#include <Utils.hpp>
+#include <Profiler.hpp>
+
+#include <algorithm> // For std::sort() and std::stable_sort()
+#include <atomic>
+#include <cmath> // For std::sqrt()
+#include <cstring> // For memcpy() and memcmp()
+#include <unordered_map>
+
+#define MESH_OPTIMIZER_BORDER_WEIGHT 10.0f // Borders move much less than the rest when simplifying
+#define MESH_OPTIMIZER_MIN_FLIP_DOT 0.25f // Collapses can't turn triangles more than about 75 degrees
+
+namespace MeshOptimizer
+{
+std::atomic<bool> gEnabledOnLoad(MESH_OPTIMIZER_DEFAULT_ON_LOAD);
+std::atomic<bool> gLODsOnLoad(LOD_DEFAULT_ON_LOAD);
+
+// All attributes of a vertex, compared bit for bit
+struct VertexKey
+{
+	float values[8];
+
+	bool operator==(const VertexKey& other) const
+	{
+		return std::memcmp(values, other.values, sizeof(values)) == 0;
+	}
+};
+
+struct VertexKeyHash
+{
+	std::size_t operator()(const VertexKey& key) const
+	{
+		// FNV-1a
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.values);
+		std::size_t hash = 2166136261u;
+
+		for(std::size_t i = 0; i < sizeof(key.values); i++)
+			hash = (hash ^ bytes[i]) * 16777619u;
+
+		return hash;
+	}
+};
+
+// A FIFO post-transform cache. Entries are never moved, a vertex is in the cache if it missed less than cacheSize misses ago.
+class CacheSimulator
+{
+private:
+	std::vector<unsigned int> mMissTimes; // Per vertex
+	unsigned int mTime;
+	unsigned int mCacheSize;
+
+public:
+	CacheSimulator(std::size_t vertexCount, int cacheSize)
+		: mMissTimes(vertexCount, 0), mTime(cacheSize + 1), mCacheSize(cacheSize)
+	{
+		// Do nothing
+	}
+
+	// Returns the amount of vertices that had to be transformed (0 to 3)
+	unsigned int addTriangle(const unsigned int* triangle)
+	{
+		unsigned int misses = 0;
+
+		for(int i = 0; i < 3; i++)
+		{
+			unsigned int& missTime = mMissTimes[triangle[i]];
+
+			if(mTime - missTime > mCacheSize)
+			{
+				missTime = mTime++;
+				misses++;
+			}
+		}
+
+		return misses;
+	}
+
+	void clear()
+	{
+		mTime += mCacheSize + 1;
+	}
+};
+
+// Welds, then reorders for the cache, overdraw and fetching. Returns the ACMRs and vertex counts before and after.
+Stats optimize(uintVector& indices, vec3Vector& positions, vec2Vector& UVs, vec3Vector& normals)
+{
+	PROFILE_ZONE("MeshOptimizer::optimize");
+
+	Stats stats;
+	stats.vertexCountBefore = stats.vertexCountAfter = positions.size();
+	stats.ACMRBefore = stats.ACMRAfter = computeACMR(indices, positions.size(), MESH_OPTIMIZER_CACHE_SIZE);
+
+	bool validIndices = (indices.size() % 3 == 0);
+
+	for(std::size_t i = 0; i < indices.size() && validIndices; i++)
+		validIndices = indices[i] < positions.size();
+
+	if(!validIndices || (!UVs.empty() && UVs.size() != positions.size()) || (!normals.empty() && normals.size() != positions.size()))
+	{
+		Utils::WARN("Cannot optimize mesh, its vertex data is not coherent! It will be used as is.");
+		return stats;
+	}
+
+	std::vector<std::size_t> clusters;
+
+	std::size_t vertexCount = weldVertices(indices, positions, UVs, normals);
+	optimizeVertexCache(indices, vertexCount, MESH_OPTIMIZER_CACHE_SIZE, clusters);
+	optimizeOverdraw(indices, positions, clusters, MESH_OPTIMIZER_CACHE_SIZE, MESH_OPTIMIZER_OVERDRAW_THRESHOLD);
+	optimizeVertexFetch(indices, positions, UVs, normals);
+
+	stats.vertexCountAfter = positions.size();
+	stats.ACMRAfter = computeACMR(indices, positions.size(), MESH_OPTIMIZER_CACHE_SIZE);
+
+	return stats;
+}
+
+// Vertices are kept in the order they are first seen
+std::size_t weldVertices(uintVector& indices, vec3Vector& positions, vec2Vector& UVs, vec3Vector& normals)
+{
+	std::size_t vertexCount = positions.size();
+	bool hasUVs = !UVs.empty();
+	bool hasNormals = !normals.empty();
+
+	std::unordered_map<VertexKey, unsigned int, VertexKeyHash> uniqueVertices;
+	uniqueVertices.reserve(vertexCount);
+
+	uintVector remap(vertexCount);
+	std::size_t uniqueCount = 0;
+
+	for(std::size_t i = 0; i < vertexCount; i++)
+	{
+		VertexKey key = VertexKey();
+		std::memcpy(key.values, &positions[i], sizeof(glm::vec3));
+
+		if(hasUVs)
+			std::memcpy(key.values + 3, &UVs[i], sizeof(glm::vec2));
+
+		if(hasNormals)
+			std::memcpy(key.values + 5, &normals[i], sizeof(glm::vec3));
+
+		auto inserted = uniqueVertices.insert(std::make_pair(key, static_cast<unsigned int>(uniqueCount)));
+
+		if(inserted.second) // New one, move it next to the other unique ones
+		{
+			positions[uniqueCount] = positions[i];
+
+			if(hasUVs)
+				UVs[uniqueCount] = UVs[i];
+
+			if(hasNormals)
+				normals[uniqueCount] = normals[i];
+
+			uniqueCount++;
+		}
+
+		remap[i] = inserted.first->second;
+	}
+
+	for(auto& index : indices)
+		index = remap[index];
+
+	positions.resize(uniqueCount);
+
+	if(hasUVs)
+		UVs.resize(uniqueCount);
+
+	if(hasNormals)
+		normals.resize(uniqueCount);
+
+	return uniqueCount;
+}
+
+// Tipsify. From the current vertex, all of its triangles are emitted, then we go on with the vertex that will still be
+// in the cache after its own triangles are emitted, and has been there the longest. If none will, we jump back
+// to a recent vertex that still has triangles (dead end), which starts a new cluster.
+void optimizeVertexCache(uintVector& indices, std::size_t vertexCount, int cacheSize, std::vector<std::size_t>& clusters)
+{
+	std::size_t triangleCount = indices.size() / 3;
+
+	clusters.clear();
+
+	if(triangleCount == 0)
+		return;
+
+	// Triangles of each vertex, all in one vector
+	std::vector<unsigned int> liveTriangles(vertexCount, 0);
+
+	for(auto index : indices)
+		liveTriangles[index]++;
+
+	std::vector<std::size_t> firstTriangle(vertexCount + 1, 0);
+
+	for(std::size_t i = 0; i < vertexCount; i++)
+		firstTriangle[i + 1] = firstTriangle[i] + liveTriangles[i];
+
+	std::vector<unsigned int> vertexTriangles(indices.size());
+	std::vector<std::size_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+
+	for(std::size_t i = 0; i < indices.size(); i++)
+		vertexTriangles[filled[indices[i]]++] = static_cast<unsigned int>(i / 3);
+
+	std::vector<unsigned int> cacheTimes(vertexCount, 0);
+	unsigned int time = cacheSize + 1;
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEnds; // Stack of recently used vertices
+	std::vector<unsigned int> candidates;
+	std::size_t cursor = 0; // Vertices before it have no triangles left
+
+	uintVector output;
+	output.reserve(indices.size());
+
+	// Last resort when we are stuck: a recent vertex, or the next one in order
+	auto skipDeadEnd = [&]() -> int
+	{
+		while(!deadEnds.empty())
+		{
+			unsigned int vertex = deadEnds.back();
+			deadEnds.pop_back();
+
+			if(liveTriangles[vertex] > 0)
+				return static_cast<int>(vertex);
+		}
+
+		for(; cursor < vertexCount; cursor++)
+		{
+			if(liveTriangles[cursor] > 0)
+				return static_cast<int>(cursor);
+		}
+
+		return -1;
+	};
+
+	int vertex = skipDeadEnd();
+	clusters.push_back(0);
+
+	while(vertex >= 0)
+	{
+		candidates.clear();
+
+		for(std::size_t i = firstTriangle[vertex]; i < firstTriangle[vertex + 1]; i++)
+		{
+			unsigned int triangle = vertexTriangles[i];
+
+			if(emitted[triangle])
+				continue;
+
+			for(int j = 0; j < 3; j++)
+			{
+				unsigned int triangleVertex = indices[triangle * 3 + j];
+
+				output.push_back(triangleVertex);
+				deadEnds.push_back(triangleVertex);
+				candidates.push_back(triangleVertex);
+				liveTriangles[triangleVertex]--;
+
+				if(time - cacheTimes[triangleVertex] > static_cast<unsigned int>(cacheSize)) // Not in the cache
+					cacheTimes[triangleVertex] = time++;
+			}
+
+			emitted[triangle] = true;
+		}
+
+		// Next vertex: the oldest in the cache that will still be there after its triangles
+		int nextVertex = -1;
+		int bestPriority = -1;
+
+		for(auto candidate : candidates)
+		{
+			if(liveTriangles[candidate] == 0)
+				continue;
+
+			int priority = 0;
+			int age = static_cast<int>(time - cacheTimes[candidate]);
+
+			if(age + 2 * static_cast<int>(liveTriangles[candidate]) <= cacheSize)
+				priority = age;
+
+			if(priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = static_cast<int>(candidate);
+			}
+		}
+
+		if(nextVertex < 0)
+		{
+			nextVertex = skipDeadEnd();
+
+			if(nextVertex >= 0)
+				clusters.push_back(output.size() / 3);
+		}
+
+		vertex = nextVertex;
+	}
+
+	indices.swap(output);
+}
+
+// Cuts the clusters smaller where the cache doesn't mind, then draws the clusters facing away from the center first
+void optimizeOverdraw(uintVector& indices, const vec3Vector& positions, const std::vector<std::size_t>& clusters, int cacheSize, float threshold)
+{
+	std::size_t triangleCount = indices.size() / 3;
+
+	if(triangleCount == 0 || clusters.empty())
+		return;
+
+	// Soft boundaries: a new cluster starts when the triangles since the last one did about as well as the whole cluster
+	std::vector<std::size_t> softClusters;
+	CacheSimulator cache(positions.size(), cacheSize);
+
+	for(std::size_t i = 0; i < clusters.size(); i++)
+	{
+		std::size_t begin = clusters[i];
+		std::size_t end = (i + 1 < clusters.size()) ? clusters[i + 1] : triangleCount;
+
+		unsigned int clusterMisses = 0;
+		cache.clear();
+
+		for(std::size_t triangle = begin; triangle < end; triangle++)
+			clusterMisses += cache.addTriangle(&indices[triangle * 3]);
+
+		float maxACMR = static_cast<float>(clusterMisses) / (end - begin) * threshold;
+
+		softClusters.push_back(begin);
+		std::size_t softBegin = begin;
+		unsigned int misses = 0;
+		cache.clear();
+
+		for(std::size_t triangle = begin; triangle < end; triangle++)
+		{
+			misses += cache.addTriangle(&indices[triangle * 3]);
+
+			if(triangle + 1 < end && misses <= maxACMR * (triangle + 1 - softBegin))
+			{
+				softClusters.push_back(triangle + 1);
+				softBegin = triangle + 1;
+				misses = 0;
+				cache.clear();
+			}
+		}
+	}
+
+	// Centers and normals are weighted by area (the cross product is twice the area)
+	struct Cluster
+	{
+		std::size_t begin;
+		std::size_t end;
+		glm::vec3 center;
+		glm::vec3 normal;
+		float sortKey;
+	};
+
+	std::vector<Cluster> sortedClusters(softClusters.size());
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+
+	for(std::size_t i = 0; i < softClusters.size(); i++)
+	{
+		Cluster& cluster = sortedClusters[i];
+		cluster.begin = softClusters[i];
+		cluster.end = (i + 1 < softClusters.size()) ? softClusters[i + 1] : triangleCount;
+		cluster.center = cluster.normal = glm::vec3(0.0f);
+
+		float clusterArea = 0.0f;
+
+		for(std::size_t triangle = cluster.begin; triangle < cluster.end; triangle++)
+		{
+			const glm::vec3& a = positions[indices[triangle * 3]];
+			const glm::vec3& b = positions[indices[triangle * 3 + 1]];
+			const glm::vec3& c = positions[indices[triangle * 3 + 2]];
+
+			glm::vec3 cross = glm::cross(b - a, c - a);
+			float area = glm::length(cross);
+
+			cluster.center += (a + b + c) * (area / 3.0f);
+			cluster.normal += cross;
+			clusterArea += area;
+		}
+
+		meshCenter += cluster.center;
+		meshArea += clusterArea;
+
+		if(clusterArea > 0.0f)
+			cluster.center /= clusterArea;
+	}
+
+	if(meshArea > 0.0f)
+		meshCenter /= meshArea;
+
+	for(auto& cluster : sortedClusters)
+	{
+		float normalLength = glm::length(cluster.normal);
+		cluster.sortKey = (normalLength > 0.0f) ? glm::dot(cluster.center - meshCenter, cluster.normal / normalLength) : 0.0f;
+	}
+
+	// Most outwards first
+	std::stable_sort(sortedClusters.begin(), sortedClusters.end(),
+		[](const Cluster& a, const Cluster& b) {return a.sortKey > b.sortKey;});
+
+	uintVector output;
+	output.reserve(indices.size());
+
+	for(const auto& cluster : sortedClusters)
+		output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+
+	indices.swap(output);
+}
+
+// Vertices in the order the triangles first use them. Unused vertices are dropped.
+void optimizeVertexFetch(uintVector& indices, vec3Vector& positions, vec2Vector& UVs, vec3Vector& normals)
+{
+	const unsigned int unused = static_cast<unsigned int>(-1);
+
+	uintVector remap(positions.size(), unused);
+	unsigned int vertexCount = 0;
+
+	for(auto& index : indices)
+	{
+		if(remap[index] == unused)
+			remap[index] = vertexCount++;
+
+		index = remap[index];
+	}
+
+	vec3Vector newPositions(vertexCount);
+	vec2Vector newUVs(UVs.empty() ? 0 : vertexCount);
+	vec3Vector newNormals(normals.empty() ? 0 : vertexCount);
+
+	for(std::size_t i = 0; i < remap.size(); i++)
+	{
+		if(remap[i] == unused)
+			continue;
+
+		newPositions[remap[i]] = positions[i];
+
+		if(!UVs.empty())
+			newUVs[remap[i]] = UVs[i];
+
+		if(!normals.empty())
+			newNormals[remap[i]] = normals[i];
+	}
+
+	positions.swap(newPositions);
+	UVs.swap(newUVs);
+	normals.swap(newNormals);
+}
+
+float computeACMR(const uintVector& indices, std::size_t vertexCount, int cacheSize)
+{
+	std::size_t triangleCount = indices.size() / 3;
+
+	if(triangleCount == 0)
+		return 0.0f;
+
+	CacheSimulator cache(vertexCount, cacheSize);
+	std::size_t misses = 0;
+
+	for(std::size_t triangle = 0; triangle < triangleCount; triangle++)
+		misses += cache.addTriangle(&indices[triangle * 3]);
+
+	return static_cast<float>(misses) / triangleCount;
+}
+
+// Weighted sum of squared distances to planes, as a symmetric 4x4 matrix. Doubles, the sums get big.
+struct Quadric
+{
+	double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+	double weight; // Of all the planes
+
+	Quadric()
+		: a2(0.0), ab(0.0), ac(0.0), ad(0.0), b2(0.0), bc(0.0), bd(0.0), c2(0.0), cd(0.0), d2(0.0), weight(0.0)
+	{
+		// Do nothing
+	}
+
+	// Plane ax + by + cz + d = 0, with a normalized normal
+	Quadric(const glm::vec3& normal, float d, float weight)
+	{
+		double a = normal.x, b = normal.y, c = normal.z;
+
+		a2 = a * a * weight; ab = a * b * weight; ac = a * c * weight; ad = a * d * weight;
+		b2 = b * b * weight; bc = b * c * weight; bd = b * d * weight;
+		c2 = c * c * weight; cd = c * d * weight;
+		d2 = static_cast<double>(d) * d * weight;
+		this->weight = weight;
+	}
+
+	Quadric& operator+=(const Quadric& other)
+	{
+		a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+		b2 += other.b2; bc += other.bc; bd += other.bd;
+		c2 += other.c2; cd += other.cd;
+		d2 += other.d2;
+		weight += other.weight;
+
+		return *this;
+	}
+
+	// Average squared distance to the planes, so the error is a distance whatever the weights are
+	double evaluate(const glm::vec3& point) const
+	{
+		double x = point.x, y = point.y, z = point.z;
+
+		double result = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+			+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+			+ c2 * z * z + 2.0 * cd * z
+			+ d2;
+
+		return (weight > 0.0) ? std::max(result / weight, 0.0) : 0.0;
+	}
+};
+
+struct Collapse
+{
+	double cost;
+	unsigned int from;
+	unsigned int to;
+
+	bool operator<(const Collapse& other) const
+	{
+		return cost < other.cost;
+	}
+};
+
+// Works on positions, so vertices split by UVs or normals move together. Triangles are then given back the vertex
+// at their new position with the closest UV and normal. Each pass collapses the cheapest edges that don't touch each other,
+// until the target is reached or the next edge would be past the max error.
+uintVector simplify(const uintVector& indices, const vec3Vector& positions, const vec2Vector& UVs, const vec3Vector& normals,
+	std::size_t targetIndexCount, float maxError, float* error)
+{
+	PROFILE_ZONE("MeshOptimizer::simplify");
+
+	if(error)
+		*error = 0.0f;
+
+	// Same position, same point
+	std::unordered_map<VertexKey, unsigned int, VertexKeyHash> uniquePositions;
+	uintVector pointOfVertex(positions.size());
+	vec3Vector points;
+
+	for(std::size_t i = 0; i < positions.size(); i++)
+	{
+		VertexKey key = VertexKey();
+		std::memcpy(key.values, &positions[i], sizeof(glm::vec3));
+
+		auto inserted = uniquePositions.insert(std::make_pair(key, static_cast<unsigned int>(points.size())));
+
+		if(inserted.second)
+			points.push_back(positions[i]);
+
+		pointOfVertex[i] = inserted.first->second;
+	}
+
+	std::size_t pointCount = points.size();
+	std::size_t triangleCount = indices.size() / 3;
+
+	// Triangles of points, and which triangle of the input each one is
+	uintVector triangles(triangleCount * 3);
+	uintVector sourceTriangles(triangleCount);
+
+	for(std::size_t i = 0; i < triangleCount; i++)
+	{
+		for(int j = 0; j < 3; j++)
+			triangles[i * 3 + j] = pointOfVertex[indices[i * 3 + j]];
+
+		sourceTriangles[i] = static_cast<unsigned int>(i);
+	}
+
+	// Planes of the triangles around each point, weighted by area
+	std::vector<Quadric> quadrics(pointCount);
+	std::vector<std::pair<unsigned int, unsigned int>> edges; // Sorted points, to find borders
+
+	for(std::size_t i = 0; i < triangleCount; i++)
+	{
+		const glm::vec3& a = points[triangles[i * 3]];
+		const glm::vec3& b = points[triangles[i * 3 + 1]];
+		const glm::vec3& c = points[triangles[i * 3 + 2]];
+
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		float length = glm::length(normal);
+
+		if(length <= 0.0f)
+			continue;
+
+		normal /= length;
+		Quadric quadric(normal, -glm::dot(normal, a), length * 0.5f);
+
+		for(int j = 0; j < 3; j++)
+		{
+			unsigned int first = triangles[i * 3 + j];
+			unsigned int second = triangles[i * 3 + (j + 1) % 3];
+
+			quadrics[first] += quadric;
+			edges.push_back(std::make_pair(std::min(first, second), std::max(first, second)));
+		}
+	}
+
+	// Edges of only one triangle are borders: a plane along them, perpendicular to the triangle, keeps them in place
+	std::sort(edges.begin(), edges.end());
+
+	for(std::size_t i = 0; i < triangleCount; i++)
+	{
+		const glm::vec3& a = points[triangles[i * 3]];
+		glm::vec3 faceNormal = glm::cross(points[triangles[i * 3 + 1]] - a, points[triangles[i * 3 + 2]] - a);
+
+		if(glm::length(faceNormal) <= 0.0f)
+			continue;
+
+		faceNormal = glm::normalize(faceNormal);
+
+		for(int j = 0; j < 3; j++)
+		{
+			unsigned int first = triangles[i * 3 + j];
+			unsigned int second = triangles[i * 3 + (j + 1) % 3];
+			std::pair<unsigned int, unsigned int> edge(std::min(first, second), std::max(first, second));
+
+			auto range = std::equal_range(edges.begin(), edges.end(), edge);
+
+			if(range.second - range.first != 1)
+				continue;
+
+			glm::vec3 edgeVector = points[second] - points[first];
+			float edgeLength = glm::length(edgeVector);
+			glm::vec3 borderNormal = glm::cross(edgeVector, faceNormal);
+
+			if(edgeLength <= 0.0f || glm::length(borderNormal) <= 0.0f)
+				continue;
+
+			borderNormal = glm::normalize(borderNormal);
+			Quadric quadric(borderNormal, -glm::dot(borderNormal, points[first]), edgeLength * edgeLength * MESH_OPTIMIZER_BORDER_WEIGHT);
+
+			quadrics[first] += quadric;
+			quadrics[second] += quadric;
+		}
+	}
+
+	double maxCost = static_cast<double>(maxError) * maxError;
+	double reachedCost = 0.0;
+
+	std::vector<Collapse> collapses;
+	std::vector<std::size_t> firstTriangle(pointCount + 1);
+	uintVector pointTriangles;
+	uintVector remap(pointCount);
+	std::vector<bool> locked(pointCount);
+
+	while(triangleCount * 3 > targetIndexCount)
+	{
+		// Triangles around each point
+		std::fill(firstTriangle.begin(), firstTriangle.end(), 0);
+
+		for(std::size_t i = 0; i < triangleCount * 3; i++)
+			firstTriangle[triangles[i] + 1]++;
+
+		for(std::size_t i = 0; i < pointCount; i++)
+			firstTriangle[i + 1] += firstTriangle[i];
+
+		pointTriangles.resize(triangleCount * 3);
+		std::vector<std::size_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+
+		for(std::size_t i = 0; i < triangleCount * 3; i++)
+			pointTriangles[filled[triangles[i]]++] = static_cast<unsigned int>(i / 3);
+
+		// Each edge collapses into whichever end is cheaper
+		collapses.clear();
+
+		for(std::size_t i = 0; i < triangleCount * 3; i++)
+		{
+			unsigned int first = triangles[i];
+			unsigned int second = triangles[i - i % 3 + (i + 1) % 3];
+
+			// Edges between two triangles are tried twice, the second one is locked by then
+			Quadric quadric = quadrics[first];
+			quadric += quadrics[second];
+
+			Collapse collapse;
+			double toSecond = quadric.evaluate(points[second]);
+			double toFirst = quadric.evaluate(points[first]);
+
+			collapse.cost = std::min(toSecond, toFirst);
+			collapse.from = (toSecond <= toFirst) ? first : second;
+			collapse.to = (toSecond <= toFirst) ? second : first;
+
+			if(collapse.cost <= maxCost)
+				collapses.push_back(collapse);
+		}
+
+		std::sort(collapses.begin(), collapses.end());
+
+		for(std::size_t i = 0; i < pointCount; i++)
+			remap[i] = static_cast<unsigned int>(i);
+
+		std::fill(locked.begin(), locked.end(), false);
+
+		std::size_t trianglesToRemove = triangleCount - targetIndexCount / 3;
+		std::size_t removedTriangles = 0;
+		int collapseCount = 0;
+
+		for(const auto& collapse : collapses)
+		{
+			if(removedTriangles >= trianglesToRemove)
+				break;
+
+			if(locked[collapse.from] || locked[collapse.to])
+				continue;
+
+			// Triangles around from must not fold over
+			bool flips = false;
+			std::size_t sharedTriangles = 0;
+
+			for(std::size_t j = firstTriangle[collapse.from]; j < firstTriangle[collapse.from + 1] && !flips; j++)
+			{
+				const unsigned int* triangle = &triangles[pointTriangles[j] * 3];
+
+				if(triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+				{
+					sharedTriangles++; // Disappears
+					continue;
+				}
+
+				glm::vec3 corners[3];
+				glm::vec3 newCorners[3];
+
+				for(int k = 0; k < 3; k++)
+				{
+					corners[k] = points[triangle[k]];
+					newCorners[k] = (triangle[k] == collapse.from) ? points[collapse.to] : corners[k];
+				}
+
+				glm::vec3 oldNormal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+				glm::vec3 newNormal = glm::cross(newCorners[1] - newCorners[0], newCorners[2] - newCorners[0]);
+
+				float oldLength = glm::length(oldNormal);
+				float newLength = glm::length(newNormal);
+
+				if(oldLength > 0.0f && (newLength <= 0.0f || glm::dot(oldNormal, newNormal) < MESH_OPTIMIZER_MIN_FLIP_DOT * oldLength * newLength))
+					flips = true;
+			}
+
+			if(flips)
+				continue;
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+
+			// Nothing around it changes again this pass, so the checks above stay true
+			for(std::size_t j = firstTriangle[collapse.from]; j < firstTriangle[collapse.from + 1]; j++)
+			{
+				for(int k = 0; k < 3; k++)
+					locked[triangles[pointTriangles[j] * 3 + k]] = true;
+			}
+
+			removedTriangles += sharedTriangles;
+			reachedCost = std::max(reachedCost, collapse.cost);
+			collapseCount++;
+		}
+
+		if(collapseCount == 0) // Everything left is too costly
+			break;
+
+		// Keep the triangles that still have 3 different points
+		std::size_t keptCount = 0;
+
+		for(std::size_t i = 0; i < triangleCount; i++)
+		{
+			unsigned int a = remap[triangles[i * 3]];
+			unsigned int b = remap[triangles[i * 3 + 1]];
+			unsigned int c = remap[triangles[i * 3 + 2]];
+
+			if(a == b || b == c || a == c)
+				continue;
+
+			triangles[keptCount * 3] = a;
+			triangles[keptCount * 3 + 1] = b;
+			triangles[keptCount * 3 + 2] = c;
+			sourceTriangles[keptCount] = sourceTriangles[i];
+			keptCount++;
+		}
+
+		triangleCount = keptCount;
+	}
+
+	// Back to vertices: the original one if the corner didn't move, or the one at the new point that looks the most like it
+	std::vector<std::size_t> firstVertex(pointCount + 1, 0);
+	uintVector pointVertices(positions.size());
+
+	for(auto point : pointOfVertex)
+		firstVertex[point + 1]++;
+
+	for(std::size_t i = 0; i < pointCount; i++)
+		firstVertex[i + 1] += firstVertex[i];
+
+	std::vector<std::size_t> filled(firstVertex.begin(), firstVertex.end() - 1);
+
+	for(std::size_t i = 0; i < positions.size(); i++)
+		pointVertices[filled[pointOfVertex[i]]++] = static_cast<unsigned int>(i);
+
+	uintVector result(triangleCount * 3);
+
+	for(std::size_t i = 0; i < triangleCount; i++)
+	{
+		for(int j = 0; j < 3; j++)
+		{
+			unsigned int vertex = indices[sourceTriangles[i] * 3 + j];
+			unsigned int point = triangles[i * 3 + j];
+
+			if(pointOfVertex[vertex] != point)
+			{
+				float bestDistance = -1.0f;
+				unsigned int bestVertex = pointVertices[firstVertex[point]];
+
+				for(std::size_t k = firstVertex[point]; k < firstVertex[point + 1]; k++)
+				{
+					unsigned int candidate = pointVertices[k];
+					float distance = 0.0f;
+
+					if(!UVs.empty())
+						distance += glm::dot(UVs[candidate] - UVs[vertex], UVs[candidate] - UVs[vertex]);
+
+					if(!normals.empty())
+						distance += glm::dot(normals[candidate] - normals[vertex], normals[candidate] - normals[vertex]);
+
+					if(bestDistance < 0.0f || distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestVertex = candidate;
+					}
+				}
+
+				vertex = bestVertex;
+			}
+
+			result[i * 3 + j] = vertex;
+		}
+	}
+
+	if(error)
+		*error = static_cast<float>(std::sqrt(reachedCost));
+
+	return result;
+}
+
+// Each level is simplified from the full geometry, with fewer triangles and more error allowed than the last one
+std::vector<uintVector> generateLODs(const uintVector& indices, const vec3Vector& positions, const vec2Vector& UVs, const vec3Vector& normals)
+{
+	std::vector<uintVector> levels;
+
+	if(indices.size() / 3 < LOD_MIN_TRIANGLES || positions.empty())
+		return levels;
+
+	PROFILE_ZONE("MeshOptimizer::generateLODs");
+
+	// The radius of the bounding sphere, like ObjectGeometry
+	glm::vec3 boundsMin = positions.front();
+	glm::vec3 boundsMax = positions.front();
+
+	for(const auto& position : positions)
+	{
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
+	}
+
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radius = 0.0f;
+
+	for(const auto& position : positions)
+		radius = std::max(radius, glm::length(position - center));
+
+	std::size_t lastIndexCount = indices.size();
+	float ratio = 1.0f;
+	float maxError = LOD_MAX_ERROR * radius;
+
+	for(int level = 1; level < LOD_MAX_LEVELS; level++)
+	{
+		ratio *= LOD_TRIANGLE_RATIO;
+
+		std::size_t targetIndexCount = static_cast<std::size_t>(indices.size() / 3 * ratio) * 3;
+		uintVector levelIndices = simplify(indices, positions, UVs, normals, targetIndexCount, maxError);
+
+		if(levelIndices.size() > lastIndexCount * LOD_MIN_REDUCTION) // Not worth it, the next ones wouldn't be either
+			break;
+
+		lastIndexCount = levelIndices.size();
+		levels.push_back(std::move(levelIndices));
+
+		maxError *= 2.0f;
+	}
+
+	return levels;
+}
+
+void setEnabledOnLoad(bool enabled)
+{
+	gEnabledOnLoad.store(enabled);
+}
+
+bool isEnabledOnLoad()
+{
+	return gEnabledOnLoad.load();
+}
+
+void setLODsOnLoad(bool enabled)
+{
+	gLODsOnLoad.store(enabled);
+}
+
+bool areLODsOnLoad()
+{
+	return gLODsOnLoad.load();
+}
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Reorders triangles and vertices so the GPU runs the vertex shader fewer times and draws fewer hidden pixels.
+// Doesn't touch OpenGL, works on plain vectors: parseOBJFile() uses it on any thread, and a tool can run it offline.
+//
+// optimize() does all of it, in this order:
+// - Welding: vertices with exactly the same position, UV and normal become one.
+// - Vertex cache: Tipsify (Sander et al. 2007) orders triangles so vertices are reused while they are still in the
+//   post-transform cache. It also finds clusters, where the order jumps somewhere else.
+// - Overdraw: clusters facing outwards (away from the center) are drawn first, they usually hide the others.
+//   Clusters are cut smaller when that barely hurts the cache (MESH_OPTIMIZER_OVERDRAW_THRESHOLD).
+// - Vertex fetch: vertices are stored in the order the triangles use them, so fetching them is cache friendly.
+//
+// simplify() is quadric error metric edge collapse (Garland and Heckbert 1997), generateLODs() makes a chain of them.
+//
+// The ACMR (average cache miss ratio) is vertex shader runs per triangle, with a simulated FIFO cache.
+// 3 is the worst, 0.5 is about the best a big regular mesh can do.
+
+#ifndef MESH_OPTIMIZER_HPP
+#define MESH_OPTIMIZER_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstddef> // For std::size_t
+#include <vector>
+
+namespace MeshOptimizer
+{
+using uintVector = std::vector<unsigned int>;
+using vec2Vector = std::vector<glm::vec2>;
+using vec3Vector = std::vector<glm::vec3>;
+
+struct Stats
+{
+	std::size_t vertexCountBefore;
+	std::size_t vertexCountAfter;
+	float ACMRBefore;
+	float ACMRAfter;
+};
+
+// UVs and normals can be empty, or have as many elements as positions
+Stats optimize(uintVector& indices, vec3Vector& positions, vec2Vector& UVs, vec3Vector& normals);
+
+std::size_t weldVertices(uintVector& indices, vec3Vector& positions, vec2Vector& UVs, vec3Vector& normals); // Returns the new vertex count
+void optimizeVertexCache(uintVector& indices, std::size_t vertexCount, int cacheSize, std::vector<std::size_t>& clusters); // Clusters are first triangles
+void optimizeOverdraw(uintVector& indices, const vec3Vector& positions, const std::vector<std::size_t>& clusters, int cacheSize, float threshold);
+void optimizeVertexFetch(uintVector& indices, vec3Vector& positions, vec2Vector& UVs, vec3Vector& normals);
+
+float computeACMR(const uintVector& indices, std::size_t vertexCount, int cacheSize);
+
+// Returns fewer triangles using the same vertices, targetIndexCount or more if the error would go past maxError.
+// The error is a distance, in the same units as the positions. The error reached goes in error if it isn't null.
+uintVector simplify(const uintVector& indices, const vec3Vector& positions, const vec2Vector& UVs, const vec3Vector& normals,
+	std::size_t targetIndexCount, float maxError, float* error = nullptr);
+
+// Indices of each level after the full geometry, see LOD_*. Can be empty if the geometry is too small or can't be simplified.
+std::vector<uintVector> generateLODs(const uintVector& indices, const vec3Vector& positions, const vec2Vector& UVs, const vec3Vector& normals);
+
+// For parseOBJFile(), from any thread
+void setEnabledOnLoad(bool enabled);
+bool isEnabledOnLoad();
+void setLODsOnLoad(bool enabled);
+bool areLODsOnLoad();
+}
+
+#endif /* MESH_OPTIMIZER_HPP */
\ No newline at end of file
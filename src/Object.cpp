@@ -64,41 +64,46 @@ Object::constShaderPointer Object::getShader() const
 }
 
 // Virtual
-void Object::render(const Camera& camera)
+// Copies what we need to render this object later (maybe on another thread)
+// If you override this, set your own render functions too (renderInstances can be null)
+// The matrices are set afterwards for all objects at once, from the physics body (see EntityManager::snapshot())
+void Object::snapshot(ObjectSnapshot& snapshot, float interpolation) const
 {
-	glm::vec3 color(0.5f, 0.5f, 0.5f);
+	snapshot.render = &Object::renderSnapshot;
+	snapshot.renderInstances = &Object::renderInstancedSnapshot;
 
-	const ObjectGeometry::uintBuffer& indexBuffer = mObjectGeometry->getIndexBuffer();
-	const ObjectGeometry::vec3Buffer& positionBuffer = mObjectGeometry->getPositionBuffer();
-
-	glm::mat4 modelMatrix = getPhysicsBody().generateModelMatrix();
-	glm::mat4 MVP = camera.getProjectionMatrix() * camera.getViewMatrix() * modelMatrix;
+	snapshot.objectGeometry = mObjectGeometry;
+	snapshot.shader = mShaderPointer;
+	snapshot.texture = nullptr;
+}
 
-	glUseProgram(mShaderPointer->getID());
-	glUniformMatrix4fv(mShaderPointer->findUniform("MVP"), 1, GL_FALSE, &MVP[0][0]);
-	glUniform3f(mShaderPointer->findUniform("color"), color.r, color.g, color.b);
+// Static
+void Object::renderSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue)
+{
+	const Shader& shader = *object.shader;
 
-	glEnableVertexAttribArray(0); // Number to give to OpenGL VertexAttribPointer
-	positionBuffer.bind(GL_ARRAY_BUFFER);
+	// Values that didn't change since the last object aren't sent again
+	queue.useShader(shader);
+	shader.setUniform(SHADER_UNIFORM_COLOR, glm::vec3(0.5f, 0.5f, 0.5f));
+	shader.setUniform(SHADER_UNIFORM_MVP, object.mvpMatrix);
 
-	// Give it to the shader. Each time the vertex shader runs, it will get the next element of this buffer.
-	glVertexAttribPointer(
-		0,					// Attribute 0, no particular reason but same as the vertex shader's layout and glEnableVertexAttribArray
-		3,					// Size. Number of values per vertex, must be 1, 2, 3 or 4.
-		GL_FLOAT,			// Type of data (GLfloats)
-		GL_FALSE,			// Normalized?
-		0,					// Stride
-		(void*)0			// Array buffer offset
-	);
+	queue.bindGeometry(*object.objectGeometry, object.arenaLocation, VERTEX_LAYOUT_POSITIONS);
 
 	// Draw!
 	// Use the index buffer, more efficient!
-	glDrawElements(
-		GL_TRIANGLES,            // Mode
-		indexBuffer.getLength(), // Count
-		GL_UNSIGNED_INT,         // Type
-		(void*)0                 // Element array buffer offset
-	);
-
-	glDisableVertexAttribArray(0);
+	queue.drawElements();
 }
+
+// Static
+// With the instanced variant of the shader (see Shader::getInstancedVariant())
+void Object::renderInstancedSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue,
+	int firstInstance, int instanceCount)
+{
+	const Shader& shader = *object.shader->getInstancedVariant();
+
+	queue.useShader(shader); // The camera is in a uniform block
+	shader.setUniform(SHADER_UNIFORM_COLOR, glm::vec3(0.5f, 0.5f, 0.5f));
+
+	queue.bindGeometry(*object.objectGeometry, object.arenaLocation, VERTEX_LAYOUT_POSITIONS, true);
+	queue.drawElementsInstanced(firstInstance, instanceCount);
+}
\ No newline at end of file
@@ -23,6 +23,7 @@
 #include <Entity.hpp>
 #include <ObjectGeometry.hpp>
 #include <Camera.hpp>
+#include <SceneSnapshot.hpp>
 
 #include <glm/glm.hpp>
 #include <glad/glad.h> // OpenGL, rendering and all
@@ -48,7 +49,12 @@ public:
 	void setShader(constShaderPointer shaderPointer);
 	constShaderPointer getShader() const;
 
-	virtual void render(const Camera& camera); // Override this if you need to!
+	// Interpolation is how far we are between the last step and the next one, see PhysicsBody::generateModelMatrix(float)
+	virtual void snapshot(ObjectSnapshot& snapshot, float interpolation) const; // Override this if you need to!
+
+	static void renderSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue);
+	static void renderInstancedSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue,
+		int firstInstance, int instanceCount);
 };
 
 #endif /* OBJECT_HPP */
\ No newline at end of file
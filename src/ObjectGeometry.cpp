@@ -20,24 +20,256 @@
 #include <ObjectGeometry.hpp>
 #include <Utils.hpp> // For vector stuff and error messages
 
+#include <glm/gtc/packing.hpp> // For packSnorm3x10_1x2()
+
+#include <algorithm> // For std::max()
+#include <cmath> // For std::sqrt()
+#include <cstddef> // For offsetof()
+#include <mutex>
+
+// VAOs of deleted geometry. The last owner can let go of it on any thread (the game thread, with another context),
+// but VAOs can only be deleted on the context that created them, see deleteOrphanedVertexArrays().
+std::mutex gOrphanedVertexArraysMutex;
+std::vector<GLuint> gOrphanedVertexArrays;
+
 // ObjectGeometry
 
 ObjectGeometry::ObjectGeometry(const std::string& name,
-							   const uintVector& indices, const vec3Vector& positions, const vec2Vector& UVs, const vec3Vector& normals)
-							   : mIndexBuffer(GL_ELEMENT_ARRAY_BUFFER) // A special type of buffer
+							   const uintVector& indices, const vec3Vector& positions, const vec2Vector& UVs, const vec3Vector& normals,
+							   int vertexFormat)
+							   : mIndexBuffer(GL_ELEMENT_ARRAY_BUFFER), // A special type of buffer
+							     mShortIndexBuffer(GL_ELEMENT_ARRAY_BUFFER)
 {
 	mName = name;
+	mVertexFormat = Utils::isHeadless() ? VERTEX_FORMAT_SEPARATE : vertexFormat; // Nothing is drawn anyway
+	mIndexType = GL_UNSIGNED_INT;
+
+	if(mVertexFormat == VERTEX_FORMAT_PACKED)
+	{
+		packVertices(indices, positions, UVs, normals);
+
+		// Only the packed buffers (or the arena) are drawn
+		if(mIndexType == GL_UNSIGNED_SHORT || mArenaRange)
+			mIndexBuffer.setCPUSide();
+		else
+			mIndexBuffer.setKeepsCPUCopy(true);
+
+		mPositionBuffer.setCPUSide();
+		mUVBuffer.setCPUSide();
+		mNormalBuffer.setCPUSide();
+	} else
+	{
+		mIndexBuffer.setKeepsCPUCopy(true);
+		mPositionBuffer.setKeepsCPUCopy(true);
+	}
 	
 	// GL_STATIC_DRAW as a hint to OpenGL that we probably won't change the data
 	mIndexBuffer.setMutableData(indices, GL_STATIC_DRAW);
 	mPositionBuffer.setMutableData(positions, GL_STATIC_DRAW);
 	mUVBuffer.setMutableData(UVs, GL_STATIC_DRAW);
 	mNormalBuffer.setMutableData(normals, GL_STATIC_DRAW);
+
+	computeBounds(positions);
+
+	for(int i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+		mVertexArrays[0][i] = mVertexArrays[1][i] = 0;
+}
+
+ObjectGeometry::ObjectGeometry(const ObjectGeometry& other)
+	: mName(other.mName), mIndexBuffer(other.mIndexBuffer), mPositionBuffer(other.mPositionBuffer),
+	  mUVBuffer(other.mUVBuffer), mNormalBuffer(other.mNormalBuffer),
+	  mVertexFormat(other.mVertexFormat), mPackedVertexBuffer(other.mPackedVertexBuffer),
+	  mShortIndexBuffer(other.mShortIndexBuffer), mIndexType(other.mIndexType), mArenaRange(other.mArenaRange),
+	  mBoundsMin(other.mBoundsMin), mBoundsMax(other.mBoundsMax),
+	  mBoundingSphereCenter(other.mBoundingSphereCenter), mBoundingSphereRadius(other.mBoundingSphereRadius),
+	  mLODs(other.mLODs)
+{
+	for(int i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+		mVertexArrays[0][i] = mVertexArrays[1][i] = 0; // The other's VAOs point to its buffers
 }
 
 ObjectGeometry::~ObjectGeometry()
 {
-	// Do nothing
+	std::lock_guard<std::mutex> lock(gOrphanedVertexArraysMutex);
+
+	for(int i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+	{
+		for(int instanced = 0; instanced < 2; instanced++)
+		{
+			if(mVertexArrays[instanced][i] != 0)
+				gOrphanedVertexArrays.push_back(mVertexArrays[instanced][i]);
+		}
+	}
+}
+
+// Interleaves the vertices, and makes 16-bit indices if they fit
+// They go in the geometry arena if it is on, in mPackedVertexBuffer and mShortIndexBuffer if not
+void ObjectGeometry::packVertices(const uintVector& indices, const vec3Vector& positions, const vec2Vector& UVs, const vec3Vector& normals)
+{
+	std::vector<PackedVertex> vertices(positions.size());
+
+	for(std::size_t i = 0; i < positions.size(); i++)
+	{
+		// Geometry made in Lua might not have UVs or normals
+		glm::vec2 UV = (i < UVs.size()) ? UVs[i] : glm::vec2(0.0f);
+		glm::vec3 normal = (i < normals.size()) ? normals[i] : glm::vec3(0.0f);
+
+		vertices[i].position = positions[i];
+		vertices[i].UV = glm::packHalf2x16(UV);
+		vertices[i].normal = glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f)); // X in the low bits, like GL_INT_2_10_10_10_REV
+	}
+
+	std::vector<GLushort> shortIndices;
+
+	if(positions.size() <= VERTEX_FORMAT_MAX_SHORT_INDEX_VERTICES)
+	{
+		shortIndices.assign(indices.begin(), indices.end()); // All smaller than the vertex count
+		mIndexType = GL_UNSIGNED_SHORT;
+	}
+
+	if(mIndexType == GL_UNSIGNED_SHORT)
+	{
+		mArenaRange = GeometryArena::allocate(vertices.data(), static_cast<GLsizei>(vertices.size()),
+			shortIndices.data(), Utils::getSizeOfVectorData(shortIndices));
+	} else
+	{
+		mArenaRange = GeometryArena::allocate(vertices.data(), static_cast<GLsizei>(vertices.size()),
+			indices.data(), Utils::getSizeOfVectorData(indices));
+	}
+
+	if(mArenaRange) // Our own buffers are never used
+	{
+		mPackedVertexBuffer.setCPUSide();
+		mShortIndexBuffer.setCPUSide();
+		return;
+	}
+
+	mPackedVertexBuffer.setMutableData(vertices, GL_STATIC_DRAW);
+
+	if(mIndexType == GL_UNSIGNED_SHORT)
+		mShortIndexBuffer.setMutableData(shortIndices, GL_STATIC_DRAW);
+}
+
+// The sphere is centered on the box, with the farthest vertex on it. Not the smallest sphere, but close enough.
+void ObjectGeometry::computeBounds(const vec3Vector& positions)
+{
+	if(positions.empty())
+	{
+		mBoundsMin = mBoundsMax = mBoundingSphereCenter = glm::vec3(0.0f);
+		mBoundingSphereRadius = 0.0f;
+		return;
+	}
+
+	mBoundsMin = mBoundsMax = positions.front();
+
+	for(const auto& position : positions)
+	{
+		mBoundsMin = glm::min(mBoundsMin, position);
+		mBoundsMax = glm::max(mBoundsMax, position);
+	}
+
+	mBoundingSphereCenter = (mBoundsMin + mBoundsMax) * 0.5f;
+	float squaredRadius = 0.0f;
+
+	for(const auto& position : positions)
+	{
+		glm::vec3 offset = position - mBoundingSphereCenter;
+		squaredRadius = std::max(squaredRadius, glm::dot(offset, offset));
+	}
+
+	mBoundingSphereRadius = std::sqrt(squaredRadius);
+}
+
+// Records the attributes of the layout and the index buffer in a new VAO, and leaves it bound
+void ObjectGeometry::createVertexArray(int layout, bool instanced) const
+{
+	GLuint& vertexArray = mVertexArrays[instanced ? 1 : 0][layout];
+
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+
+	if(mVertexFormat == VERTEX_FORMAT_PACKED)
+	{
+		mPackedVertexBuffer.bind(GL_ARRAY_BUFFER);
+		setPackedVertexAttributes(layout);
+
+		if(mIndexType == GL_UNSIGNED_SHORT)
+			mShortIndexBuffer.bind(GL_ELEMENT_ARRAY_BUFFER);
+		else
+			mIndexBuffer.bind(GL_ELEMENT_ARRAY_BUFFER);
+	} else
+	{
+		// Attribute 0, positions. Each time the vertex shader runs, it will get the next element of this buffer.
+		glEnableVertexAttribArray(0);
+		mPositionBuffer.bind(GL_ARRAY_BUFFER);
+		glVertexAttribPointer(
+			0,					// Attribute 0, same as the vertex shader's layout
+			3,					// Size. Number of values per vertex, must be 1, 2, 3 or 4.
+			GL_FLOAT,			// Type of data (GLfloats)
+			GL_FALSE,			// Normalized?
+			0,					// Stride
+			(void*)0			// Array buffer offset
+		);
+
+		if(layout >= VERTEX_LAYOUT_TEXTURED) // Attribute 1, UVs
+		{
+			glEnableVertexAttribArray(1);
+			mUVBuffer.bind(GL_ARRAY_BUFFER);
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+		}
+
+		if(layout >= VERTEX_LAYOUT_SHADED) // Attribute 2, normals
+		{
+			glEnableVertexAttribArray(2);
+			mNormalBuffer.bind(GL_ARRAY_BUFFER);
+			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+		}
+
+		mIndexBuffer.bind(GL_ELEMENT_ARRAY_BUFFER); // Part of the VAO too
+	}
+
+	if(instanced)
+		setInstanceAttributes();
+}
+
+// Static
+// Same locations as the separate buffers, all in the bound array buffer. The shaders get floats either way.
+void ObjectGeometry::setPackedVertexAttributes(int layout)
+{
+	GLsizei stride = sizeof(PackedVertex);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, position));
+
+	if(layout >= VERTEX_LAYOUT_TEXTURED)
+	{
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, UV));
+	}
+
+	if(layout >= VERTEX_LAYOUT_SHADED) // 4 values is the only size allowed, the vec3 in the shader drops the last one
+	{
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+	}
+}
+
+// Static
+// Per-instance matrices, one column per location. Where they are in the instance buffer changes
+// for each draw, so the pointers are set by RenderQueue::drawElementsInstanced().
+void ObjectGeometry::setInstanceAttributes()
+{
+	for(int i = 0; i < 4; i++)
+	{
+		glEnableVertexAttribArray(VERTEX_INSTANCE_MODEL_MATRIX_LOCATION + i);
+		glVertexAttribDivisor(VERTEX_INSTANCE_MODEL_MATRIX_LOCATION + i, 1); // Next value for each instance, not each vertex
+	}
+
+	for(int i = 0; i < 3; i++)
+	{
+		glEnableVertexAttribArray(VERTEX_INSTANCE_NORMAL_MATRIX_LOCATION + i);
+		glVertexAttribDivisor(VERTEX_INSTANCE_NORMAL_MATRIX_LOCATION + i, 1);
+	}
 }
 
 std::string ObjectGeometry::getName() const
@@ -79,4 +311,151 @@ ObjectGeometry::vec3Buffer& ObjectGeometry::getNormalBuffer()
 const ObjectGeometry::vec3Buffer& ObjectGeometry::getNormalBuffer() const
 {
 	return mNormalBuffer;
+}
+
+const ObjectGeometry::uintVector& ObjectGeometry::getIndices() const
+{
+	return mIndexBuffer.getCPUData();
+}
+
+const ObjectGeometry::vec3Vector& ObjectGeometry::getPositions() const
+{
+	return mPositionBuffer.getCPUData();
+}
+
+GLsizei ObjectGeometry::getIndexCount() const
+{
+	return mIndexBuffer.getLength();
+}
+
+GLenum ObjectGeometry::getIndexType() const
+{
+	return mIndexType;
+}
+
+int ObjectGeometry::getVertexFormat() const
+{
+	return mVertexFormat;
+}
+
+GLuint ObjectGeometry::getSortID(const GeometryArena::Location* arenaLocation) const
+{
+	// Page first so geometry on the same page is drawn one after the other (merged draws),
+	// then the range so copies of the same geometry stay together (instanced draws)
+	if(mArenaRange && arenaLocation)
+	{
+		GLuint page = arenaLocation->vertexBuffer;
+		GLuint range = mArenaRange->getID() & ((1u << GEOMETRY_ARENA_SORT_RANGE_BITS) - 1);
+
+		return (page << GEOMETRY_ARENA_SORT_RANGE_BITS) | range;
+	}
+
+	return (mVertexFormat == VERTEX_FORMAT_PACKED) ? mPackedVertexBuffer.getID() : mIndexBuffer.getID();
+}
+
+glm::vec3 ObjectGeometry::getBoundsMin() const
+{
+	return mBoundsMin;
+}
+
+glm::vec3 ObjectGeometry::getBoundsMax() const
+{
+	return mBoundsMax;
+}
+
+glm::vec3 ObjectGeometry::getBoundingSphereCenter() const
+{
+	return mBoundingSphereCenter;
+}
+
+float ObjectGeometry::getBoundingSphereRadius() const
+{
+	return mBoundingSphereRadius;
+}
+
+// From the most detailed to the least, see MeshOptimizer::generateLODs()
+void ObjectGeometry::setLODs(const constLODVector& LODs)
+{
+	mLODs = LODs;
+}
+
+int ObjectGeometry::getLODCount() const
+{
+	return static_cast<int>(mLODs.size()) + 1;
+}
+
+std::shared_ptr<const ObjectGeometry> ObjectGeometry::getLOD(int level) const
+{
+	if(level <= 0 || level > static_cast<int>(mLODs.size()))
+		return nullptr;
+
+	return mLODs[level - 1];
+}
+
+GLuint ObjectGeometry::getVertexArray(int layout, bool instanced) const
+{
+	if(layout < 0 || layout >= VERTEX_LAYOUT_COUNT)
+	{
+		Utils::CRASH("Vertex layout " + std::to_string(layout) + " does not exist!");
+		return 0;
+	}
+
+	if(mArenaRange)
+		return GeometryArena::getVertexArray(*mArenaRange->getLocation(), layout, instanced);
+
+	GLuint vertexArray = mVertexArrays[instanced ? 1 : 0][layout];
+
+	if(vertexArray == 0)
+	{
+		createVertexArray(layout, instanced);
+		vertexArray = mVertexArrays[instanced ? 1 : 0][layout];
+	}
+
+	return vertexArray;
+}
+
+// The arena can move the geometry (see GeometryArena::compact()), so its VAO and offsets all come from the location
+// the frame was snapshotted with. The copies to newer ones might not be done yet, the frame's resource fence only covers that one.
+ObjectGeometry::DrawRange ObjectGeometry::getDrawRange(int layout, bool instanced, std::shared_ptr<const GeometryArena::Location> arenaLocation) const
+{
+	DrawRange range;
+	range.indexCount = getIndexCount();
+	range.indexType = mIndexType;
+
+	if(mArenaRange && arenaLocation && layout >= 0 && layout < VERTEX_LAYOUT_COUNT) // getVertexArray() complains about bad layouts
+	{
+		range.location = std::move(arenaLocation);
+		range.vertexArray = GeometryArena::getVertexArray(*range.location, layout, instanced);
+		range.indexOffset = range.location->indexOffset;
+		range.baseVertex = range.location->baseVertex;
+	} else
+	{
+		range.vertexArray = getVertexArray(layout, instanced);
+		range.indexOffset = 0;
+		range.baseVertex = 0;
+	}
+
+	return range;
+}
+
+bool ObjectGeometry::isInArena() const
+{
+	return mArenaRange != nullptr;
+}
+
+std::shared_ptr<const GeometryArena::Location> ObjectGeometry::getArenaLocation() const
+{
+	return mArenaRange ? mArenaRange->getLocation() : nullptr;
+}
+
+// Static
+void ObjectGeometry::deleteOrphanedVertexArrays()
+{
+	std::lock_guard<std::mutex> lock(gOrphanedVertexArraysMutex);
+
+	if(gOrphanedVertexArrays.empty())
+		return;
+
+	glDeleteVertexArrays(static_cast<GLsizei>(gOrphanedVertexArrays.size()), gOrphanedVertexArrays.data());
+	gOrphanedVertexArrays.clear();
 }
\ No newline at end of file
@@ -18,6 +18,24 @@
 ///////////////////////////////////////////////////////////////////////
 
 // This class holds the vertex data. Use this class as a member for other 3D objects.
+//
+// Vertices are packed by default (VERTEX_FORMAT_PACKED): one interleaved buffer with float positions, half float UVs
+// and normals in 2_10_10_10 integers, 20 bytes per vertex instead of 32. Indices are 16-bit when there are few enough vertices.
+// The separate buffers are then only kept in memory (changing them doesn't change what is drawn),
+// VERTEX_FORMAT_SEPARATE keeps the old float buffers on the GPU instead.
+//
+// The indices and the positions are also kept in memory (see GPUBuffer::setKeepsCPUCopy()), physics shapes are made
+// from them, and reading them back from OpenGL would wait for the GPU.
+//
+// It also has one vertex array object (VAO) per vertex layout, so drawing only needs glBindVertexArray().
+// VAOs can't be shared between contexts, and geometry is often loaded on another context than the one that draws
+// (see RenderThread), so they are created the first time they are needed, on the context that draws.
+//
+// Packed geometry goes in the shared buffers of the GeometryArena when it is on, instead of buffers of its own.
+// It then uses the VAOs of its page, and is drawn from its place in it (see getDrawRange()).
+//
+// A geometry can have simplified versions of itself, its levels of detail (LODs, see MeshOptimizer::generateLODs()).
+// They are only for drawing, physics and bounds always use the full geometry.
 
 #ifndef OBJECT_GEOMETRY_HPP
 #define OBJECT_GEOMETRY_HPP
@@ -30,6 +48,10 @@
 
 #include <Shader.hpp>
 #include <GPUBuffer.hpp>
+#include <GeometryArena.hpp>
+#include <Definitions.hpp>
+
+#include <glad/glad.h>
 
 class ObjectGeometry
 {
@@ -42,6 +64,31 @@ public:
 	using vec2Vector = std::vector<glm::vec2>;
 	using vec3Vector = std::vector<glm::vec3>;
 
+	// An interleaved vertex of VERTEX_FORMAT_PACKED
+	struct PackedVertex
+	{
+		glm::vec3 position;
+		GLuint UV; // Two half floats, UVs often go past 1 (repeating textures)
+		GLuint normal; // GL_INT_2_10_10_10_REV, normalized
+	};
+
+	using packedVertexBuffer = GPUBuffer<PackedVertex>;
+	using ushortBuffer = GPUBuffer<GLushort>;
+
+	using constLODVector = std::vector<std::shared_ptr<const ObjectGeometry>>;
+
+	// What a draw of the geometry needs, read all at once (see GeometryArena)
+	struct DrawRange
+	{
+		GLuint vertexArray;
+		GLsizei indexCount;
+		GLenum indexType;
+		std::size_t indexOffset; // In bytes, in the VAO's index buffer
+		GLint baseVertex;
+
+		std::shared_ptr<const GeometryArena::Location> location; // Keeps the arena page alive, null if not in the arena
+	};
+
 private:
 	using constShaderPointer = std::shared_ptr<const Shader>; // Const shader
 
@@ -52,9 +99,37 @@ private:
 	vec2Buffer mUVBuffer;
 	vec3Buffer mNormalBuffer;
 
+	int mVertexFormat; // VERTEX_FORMAT_*
+	packedVertexBuffer mPackedVertexBuffer; // When packed
+	ushortBuffer mShortIndexBuffer; // When packed with few enough vertices
+	GLenum mIndexType; // Of the index buffer that is drawn, GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+
+	std::shared_ptr<GeometryArena::Range> mArenaRange; // Null if the geometry has its own buffers. Shared with copies, it never changes.
+
+	void packVertices(const uintVector& indices, const vec3Vector& positions, const vec2Vector& UVs, const vec3Vector& normals);
+
+	// Bounding volumes in model space, for culling. Computed at load, the GPU buffers can't be read back cheaply.
+	glm::vec3 mBoundsMin; // Axis aligned bounding box
+	glm::vec3 mBoundsMax;
+	glm::vec3 mBoundingSphereCenter;
+	float mBoundingSphereRadius;
+
+	void computeBounds(const vec3Vector& positions);
+
+	// Created on the drawing context, 0 until then. Mutable since drawing a const geometry creates them.
+	// [0] are normal, [1] also have the per-instance attributes (see RenderQueue::drawElementsInstanced()).
+	mutable GLuint mVertexArrays[2][VERTEX_LAYOUT_COUNT];
+
+	void createVertexArray(int layout, bool instanced) const;
+
+	constLODVector mLODs; // Level 1 and up, level 0 is this geometry
+
 public:
 	ObjectGeometry(const std::string& name,
-		const uintVector& indices, const vec3Vector& positions, const vec2Vector& UVs, const vec3Vector& normals);
+		const uintVector& indices, const vec3Vector& positions, const vec2Vector& UVs, const vec3Vector& normals,
+		int vertexFormat = VERTEX_FORMAT_PACKED);
+	ObjectGeometry(const ObjectGeometry& other); // Copies the buffers, the copy gets its own VAOs
+	ObjectGeometry& operator=(const ObjectGeometry& other) = delete;
 	~ObjectGeometry();
 
 	std::string getName() const;
@@ -71,6 +146,36 @@ public:
 
 	vec3Buffer& getNormalBuffer();
 	const vec3Buffer& getNormalBuffer() const;
+
+	// Copies kept in memory, never touch OpenGL
+	const uintVector& getIndices() const;
+	const vec3Vector& getPositions() const;
+	GLsizei getIndexCount() const; // For glDrawElements()
+	GLenum getIndexType() const; // Same
+
+	int getVertexFormat() const;
+	GLuint getSortID(const GeometryArena::Location* arenaLocation) const; // For sorting draws, different for each geometry. Geometry on the same page sorts together.
+
+	glm::vec3 getBoundsMin() const;
+	glm::vec3 getBoundsMax() const;
+	glm::vec3 getBoundingSphereCenter() const;
+	float getBoundingSphereRadius() const;
+
+	void setLODs(const constLODVector& LODs);
+	int getLODCount() const; // Including this geometry, 1 if it has no LODs
+	std::shared_ptr<const ObjectGeometry> getLOD(int level) const; // Null for level 0, use this geometry
+
+	GLuint getVertexArray(int layout, bool instanced) const; // Call on the drawing context only, creates it if needed
+	// Same. Arena location is where the geometry was when the frame was snapshotted (see ObjectSnapshot::arenaLocation).
+	DrawRange getDrawRange(int layout, bool instanced, std::shared_ptr<const GeometryArena::Location> arenaLocation) const;
+	bool isInArena() const;
+	std::shared_ptr<const GeometryArena::Location> getArenaLocation() const; // Null if not in the arena. Read it when snapshotting.
+
+	// Of the bound VAO and array buffer, for the VAOs of the geometry arena too
+	static void setPackedVertexAttributes(int layout);
+	static void setInstanceAttributes();
+
+	static void deleteOrphanedVertexArrays(); // Call on the drawing context, see ~ObjectGeometry()
 };
 
 #endif /* OBJECT_GEOMETRY_HPP */
\ No newline at end of file
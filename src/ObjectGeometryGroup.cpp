@@ -26,6 +26,7 @@
 #include <tiny_obj_loader.h>
 
 #include <Utils.hpp> // For vector stuff and error messages
+#include <MeshOptimizer.hpp>
 #include <ResourceManager.hpp> // For getting the basename of files
 
 ObjectGeometryGroup::ObjectGeometryGroup(const std::string& name)
@@ -42,6 +43,15 @@ ObjectGeometryGroup::ObjectGeometryGroup(const std::string& name, const std::str
 	loadOBJFile(objectGeometryGroupFile);
 }
 
+// For geometries parsed elsewhere, see parseOBJFile()
+ObjectGeometryGroup::ObjectGeometryGroup(const std::string& name, geometryDataVector& geometries)
+{
+	mName = name;
+	mGeneratedNames = 0;
+
+	addGeometryData(geometries);
+}
+
 ObjectGeometryGroup::~ObjectGeometryGroup()
 {
 	// Do nothing
@@ -54,6 +64,22 @@ std::string ObjectGeometryGroup::getName()
 
 // Loads an .obj file. The objects found will be added to this group.
 bool ObjectGeometryGroup::loadOBJFile(const std::string& OBJfilePath)
+{
+	geometryDataVector geometries;
+
+	if(!parseOBJFile(OBJfilePath, mName, geometries))
+		return false;
+
+	addGeometryData(geometries);
+	return true;
+}
+
+// Static
+// Reads an .obj file into geometries, without creating any buffers. Doesn't touch OpenGL, so any thread can call this.
+// The geometries are optimized for the GPU too, unless MeshOptimizer::setEnabledOnLoad(false) was called,
+// and get their levels of detail unless MeshOptimizer::setLODsOnLoad(false) was called.
+// The group name is only for error messages.
+bool ObjectGeometryGroup::parseOBJFile(const std::string& OBJfilePath, const std::string& groupName, geometryDataVector& geometries)
 {
 	std::vector<tinyobj::shape_t> shapes;
 	std::vector<tinyobj::material_t> materials;
@@ -96,14 +122,14 @@ bool ObjectGeometryGroup::loadOBJFile(const std::string& OBJfilePath)
 			currentShape.mesh.normals.size()%3 != 0)
 		{
 			Utils::WARN("OBJ data for geometry '" + currentShape.name + "' in file '" + OBJfilePath +
-				"' for group '" + mName + "' is invalid! Skipping this geometry.");
+				"' for group '" + groupName + "' is invalid! Skipping this geometry.");
 			continue;
 		}
 
 		if(currentShape.mesh.indices.size() % 3 != 0) // Not triangles, but Tinyobjloader should of taken care of this
 		{
 			Utils::WARN("OBJ data for geometry '" + currentShape.name + "' in file '" + OBJfilePath +
-				"' for group '" + mName + "' does not contain triangles! Tinyobjloader should of taken care of this. Bug?" +
+				"' for group '" + groupName + "' does not contain triangles! Tinyobjloader should of taken care of this. Bug?" +
 				" To fix this, open your model in a object modeling software, triangulate the faces and the export it as" + 
 				" .obj (Wavefront).");
 			continue;
@@ -112,9 +138,16 @@ bool ObjectGeometryGroup::loadOBJFile(const std::string& OBJfilePath)
 		std::size_t numberOfVertices = currentShape.mesh.positions.size()/3; // Since positions are vec3
 
 		// Create the vectors with the right sizes
-		ObjectGeometry::vec3Vector positions(numberOfVertices);
-		ObjectGeometry::vec2Vector UVcoords(numberOfVertices);
-		ObjectGeometry::vec3Vector normals(numberOfVertices);
+		geometries.push_back(GeometryData());
+		GeometryData& geometry = geometries.back();
+
+		ObjectGeometry::vec3Vector& positions = geometry.positions;
+		ObjectGeometry::vec2Vector& UVcoords = geometry.UVs;
+		ObjectGeometry::vec3Vector& normals = geometry.normals;
+
+		positions.resize(numberOfVertices);
+		UVcoords.resize(numberOfVertices);
+		normals.resize(numberOfVertices);
 
 		// Final safety check!
 		if(currentShape.mesh.positions.size()/3 != currentShape.mesh.normals.size()/3 ||
@@ -122,7 +155,7 @@ bool ObjectGeometryGroup::loadOBJFile(const std::string& OBJfilePath)
 			currentShape.mesh.texcoords.size()/2 != currentShape.mesh.normals.size()/3)
 		{
 			Utils::CRASH("OBJ data for geometry '" + currentShape.name + "' in file '" + OBJfilePath +
-				"' for group '" + mName + "' is not coherent! Did you include normals/texcoords and in the same amount?");
+				"' for group '" + groupName + "' is not coherent! Did you include normals/texcoords and in the same amount?");
 			return false;
 		}
 
@@ -142,14 +175,84 @@ bool ObjectGeometryGroup::loadOBJFile(const std::string& OBJfilePath)
 										 currentShape.mesh.normals[j*3 + 2]);     // Z
 		}
 
-		std::string name = getValidName(currentShape.name); // Make sure we have a unique name
+		geometry.name = currentShape.name;
+		geometry.indices.swap(currentShape.mesh.indices); // Not needed anymore
+
+		if(MeshOptimizer::isEnabledOnLoad())
+		{
+			MeshOptimizer::Stats stats = MeshOptimizer::optimize(geometry.indices, positions, UVcoords, normals);
+
+			std::ostringstream message;
+			message.precision(3);
+			message << "Optimized geometry '" << geometry.name << "' of group '" << groupName << "': "
+				<< stats.vertexCountBefore << " -> " << stats.vertexCountAfter << " vertices, ACMR "
+				<< stats.ACMRBefore << " -> " << stats.ACMRAfter << ".";
+
+			Utils::LOGPRINT(message.str());
+		}
+
+		if(MeshOptimizer::areLODsOnLoad())
+		{
+			std::vector<ObjectGeometry::uintVector> LODIndices = MeshOptimizer::generateLODs(geometry.indices, positions, UVcoords, normals);
+
+			if(LODIndices.empty()) // Too small to bother
+				continue;
+
+			std::string message = "Generated " + std::to_string(LODIndices.size()) + " levels of detail for geometry '" +
+				geometry.name + "' of group '" + groupName + "': " + std::to_string(geometry.indices.size() / 3);
+
+			for(auto& indices : LODIndices)
+			{
+				geometry.LODs.push_back(GeometryData::LODData());
+				GeometryData::LODData& LOD = geometry.LODs.back();
+
+				// Each level only keeps the vertices it uses, in its own buffers
+				LOD.indices.swap(indices);
+				LOD.positions = positions;
+				LOD.UVs = UVcoords;
+				LOD.normals = normals;
+
+				std::vector<std::size_t> clusters;
+				MeshOptimizer::optimizeVertexCache(LOD.indices, LOD.positions.size(), MESH_OPTIMIZER_CACHE_SIZE, clusters);
+				MeshOptimizer::optimizeVertexFetch(LOD.indices, LOD.positions, LOD.UVs, LOD.normals);
+
+				message += " -> " + std::to_string(LOD.indices.size() / 3);
+			}
+
+			Utils::LOGPRINT(message + " triangles.");
+		}
+	}
+
+	return true; // Success!
+}
+
+// Creates the geometries (and their buffers, so call this on a thread that can use OpenGL)
+// Empties the vector's data, since it was copied to the buffers
+void ObjectGeometryGroup::addGeometryData(geometryDataVector& geometries)
+{
+	for(auto& geometry : geometries)
+	{
+		std::string name = getValidName(geometry.name); // Make sure we have a unique name
 
 		objectGeometryPointer objectGeometryPointer(new ObjectGeometry(name,
-			currentShape.mesh.indices, positions, UVcoords, normals));
+			geometry.indices, geometry.positions, geometry.UVs, geometry.normals));
+
+		// Levels of detail aren't in the group, only their geometry knows them
+		ObjectGeometry::constLODVector LODs;
+
+		for(std::size_t i = 0; i < geometry.LODs.size(); i++)
+		{
+			GeometryData::LODData& LOD = geometry.LODs[i];
+
+			LODs.push_back(std::make_shared<const ObjectGeometry>(name + "_LOD" + std::to_string(i + 1),
+				LOD.indices, LOD.positions, LOD.UVs, LOD.normals));
+		}
+
+		objectGeometryPointer->setLODs(LODs);
 		addObjectGeometry(objectGeometryPointer);
 	}
 
-	return true; // Success!
+	geometries.clear();
 }
 
 // Checks if the name is available. If not, it will generate one.
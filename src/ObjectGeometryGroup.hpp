@@ -38,6 +38,29 @@ public:
 
 	using objectGeometryVector = std::vector<objectGeometryPointer>;
 
+	// Vertex data of one geometry, before it has buffers
+	struct GeometryData
+	{
+		std::string name;
+		ObjectGeometry::uintVector indices;
+		ObjectGeometry::vec3Vector positions;
+		ObjectGeometry::vec2Vector UVs;
+		ObjectGeometry::vec3Vector normals;
+
+		// Simplified versions, from the most detailed (see MeshOptimizer::generateLODs())
+		struct LODData
+		{
+			ObjectGeometry::uintVector indices;
+			ObjectGeometry::vec3Vector positions;
+			ObjectGeometry::vec2Vector UVs;
+			ObjectGeometry::vec3Vector normals;
+		};
+
+		std::vector<LODData> LODs;
+	};
+
+	using geometryDataVector = std::vector<GeometryData>;
+
 private:
 	std::string mName;
 	objectGeometryMap mObjectGeometryMap;
@@ -45,10 +68,14 @@ private:
 	int mGeneratedNames; // For generating unique logical geometry names if needed
 
 	bool loadOBJFile(const std::string& OBJfilePath);
+	void addGeometryData(geometryDataVector& geometries);
 
 public:
 	ObjectGeometryGroup(const std::string& name);
 	ObjectGeometryGroup(const std::string& name, const std::string& objectFile);
+	ObjectGeometryGroup(const std::string& name, geometryDataVector& geometries);
+
+	static bool parseOBJFile(const std::string& OBJfilePath, const std::string& groupName, geometryDataVector& geometries);
 	~ObjectGeometryGroup();
 
 	std::string getName();
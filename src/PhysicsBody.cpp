@@ -37,7 +37,6 @@
 #include <PhysicsBody.hpp>
 
 #include <Utils.hpp>
-#include <GPUBuffer.hpp>
 #include <Camera.hpp>
 #include <ShadedObject.hpp>
 
@@ -49,6 +48,11 @@
 
 #include <math.h> // For trig stuff
 
+// Debug shapes asked for during the last step, they are drawn with the next frames
+// Only used by the thread stepping the game
+static std::vector<glm::vec3> gQueuedDebugLines; // See renderDebugShape()
+static std::shared_ptr<const Shader> gQueuedDebugLineShader;
+
 PhysicsBody::PhysicsBody()
 {
 	init();
@@ -148,6 +152,10 @@ void PhysicsBody::init()
 	mIsCircular = true;
 	mRadius = 0.0f;
 	mType = PHYSICS_BODY_IGNORED;
+
+	mPreviousPosition = glm::vec3(0.0f);
+	mPreviousRotation = glm::vec3(0.0f);
+	mHasPreviousTransform = false;
 }
 
 // Static
@@ -232,14 +240,14 @@ PhysicsBody::shapeUniquePointer PhysicsBody::createShapesFromRadius(float radius
 
 // Static
 // Heavy!
-// Copies the data into a new vector
+// Uses the geometry's copy of the data, nothing is read back from OpenGL
 // Returns a b2Vec2Vector to assure compability with Box2D
 // Returning coords are in meters!
 PhysicsBody::B2Vec2Vector PhysicsBody::get2DObjectGeometryCoords(const ObjectGeometry& objectGeometry,
 	float pixelsPerMeter, glm::vec3 rotation, glm::vec3 scaling)
 {
-	ObjectGeometry::uintVector indices = objectGeometry.getIndexBuffer().read();
-	ObjectGeometry::vec3Vector positions3D = objectGeometry.getPositionBuffer().read();
+	const ObjectGeometry::uintVector& indices = objectGeometry.getIndices();
+	const ObjectGeometry::vec3Vector& positions3D = objectGeometry.getPositions();
 
 	// generate a matrix so we can easily have rotation and scaling
 	glm::mat4 matrix = generateModelMatrix(glm::vec3(0.0f), rotation, scaling / pixelsPerMeter);
@@ -781,6 +789,11 @@ glm::vec3 PhysicsBody::getRotationInRadians() const
 		degreesToRadians(mRotation.z));
 }
 
+glm::vec3 PhysicsBody::getScaling() const
+{
+	return mScaling;
+}
+
 // The non-physics coord still moves the body on the axis
 void PhysicsBody::setVelocity(glm::vec3 velocity)
 {
@@ -888,8 +901,8 @@ glm::vec3 PhysicsBody::getShapesLocal3DCenter() const
 
 		if(mObjectGeometry)
 		{
-			ObjectGeometry::uintVector indices = mObjectGeometry->getIndexBuffer().read();
-			ObjectGeometry::vec3Vector positions3D = mObjectGeometry->getPositionBuffer().read();
+			const ObjectGeometry::uintVector& indices = mObjectGeometry->getIndices();
+			const ObjectGeometry::vec3Vector& positions3D = mObjectGeometry->getPositions();
 
 			std::size_t indexCount = indices.size();
 													  // Convert polygons to 2D
@@ -970,9 +983,40 @@ glm::mat4 PhysicsBody::generateModelMatrix()
 	return modelM;
 }
 
+// Interpolation goes from 0 (transform before the last step) to 1 (current transform)
+// Rendering in between steps keeps movement smooth when the step rate and the frame rate don't match
+glm::vec3 PhysicsBody::getInterpolatedPosition(float interpolation) const
+{
+	if(!mHasPreviousTransform)
+		return getPosition();
+
+	return glm::mix(mPreviousPosition, getPosition(), interpolation);
+}
+
+glm::vec3 PhysicsBody::getInterpolatedRotation(float interpolation) const
+{
+	if(!mHasPreviousTransform)
+		return getRotation();
+
+	return glm::mix(mPreviousRotation, getRotation(), interpolation);
+}
+
+glm::mat4 PhysicsBody::generateModelMatrix(float interpolation) const
+{
+	return generateModelMatrix(
+		getInterpolatedPosition(interpolation),
+		getInterpolatedRotation(interpolation),
+		mScaling);
+}
+
 // timeStep in seconds, like Box2D (speed is in meters/seconds normally)
 void PhysicsBody::step(float timeStep)
 {
+	// Remember where we were, the world will move us after this
+	mPreviousPosition = getPosition();
+	mPreviousRotation = getRotation();
+	mHasPreviousTransform = true;
+
 	if(mWorldBody)
 	{
 		if(mWorldFriction != 0.0f)
@@ -1039,25 +1083,46 @@ void PhysicsBody::step(float timeStep)
 }
 
 // A quick an easy renderer for debugging
-// Slow!
+// Call it during a step, the shape is queued and drawn on top of the frames until the next step.
+// All debug shapes are drawn at once, see DebugRenderer. To see all objects, EntityManager::setDebugShapesVisible() is faster.
+// The camera isn't used anymore, shapes are seen through the game camera like everything else.
 // Other 3D coord is the non-physics coord that the physics body will be dawn at
 // Other 3D coord is useful if we want to draw all debug shapes on the same plane
 // Takes a shader pointer to be consistent
 // The shader is the same for basic objects
 void PhysicsBody::renderDebugShape(constShaderPointer shader, const Camera* camera, float other3DCoord)
 {
-	glm::vec3 color(0.0f, 1.0f, 0.0f);
+	if(Utils::isHeadless()) // Nothing to draw on
+		return;
 
 	if(mShapes.empty())
 	{
 		Utils::CRASH("Cannot debug render this physics body, it does not have shapes! Please calculate them before calling.");
 		return;
 	}
-	
-	// Lets do something very smart, create a buffer, fill it, and then delete it each time we render
-	GPUBuffer<glm::vec3> positionBuffer;
-	vec3Vector localPositions3D; // Object space coords, before model matrix!
-	int drawMode = 0;
+
+	gQueuedDebugLineShader = shader;
+	appendDebugLines(gQueuedDebugLines, other3DCoord, 1.0f); // Where the body is now
+}
+
+// Adds the outline of the shapes to lines, two world space points per line
+// Does nothing if there are no shapes
+void PhysicsBody::appendDebugLines(vec3Vector& lines, float other3DCoord, float interpolation) const
+{
+	if(mShapes.empty())
+		return;
+
+	glm::vec3 position = getInterpolatedPosition(interpolation);
+	glm::mat4 modelMatrix = generateModelMatrix(
+		glm::vec3(position.x, other3DCoord, position.z),
+		glm::vec3(0.0f, getInterpolatedRotation(interpolation).y, 0.0f), // Ignore any rotation apart Box2D's rotation
+		glm::vec3(1.0f)); // No scaling here! The scaling is built-in the vertices
+
+	// Shapes are in meters, on the physics plane
+	auto toWorld = [&modelMatrix](float x, float y)
+	{
+		return glm::vec3(modelMatrix * glm::vec4(x * PHYSICS_PIXELS_PER_METER, 0.0f, y * PHYSICS_PIXELS_PER_METER, 1.0f));
+	};
 
 	if(mIsCircular)
 	{
@@ -1065,92 +1130,41 @@ void PhysicsBody::renderDebugShape(constShaderPointer shader, const Camera* came
 		b2CircleShape* circle = static_cast<b2CircleShape*>(mShapes[0].get());
 		glm::vec2 circleCenter = B2Vec2ToGlm(circle->m_p);
 
-		// Translation is done in the model matrix
-		// Put the circle on the object geometry shape (relative to the object geometry)
 		vec2Vector vertices2D = getCircleVertices(circleCenter, circle->m_radius, 10);
 
-		for(auto &vertex2D : vertices2D)
+		for(std::size_t i = 0; i < vertices2D.size(); i++)
 		{
-			localPositions3D.push_back(glm::vec3(
-				vertex2D.x * PHYSICS_PIXELS_PER_METER,
-				0.0f,
-				vertex2D.y * PHYSICS_PIXELS_PER_METER));
+			const glm::vec2& next = vertices2D[(i + 1) % vertices2D.size()];
+
+			lines.push_back(toWorld(vertices2D[i].x, vertices2D[i].y));
+			lines.push_back(toWorld(next.x, next.y));
 		}
 
 		// Add line to see circle angle better
-
-		// Front is the first element
-		// We need to add this otherwise we see a hole in the circle
-		localPositions3D.push_back(localPositions3D.front());
-		localPositions3D.push_back(glm::vec3(circleCenter.x * PHYSICS_PIXELS_PER_METER,
-			0.0f,
-			circleCenter.y * PHYSICS_PIXELS_PER_METER)); // Add the center of the circle
-
-		drawMode = GL_LINE_STRIP;
+		if(!vertices2D.empty())
+		{
+			lines.push_back(toWorld(vertices2D.front().x, vertices2D.front().y));
+			lines.push_back(toWorld(circleCenter.x, circleCenter.y));
+		}
 	} else
 	{
 		for(std::size_t i = 0; i < mShapes.size(); i++)
 		{
-			b2Shape* shape = mShapes[i].get();
 			// We can static cast here, since we know 100% it is a polygon shape.
-			b2PolygonShape* polygon = static_cast<b2PolygonShape*>(shape);
+			b2PolygonShape* polygon = static_cast<b2PolygonShape*>(mShapes[i].get());
+			int vertexCount = polygon->GetVertexCount();
 
-			// Go through each points of the triangle shape
-			for(int pointIndex = 0; pointIndex < polygon->GetVertexCount(); pointIndex++)
+			// Each edge of the polygon
+			for(int pointIndex = 0; pointIndex < vertexCount; pointIndex++)
 			{
-				// Add each point to the buffer
 				b2Vec2 point2D = polygon->GetVertex(pointIndex);
-				localPositions3D.push_back(glm::vec3(
-					point2D.x * PHYSICS_PIXELS_PER_METER,
-					0.0f,
-					point2D.y * PHYSICS_PIXELS_PER_METER));
+				b2Vec2 nextPoint2D = polygon->GetVertex((pointIndex + 1) % vertexCount);
+
+				lines.push_back(toWorld(point2D.x, point2D.y));
+				lines.push_back(toWorld(nextPoint2D.x, nextPoint2D.y));
 			}
 		}
-
-		drawMode = GL_TRIANGLES;
-		// Draw lines only, but they are still rasterized as triangles
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // Must reset this after rendering!
 	}
-
-	positionBuffer.setMutableData(localPositions3D, GL_STATIC_DRAW);
-
-	glm::vec3 position = getPosition();
-	glm::mat4 modelMatrix = generateModelMatrix(
-		glm::vec3(position.x, other3DCoord, position.z),
-		glm::vec3(0.0f, getRotation().y, 0.0f), // Ignore any rotation apart Box2D's rotation
-		glm::vec3(1.0f)); // No scaling here! The scaling is built-in the vertices
-
-	glm::mat4 MVP = camera->getProjectionMatrix() * camera->getViewMatrix() * modelMatrix;
-
-	glUseProgram(shader->getID());
-	glUniformMatrix4fv(shader->findUniform("MVP"), 1, GL_FALSE, &MVP[0][0]);
-	glUniform3f(shader->findUniform("color"), color.r, color.g, color.b);
-
-	glEnableVertexAttribArray(0); // Number to give to OpenGL VertexAttribPointer
-	positionBuffer.bind(GL_ARRAY_BUFFER);
-
-	// Give it to the shader. Each time the vertex shader runs, it will get the next element of this buffer.
-	glVertexAttribPointer(
-		0,					// Attribute 0, no particular reason but same as the vertex shader's layout and glEnableVertexAttribArray
-		3,					// Size. Number of values per vertex, must be 1, 2, 3 or 4.
-		GL_FLOAT,			// Type of data (GLfloats)
-		GL_FALSE,			// Normalized?
-		0,					// Stride
-		(void*)0			// Array buffer offset
-		);
-
-	glDisable(GL_CULL_FACE); // Must re-enable after!
-
-	// Draw!
-	glDrawArrays(
-		drawMode, // Mode
-		0, // First
-		localPositions3D.size() // Count
-		);
-
-	glDisableVertexAttribArray(0);
-	glPolygonMode(GRAPHICS_RASTERIZE_FACE, GRAPHICS_RASTERIZE_MODE); // Reset
-	glEnable(GL_CULL_FACE);
 }
 
 // Will use the body's position
@@ -1160,3 +1174,19 @@ void PhysicsBody::renderDebugShape(constShaderPointer shader, const Camera* came
 {
 	renderDebugShape(shader, camera, mPosition.y);
 }
+
+// Static
+// Called at the start of each step
+void PhysicsBody::clearQueuedDebugShapes()
+{
+	gQueuedDebugLines.clear();
+	gQueuedDebugLineShader = nullptr;
+}
+
+// Static
+// Copies, since frames without steps still need to draw them
+void PhysicsBody::copyQueuedDebugLines(vec3Vector& lines, constShaderPointer& shader)
+{
+	lines = gQueuedDebugLines;
+	shader = gQueuedDebugLineShader;
+}
\ No newline at end of file
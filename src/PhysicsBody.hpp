@@ -24,6 +24,7 @@
 
 #include <Definitions.hpp>
 #include <ObjectGeometry.hpp>
+#include <SceneSnapshot.hpp>
 
 #include <Box2D.h>
 
@@ -85,6 +86,11 @@ private:
 
 	int mType; // Can't change
 
+	// Transform at the start of the last step, for rendering in between steps (see generateModelMatrix(float))
+	glm::vec3 mPreviousPosition;
+	glm::vec3 mPreviousRotation;
+	bool mHasPreviousTransform; // False until the first step
+
 	// Static functions
 	static shapeVector createShapesFromObjectGeometry(const ObjectGeometry& objectGeometry,
 		bool generateCircular, float pixelsPerMeter, glm::vec3 rotation, glm::vec3 scaling);
@@ -176,6 +182,7 @@ public:
 	void setRotationInRadians(glm::vec3 angle);
 	glm::vec3 getRotation() const;
 	glm::vec3 getRotationInRadians() const;
+	glm::vec3 getScaling() const;
 
 	void setVelocity(glm::vec3 velocity);
 	glm::vec3 getVelocity() const;
@@ -191,12 +198,20 @@ public:
 	bool addToWorld(b2World* world);
 	void removeFromWorld();
 
+	glm::vec3 getInterpolatedPosition(float interpolation) const;
+	glm::vec3 getInterpolatedRotation(float interpolation) const;
+
 	glm::mat4 generateModelMatrix();
+	glm::mat4 generateModelMatrix(float interpolation) const;
 
 	void step(float timeStep);
 
 	void renderDebugShape(constShaderPointer shader, const Camera* camera, float other3DCoord);
 	void renderDebugShape(constShaderPointer shader, const Camera* camera);
+	void appendDebugLines(vec3Vector& lines, float other3DCoord, float interpolation) const;
+
+	static void clearQueuedDebugShapes();
+	static void copyQueuedDebugLines(vec3Vector& lines, constShaderPointer& shader);
 };
 
 #endif /* PHYSICS_BODY_HPP */
@@ -0,0 +1,320 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <Profiler.hpp>
+
+#include <Utils.hpp>
+#include <Definitions.hpp> // For ENGINE_NAME
+
+#include <algorithm> // For std::sort
+#include <cmath> // For ceil()
+#include <cstring> // For strcmp()
+#include <fstream>
+#include <memory> // For smart pointers
+#include <mutex>
+#include <vector>
+
+namespace Profiler
+{
+// One recorded zone
+// Written by one thread only, read by anyone. Uses a sequence number (seqlock) so readers can tell if
+// the event was overwritten while they were reading it. Atomics so this isn't a data race, relaxed so it stays cheap.
+struct Event
+{
+	std::atomic<Uint64> sequence; // Index + 1 when the event is complete, 0 while writing
+	std::atomic<const char*> name;
+	std::atomic<Uint64> start;
+	std::atomic<Uint64> end;
+	std::atomic<int> depth;
+};
+
+// A copy that is safe to use
+struct EventCopy
+{
+	const char* name;
+	Uint64 start;
+	Uint64 end;
+	int depth;
+	int threadID;
+};
+
+struct ThreadBuffer
+{
+	std::unique_ptr<Event[]> events; // Ring buffer of PROFILER_EVENTS_PER_THREAD events
+	std::atomic<Uint64> writeIndex; // Total number of events written, never wraps in practice
+	int threadID;
+	std::string threadName;
+};
+
+std::atomic<bool> gEnabled(false);
+std::atomic<Uint64> gClearTicks(0); // Events started before this are ignored, see clear()
+
+// Buffers are never freed, so readers can still look at them after their thread is gone
+std::mutex gBuffersMutex; // Only locked when a thread records for the first time, and when reading
+std::vector<std::unique_ptr<ThreadBuffer>> gBuffers;
+
+thread_local ThreadBuffer* tBuffer = nullptr;
+thread_local int tDepth = 0;
+
+static ThreadBuffer& getThreadBuffer()
+{
+	if(!tBuffer)
+	{
+		std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+		buffer->events.reset(new Event[PROFILER_EVENTS_PER_THREAD]);
+
+		for(int i = 0; i < PROFILER_EVENTS_PER_THREAD; i++)
+			buffer->events[i].sequence.store(0, std::memory_order_relaxed);
+
+		buffer->writeIndex.store(0, std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(gBuffersMutex);
+
+		buffer->threadID = static_cast<int>(gBuffers.size());
+		buffer->threadName = "Thread " + std::to_string(buffer->threadID);
+
+		tBuffer = buffer.get();
+		gBuffers.push_back(std::move(buffer));
+	}
+
+	return *tBuffer;
+}
+
+// Copies all valid events, from all threads
+static std::vector<EventCopy> copyEvents()
+{
+	std::vector<EventCopy> copies;
+	Uint64 clearTicks = gClearTicks.load(std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> lock(gBuffersMutex);
+
+	for(const auto& buffer : gBuffers)
+	{
+		Uint64 writeIndex = buffer->writeIndex.load(std::memory_order_acquire);
+		Uint64 firstIndex = writeIndex > PROFILER_EVENTS_PER_THREAD ? writeIndex - PROFILER_EVENTS_PER_THREAD : 0;
+
+		for(Uint64 index = firstIndex; index < writeIndex; index++)
+		{
+			const Event& event = buffer->events[index % PROFILER_EVENTS_PER_THREAD];
+
+			Uint64 sequenceBefore = event.sequence.load(std::memory_order_acquire);
+
+			EventCopy copy;
+			copy.name = event.name.load(std::memory_order_relaxed);
+			copy.start = event.start.load(std::memory_order_relaxed);
+			copy.end = event.end.load(std::memory_order_relaxed);
+			copy.depth = event.depth.load(std::memory_order_relaxed);
+			copy.threadID = buffer->threadID;
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			Uint64 sequenceAfter = event.sequence.load(std::memory_order_relaxed);
+
+			// Overwritten by the thread while we were reading, skip it
+			if(sequenceBefore != index + 1 || sequenceAfter != sequenceBefore)
+				continue;
+
+			if(copy.start < clearTicks)
+				continue;
+
+			copies.push_back(copy);
+		}
+	}
+
+	return copies;
+}
+
+static std::string escapeJSONString(const std::string& string)
+{
+	std::string escaped;
+
+	for(char character : string)
+	{
+		if(character == '"' || character == '\\')
+			escaped += '\\';
+
+		if(static_cast<unsigned char>(character) < 0x20) // Control characters, not worth escaping properly
+			escaped += ' ';
+		else
+			escaped += character;
+	}
+
+	return escaped;
+}
+
+void setEnabled(bool enabled)
+{
+	gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool isEnabled()
+{
+	return gEnabled.load(std::memory_order_relaxed);
+}
+
+void setThreadName(const std::string& name)
+{
+	ThreadBuffer& buffer = getThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(gBuffersMutex); // Readers use the name
+	buffer.threadName = name;
+}
+
+// Doesn't touch the ring buffers (other threads are writing in them), events are only hidden
+void clear()
+{
+	gClearTicks.store(SDL_GetPerformanceCounter(), std::memory_order_relaxed);
+}
+
+// Writes everything recorded to a file that can be opened in chrome://tracing
+// See https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+bool exportChromeTrace(const std::string& filePath)
+{
+	std::vector<EventCopy> events = copyEvents();
+
+	std::ofstream file(filePath, std::ios::out | std::ios::trunc);
+
+	if(!file)
+	{
+		Utils::WARN("Cannot open '" + filePath + "' to export the profiler trace!");
+		return false;
+	}
+
+	double ticksPerMicrosecond = static_cast<double>(SDL_GetPerformanceFrequency()) / 1000000.0;
+
+	Uint64 firstTicks = 0;
+	if(!events.empty())
+	{
+		firstTicks = std::min_element(events.begin(), events.end(), [](const EventCopy& first, const EventCopy& second)
+		{
+			return first.start < second.start;
+		})->start;
+	}
+
+	file.setf(std::ios::fixed); // Long runs have big timestamps, don't lose precision to scientific notation
+	file.precision(3); // Nanoseconds
+
+	file << "{\"traceEvents\":[\n";
+
+	bool first = true;
+
+	{
+		std::lock_guard<std::mutex> lock(gBuffersMutex);
+
+		for(const auto& buffer : gBuffers) // Thread names
+		{
+			file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->threadID
+				<< ",\"args\":{\"name\":\"" << escapeJSONString(buffer->threadName) << "\"}}";
+			first = false;
+		}
+	}
+
+	for(const auto& event : events)
+	{
+		// "X" is a complete event, times are in microseconds
+		double start = static_cast<double>(event.start - firstTicks) / ticksPerMicrosecond;
+		double duration = static_cast<double>(event.end - event.start) / ticksPerMicrosecond;
+
+		file << (first ? "" : ",\n") << "{\"name\":\"" << escapeJSONString(event.name) << "\",\"cat\":\"" ENGINE_NAME "\""
+			<< ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.threadID
+			<< ",\"ts\":" << start << ",\"dur\":" << duration
+			<< ",\"args\":{\"depth\":" << event.depth << "}}";
+		first = false;
+	}
+
+	file << "\n]}\n";
+	file.close();
+
+	Utils::LOGPRINT("Exported " + std::to_string(events.size()) + " profiler events to '" + filePath + "'.");
+	return true;
+}
+
+// Heavy-ish, goes through all recorded events. Fine a few times per second.
+ZoneStats getZoneStats(const std::string& name)
+{
+	ZoneStats stats;
+	stats.min = 0.0f;
+	stats.average = 0.0f;
+	stats.p99 = 0.0f;
+	stats.count = 0;
+
+	std::vector<EventCopy> events = copyEvents();
+
+	// Zone names are often the same literal in different files, so compare the strings
+	events.erase(std::remove_if(events.begin(), events.end(), [&name](const EventCopy& event)
+	{
+		return std::strcmp(event.name, name.c_str()) != 0;
+	}), events.end());
+
+	if(events.empty())
+		return stats;
+
+	// Only keep the latest ones
+	std::sort(events.begin(), events.end(), [](const EventCopy& first, const EventCopy& second)
+	{
+		return first.end < second.end;
+	});
+
+	std::size_t firstIndex = events.size() > PROFILER_STATS_WINDOW ? events.size() - PROFILER_STATS_WINDOW : 0;
+
+	float ticksPerMilisecond = static_cast<float>(SDL_GetPerformanceFrequency()) / 1000.0f;
+	std::vector<float> durations;
+
+	for(std::size_t i = firstIndex; i < events.size(); i++)
+		durations.push_back(static_cast<float>(events[i].end - events[i].start) / ticksPerMilisecond);
+
+	std::sort(durations.begin(), durations.end());
+
+	float total = 0.0f;
+	for(float duration : durations)
+		total += duration;
+
+	std::size_t p99Index = static_cast<std::size_t>(std::ceil(durations.size() * 0.99f)) - 1;
+
+	stats.min = durations.front();
+	stats.average = total / durations.size();
+	stats.p99 = durations[p99Index];
+	stats.count = static_cast<int>(durations.size());
+
+	return stats;
+}
+
+void directly_recordZone(const char* name, Uint64 start, Uint64 end, int depth)
+{
+	ThreadBuffer& buffer = getThreadBuffer();
+
+	Uint64 index = buffer.writeIndex.load(std::memory_order_relaxed); // Only we write to it
+	Event& event = buffer.events[index % PROFILER_EVENTS_PER_THREAD];
+
+	event.sequence.store(0, std::memory_order_relaxed); // Readers will skip it while we write
+	std::atomic_thread_fence(std::memory_order_release);
+
+	event.name.store(name, std::memory_order_relaxed);
+	event.start.store(start, std::memory_order_relaxed);
+	event.end.store(end, std::memory_order_relaxed);
+	event.depth.store(depth, std::memory_order_relaxed);
+
+	event.sequence.store(index + 1, std::memory_order_release);
+	buffer.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+int& directly_getDepth()
+{
+	return tDepth;
+}
+}
\ No newline at end of file
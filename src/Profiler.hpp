@@ -0,0 +1,109 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// A small CPU frame profiler
+// Put PROFILE_ZONE("Name") at the top of a scope, the time spent in that scope will be recorded (when the profiler is on).
+// Zones can be nested. Each thread records into its own ring buffer, without locks.
+// The recording can be opened in Chrome (chrome://tracing) or queried for stats.
+//
+// Define SDL3D_NO_PROFILER to compile all zones out.
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <SDL.h> // For Uint64 and the performance counter
+
+#include <atomic>
+#include <string>
+
+#define PROFILER_EVENTS_PER_THREAD 65536 // Ring buffer size, older events get overwritten
+#define PROFILER_STATS_WINDOW 300 // Number of last samples used for zone stats
+
+#define PROFILER_CONCAT_DIRECTLY(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_DIRECTLY(a, b) // Expands __LINE__ before concatenating
+
+#ifndef SDL3D_NO_PROFILER
+	// Name must be a string literal (or live forever), only the pointer is kept!
+	#define PROFILE_ZONE(name) Profiler::Zone PROFILER_CONCAT(profilerZone, __LINE__)(name)
+#else
+	#define PROFILE_ZONE(name) ((void)0)
+#endif
+
+namespace Profiler
+{
+	// Stats of the last PROFILER_STATS_WINDOW times a zone was recorded, in miliseconds
+	struct ZoneStats
+	{
+		float min;
+		float average;
+		float p99;
+		int count; // Number of samples used, 0 if the zone wasn't recorded
+	};
+
+	void setEnabled(bool enabled);
+	bool isEnabled();
+
+	void setThreadName(const std::string& name); // Shown in the trace, for the calling thread
+	void clear(); // Forget everything recorded until now
+
+	bool exportChromeTrace(const std::string& filePath);
+	ZoneStats getZoneStats(const std::string& name);
+
+	// Use the macros above to access these
+	extern std::atomic<bool> gEnabled;
+
+	void directly_recordZone(const char* name, Uint64 start, Uint64 end, int depth);
+	int& directly_getDepth(); // Nesting depth of the calling thread
+
+	// Records from construction to destruction
+	// Everything is inline, so a zone is a single boolean check when the profiler is off
+	class Zone
+	{
+	private:
+		const char* mName;
+		Uint64 mStart; // Performance counter ticks
+		int mDepth;
+		bool mActive; // Not recording if the profiler was off when we started
+
+	public:
+		explicit Zone(const char* name)
+			: mName(name), mStart(0), mDepth(0), mActive(gEnabled.load(std::memory_order_relaxed))
+		{
+			if(mActive)
+			{
+				mDepth = directly_getDepth()++;
+				mStart = SDL_GetPerformanceCounter();
+			}
+		}
+
+		~Zone()
+		{
+			if(mActive)
+			{
+				directly_recordZone(mName, mStart, SDL_GetPerformanceCounter(), mDepth);
+				directly_getDepth()--;
+			}
+		}
+
+		Zone(const Zone& other) = delete;
+		Zone& operator=(const Zone& other) = delete;
+	};
+}
+
+#endif /* PROFILER_HPP */
\ No newline at end of file
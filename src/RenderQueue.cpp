@@ -0,0 +1,376 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <RenderQueue.hpp>
+
+#include <Definitions.hpp>
+#include <Profiler.hpp>
+
+#include <algorithm> // For std::min() and std::max()
+#include <cstddef> // For offsetof()
+#include <mutex>
+#include <utility> // For std::swap()
+
+// Sort key layout, from the most significant bits.
+// IDs that don't fit are truncated: two of them might then be mixed together, which only costs a few state changes.
+#define RENDER_QUEUE_PASS_BITS 4
+#define RENDER_QUEUE_SHADER_BITS 12
+#define RENDER_QUEUE_TEXTURE_BITS 12
+#define RENDER_QUEUE_GEOMETRY_BITS 16
+#define RENDER_QUEUE_DEPTH_BITS 20
+
+#define RENDER_QUEUE_RADIX_BITS 8 // Bits sorted per pass
+#define RENDER_QUEUE_RADIX_BUCKETS (1 << RENDER_QUEUE_RADIX_BITS)
+
+std::mutex gLastFrameStatsMutex;
+RenderStats gLastFrameStats;
+
+RenderStats::RenderStats()
+{
+	drawCalls = 0;
+	shaderChanges = 0;
+	textureChanges = 0;
+	geometryChanges = 0;
+	stateChanges = 0;
+	instancedObjects = 0;
+	mergedObjects = 0;
+	gpuFrameTime = 0.0f;
+}
+
+RenderQueue::RenderQueue()
+{
+	mShader = 0;
+	mTexture = 0;
+	mVertexArray = 0;
+	mBoundRange = ObjectGeometry::DrawRange();
+	mDefaultVertexArray = 0;
+	mInstanceBuffer = 0;
+	mInstanceOffset = 0;
+	mUniformBufferAlignment = 0;
+}
+
+// Static
+// Depth is the distance in front of the camera, closer comes first
+Uint64 RenderQueue::makeKey(int pass, GLuint shader, GLuint texture, GLuint geometry, float depth)
+{
+	const Uint64 depthMax = (1ull << RENDER_QUEUE_DEPTH_BITS) - 1;
+	float normalizedDepth = std::max(0.0f, std::min(depth / RENDER_QUEUE_MAX_DEPTH, 1.0f));
+
+	Uint64 key = static_cast<Uint64>(pass) & ((1ull << RENDER_QUEUE_PASS_BITS) - 1);
+	key = (key << RENDER_QUEUE_SHADER_BITS) | (shader & ((1ull << RENDER_QUEUE_SHADER_BITS) - 1));
+	key = (key << RENDER_QUEUE_TEXTURE_BITS) | (texture & ((1ull << RENDER_QUEUE_TEXTURE_BITS) - 1));
+	key = (key << RENDER_QUEUE_GEOMETRY_BITS) | (geometry & ((1ull << RENDER_QUEUE_GEOMETRY_BITS) - 1));
+	key = (key << RENDER_QUEUE_DEPTH_BITS) | static_cast<Uint64>(normalizedDepth * depthMax);
+
+	return key;
+}
+
+void RenderQueue::clear()
+{
+	mItems.clear();
+	mBatches.clear();
+	mInstances.clear();
+}
+
+void RenderQueue::add(Uint64 key, unsigned int index)
+{
+	DrawItem item;
+	item.key = key;
+	item.index = index;
+
+	mItems.push_back(item);
+}
+
+// LSD radix sort, 8 bits at a time. Linear and stable, unlike std::sort().
+// Bytes that are the same for every item are skipped, most scenes only have a few shaders and textures.
+void RenderQueue::sort()
+{
+	PROFILE_ZONE("RenderQueue::sort");
+
+	if(mItems.size() < 2)
+		return;
+
+	mSortBuffer.resize(mItems.size());
+
+	for(int shift = 0; shift < 64; shift += RENDER_QUEUE_RADIX_BITS)
+	{
+		std::size_t offsets[RENDER_QUEUE_RADIX_BUCKETS] = {};
+
+		for(const auto& item : mItems)
+			offsets[(item.key >> shift) & (RENDER_QUEUE_RADIX_BUCKETS - 1)]++;
+
+		if(offsets[(mItems.front().key >> shift) & (RENDER_QUEUE_RADIX_BUCKETS - 1)] == mItems.size())
+			continue; // All in the same bucket, this pass wouldn't move anything
+
+		// Counts to offsets
+		std::size_t offset = 0;
+
+		for(int i = 0; i < RENDER_QUEUE_RADIX_BUCKETS; i++)
+		{
+			std::size_t count = offsets[i];
+			offsets[i] = offset;
+			offset += count;
+		}
+
+		for(const auto& item : mItems)
+			mSortBuffer[offsets[(item.key >> shift) & (RENDER_QUEUE_RADIX_BUCKETS - 1)]++] = item;
+
+		std::swap(mItems, mSortBuffer);
+	}
+}
+
+const std::vector<RenderQueue::DrawItem>& RenderQueue::getItems() const
+{
+	return mItems;
+}
+
+void RenderQueue::addBatch(std::size_t firstItem, int itemCount, int firstInstance)
+{
+	DrawBatch batch;
+	batch.firstItem = firstItem;
+	batch.itemCount = itemCount;
+	batch.firstInstance = firstInstance;
+
+	mBatches.push_back(batch);
+}
+
+const std::vector<RenderQueue::DrawBatch>& RenderQueue::getBatches() const
+{
+	return mBatches;
+}
+
+int RenderQueue::addInstance(const glm::mat4& modelMatrix, const glm::mat3& normalMatrix)
+{
+	InstanceData instance;
+	instance.modelMatrix = modelMatrix;
+	instance.normalMatrix = normalMatrix;
+
+	mInstances.push_back(instance);
+	return static_cast<int>(mInstances.size()) - 1;
+}
+
+int RenderQueue::getInstanceCount() const
+{
+	return static_cast<int>(mInstances.size());
+}
+
+// All instances of the frame at once, in the streaming buffer
+void RenderQueue::uploadInstances()
+{
+	if(mInstances.empty())
+		return;
+
+	PROFILE_ZONE("RenderQueue::uploadInstances");
+
+	mInstanceOffset = mStreamingBuffer.write(mInstances.data(), mInstances.size() * sizeof(InstanceData));
+	mInstanceBuffer = mStreamingBuffer.getID();
+}
+
+void RenderQueue::begin()
+{
+	// Something else might have changed them since the last frame
+	mShader = 0;
+	mTexture = 0;
+	mVertexArray = 0;
+	mBoundRange = ObjectGeometry::DrawRange();
+	mMergedGeometries.clear();
+
+	mStats = RenderStats();
+
+	if(mDefaultVertexArray == 0) // We are on the drawing context now
+	{
+		glGenVertexArrays(1, &mDefaultVertexArray);
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &mUniformBufferAlignment);
+	}
+
+	ObjectGeometry::deleteOrphanedVertexArrays();
+	GeometryArena::deleteOrphanedVertexArrays();
+	mStreamingBuffer.beginFrame();
+}
+
+// Written once per frame and read by every shader with the blocks, instead of setting the same uniforms for each draw.
+// They go in the streaming buffer like the instances, so we don't wait for the last frames to be done with them.
+void RenderQueue::uploadFrameUniforms(const CameraUniforms& camera, const LightsUniforms& lights)
+{
+	static_assert(sizeof(CameraUniforms) == 3 * 64, "CameraUniforms doesn't match the std140 layout!");
+	static_assert(sizeof(LightsUniforms) == 16 + LIGHT_MAX_COUNT * 48, "LightsUniforms doesn't match the std140 layout!");
+
+	// Always a power of 2
+	std::size_t alignment = std::max(static_cast<std::size_t>(mUniformBufferAlignment), static_cast<std::size_t>(STREAMING_BUFFER_DEFAULT_ALIGNMENT));
+
+	std::size_t cameraOffset = mStreamingBuffer.write(&camera, sizeof(CameraUniforms), alignment);
+	glBindBufferRange(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_CAMERA_BINDING, mStreamingBuffer.getID(), cameraOffset, sizeof(CameraUniforms));
+
+	std::size_t lightsOffset = mStreamingBuffer.write(&lights, sizeof(LightsUniforms), alignment);
+	glBindBufferRange(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_LIGHTS_BINDING, mStreamingBuffer.getID(), lightsOffset, sizeof(LightsUniforms));
+}
+
+void RenderQueue::end()
+{
+	glBindVertexArray(mDefaultVertexArray);
+	mVertexArray = mDefaultVertexArray;
+	mBoundRange = ObjectGeometry::DrawRange(); // Let go of the arena page
+
+	mStreamingBuffer.endFrame();
+
+	mStats.stateChanges = mStats.shaderChanges + mStats.textureChanges + mStats.geometryChanges;
+	mStats.instancedObjects = static_cast<int>(mInstances.size());
+	mStats.gpuFrameTime = static_cast<float>(mGPUTimer.getLastTime()) / 1000000.0f; // End the timer before for the newest one
+
+	std::lock_guard<std::mutex> lock(gLastFrameStatsMutex);
+	gLastFrameStats = mStats;
+}
+
+bool RenderQueue::useShader(const Shader& shader)
+{
+	if(shader.getID() == mShader)
+		return false;
+
+	glUseProgram(shader.getID());
+	mShader = shader.getID();
+	mStats.shaderChanges++;
+
+	return true;
+}
+
+void RenderQueue::bindTexture(GLuint texture)
+{
+	if(texture == mTexture)
+		return;
+
+	glActiveTexture(GL_TEXTURE0); // Set the active texture unit, you can have more than 1 texture at once
+	glBindTexture(GL_TEXTURE_2D, texture);
+	mTexture = texture;
+	mStats.textureChanges++;
+}
+
+// The VAO has the attributes and the index buffer, see ObjectGeometry::getVertexArray()
+// Geometry in the arena shares the VAO of its page, only where it is in there changes.
+void RenderQueue::bindGeometry(const ObjectGeometry& geometry, const std::shared_ptr<const GeometryArena::Location>& arenaLocation,
+	int layout, bool instanced)
+{
+	mBoundRange = geometry.getDrawRange(layout, instanced, arenaLocation); // Creates the VAO if needed, which binds it
+
+	if(mBoundRange.vertexArray == mVertexArray)
+		return;
+
+	glBindVertexArray(mBoundRange.vertexArray);
+	mVertexArray = mBoundRange.vertexArray;
+	mStats.geometryChanges++;
+}
+
+// Draws the geometry bound with bindGeometry(), and the merged ones with it
+void RenderQueue::drawElements()
+{
+	if(!mMergedGeometries.empty())
+	{
+		mMultiDrawCounts.assign(1, mBoundRange.indexCount);
+		mMultiDrawOffsets.assign(1, (const void*)mBoundRange.indexOffset);
+		mMultiDrawBaseVertices.assign(1, mBoundRange.baseVertex);
+
+		// Same page and index type as the bound one (see SceneSnapshot::canMergeTogether()), only where they are changes
+		for(const auto& merged : mMergedGeometries)
+		{
+			mMultiDrawCounts.push_back(merged.first->getIndexCount());
+			mMultiDrawOffsets.push_back((const void*)merged.second->indexOffset);
+			mMultiDrawBaseVertices.push_back(merged.second->baseVertex);
+		}
+
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, mMultiDrawCounts.data(), mBoundRange.indexType,
+			mMultiDrawOffsets.data(), static_cast<GLsizei>(mMultiDrawCounts.size()), mMultiDrawBaseVertices.data());
+
+		mStats.drawCalls++;
+		mStats.mergedObjects += static_cast<int>(mMergedGeometries.size()) + 1;
+		mMergedGeometries.clear();
+		return;
+	}
+
+	// The base vertex and offset are 0 for geometry with its own buffers
+	glDrawElementsBaseVertex(
+		GL_TRIANGLES,                          // Mode
+		mBoundRange.indexCount,                // Count
+		mBoundRange.indexType,                 // Type
+		(void*)mBoundRange.indexOffset,        // Element array buffer offset
+		mBoundRange.baseVertex                 // Added to each index
+	);
+
+	mStats.drawCalls++;
+}
+
+// There is no glDrawElementsInstancedBaseInstance() in OpenGL 3.3, so the instance attributes point
+// to the first instance of this draw instead (which is somewhere in the streaming buffer)
+void RenderQueue::drawElementsInstanced(int firstInstance, int instanceCount)
+{
+	std::size_t firstInstanceOffset = mInstanceOffset + firstInstance * sizeof(InstanceData);
+	glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+
+	for(int i = 0; i < 4; i++)
+	{
+		std::size_t offset = firstInstanceOffset + offsetof(InstanceData, modelMatrix) + i * sizeof(glm::vec4);
+		glVertexAttribPointer(VERTEX_INSTANCE_MODEL_MATRIX_LOCATION + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offset);
+	}
+
+	for(int i = 0; i < 3; i++)
+	{
+		std::size_t offset = firstInstanceOffset + offsetof(InstanceData, normalMatrix) + i * sizeof(glm::vec3);
+		glVertexAttribPointer(VERTEX_INSTANCE_NORMAL_MATRIX_LOCATION + i, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offset);
+	}
+
+	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mBoundRange.indexCount, mBoundRange.indexType,
+		(void*)mBoundRange.indexOffset, instanceCount, mBoundRange.baseVertex);
+	mStats.drawCalls++;
+}
+
+// Call before the render function of a merged batch, for all of its objects but the first (see SceneSnapshot::render())
+void RenderQueue::addMergedGeometry(const ObjectGeometry& geometry, const GeometryArena::Location& arenaLocation)
+{
+	mMergedGeometries.push_back(std::make_pair(&geometry, &arenaLocation));
+}
+
+DebugRenderer& RenderQueue::getDebugRenderer()
+{
+	return mDebugRenderer;
+}
+
+StreamingBuffer& RenderQueue::getStreamingBuffer()
+{
+	return mStreamingBuffer;
+}
+
+RenderTarget& RenderQueue::getRenderTarget()
+{
+	return mRenderTarget;
+}
+
+GPUTimer& RenderQueue::getGPUTimer()
+{
+	return mGPUTimer;
+}
+
+const RenderStats& RenderQueue::getStats() const
+{
+	return mStats;
+}
+
+// Static
+RenderStats RenderQueue::getLastFrameStats()
+{
+	std::lock_guard<std::mutex> lock(gLastFrameStatsMutex);
+	return gLastFrameStats;
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Draws objects in an order that changes as little OpenGL state as possible.
+// Each draw gets a 64-bit sort key: pass, shader, texture, geometry, then depth (front to back, so the depth test
+// throws away more hidden fragments). Keys are radix sorted, so consecutive draws share as much state as possible.
+//
+// While drawing, the queue remembers what is bound, and only calls OpenGL when something is actually different.
+// Render functions (see ObjectSnapshot) go through useShader(), bindTexture(), bindGeometry() and drawElements() for that.
+//
+// Objects next to each other in the sorted queue that share everything but their model matrix can be drawn in one
+// instanced draw. Their matrices go in the instance buffer (see addInstance()), uploaded once per frame.
+//
+// Geometry in the GeometryArena is drawn with base vertex draws, from the VAO of its page. Keys sort by page, so these
+// are rarely rebound. Objects that only differ by their geometry (same page, same model matrix, like the parts of a level)
+// are drawn with one glMultiDrawElementsBaseVertex(), see SceneSnapshot::batchObjects() and addMergedGeometry().
+//
+// The queue also keeps the RenderTarget the scene is drawn in and the GPUTimer of the frame, both belong to the drawing context.
+//
+// The camera and the lights are the same for every draw, they go in uniform buffers once per frame (see uploadFrameUniforms()).
+//
+// Everything written each frame (instances, uniform blocks, debug lines) goes in the same StreamingBuffer, so we never wait
+// for the GPU to be done with the last frames' data. Its frame starts in begin() and ends in end(), draw the debug lines before.
+
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include <ObjectGeometry.hpp>
+#include <Shader.hpp>
+#include <DebugRenderer.hpp>
+#include <StreamingBuffer.hpp>
+#include <RenderTarget.hpp>
+#include <GPUTimer.hpp>
+#include <Definitions.hpp>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <SDL.h> // For Uint64
+
+#include <memory> // For smart pointers
+#include <utility> // For std::pair
+#include <vector>
+
+// What a frame cost, see RenderQueue::getLastFrameStats()
+struct RenderStats
+{
+	int drawCalls;
+	int shaderChanges;
+	int textureChanges;
+	int geometryChanges; // Vertex array objects
+	int stateChanges; // All of the above
+	int instancedObjects; // Objects drawn with instanced draws, part of a draw call each
+	int mergedObjects; // Objects drawn with multi-draws, same
+	float gpuFrameTime; // In milliseconds, a few frames late (see GPUTimer). 0 if unknown.
+
+	RenderStats();
+};
+
+class RenderQueue
+{
+public:
+	struct DrawItem
+	{
+		Uint64 key;
+		unsigned int index; // Of whatever the queue was filled from (SceneSnapshot::objects)
+	};
+
+	// Read by the instanced shaders, see VERTEX_INSTANCE_*_LOCATION
+	struct InstanceData
+	{
+		glm::mat4 modelMatrix;
+		glm::mat3 normalMatrix; // Inverse transpose of the model matrix, model space
+	};
+
+	// std140 layouts of the uniform blocks, must match the shaders. vec3s would be padded to 16 bytes anyway, so they are vec4s.
+	struct CameraUniforms
+	{
+		glm::mat4 viewMatrix;
+		glm::mat4 projectionMatrix;
+		glm::mat4 viewProjectionMatrix;
+	};
+
+	struct LightUniforms
+	{
+		glm::vec4 position; // Camera space, w is unused
+		glm::vec4 diffuseColor; // w is the power
+		glm::vec4 specularColor; // w is unused
+	};
+
+	struct LightsUniforms
+	{
+		GLint lightCount;
+		GLint padding[3]; // Arrays of structures start on 16 bytes
+		LightUniforms lights[LIGHT_MAX_COUNT];
+	};
+
+	// Items drawn together
+	struct DrawBatch
+	{
+		std::size_t firstItem;
+		int itemCount;
+		int firstInstance; // In the instance buffer, -1 if the items are drawn one by one (or merged if there are more than one)
+	};
+
+private:
+	std::vector<DrawItem> mItems;
+	std::vector<DrawItem> mSortBuffer; // Kept to avoid reallocating it each frame
+
+	std::vector<DrawBatch> mBatches;
+	std::vector<InstanceData> mInstances;
+
+	StreamingBuffer mStreamingBuffer;
+	GLuint mInstanceBuffer; // Where the instances of this frame are, the streaming buffer can change when it grows
+	std::size_t mInstanceOffset; // In bytes
+	GLint mUniformBufferAlignment; // Uniform blocks must start on a multiple of this, 0 until we are on the drawing context
+
+	// What is bound right now, only valid between begin() and end()
+	GLuint mShader;
+	GLuint mTexture;
+	GLuint mVertexArray;
+	ObjectGeometry::DrawRange mBoundRange; // Of the geometry bound with bindGeometry()
+
+	// Drawn with the next drawElements(), on the bound page. The snapshot keeps them alive.
+	std::vector<std::pair<const ObjectGeometry*, const GeometryArena::Location*>> mMergedGeometries;
+	std::vector<GLsizei> mMultiDrawCounts; // Kept to avoid reallocating them
+	std::vector<const void*> mMultiDrawOffsets;
+	std::vector<GLint> mMultiDrawBaseVertices;
+
+	GLuint mDefaultVertexArray; // Bound after the queue, for what doesn't have its own. Deleted with the context.
+
+	DebugRenderer mDebugRenderer; // Kept here so its buffer lives as long as the queue
+	RenderTarget mRenderTarget; // Same, lives on the drawing context
+	GPUTimer mGPUTimer;
+
+	RenderStats mStats;
+
+public:
+	RenderQueue();
+
+	static Uint64 makeKey(int pass, GLuint shader, GLuint texture, GLuint geometry, float depth);
+
+	void clear();
+	void add(Uint64 key, unsigned int index);
+	void sort();
+	const std::vector<DrawItem>& getItems() const;
+
+	// Call between begin() and the first draw
+	void addBatch(std::size_t firstItem, int itemCount, int firstInstance);
+	const std::vector<DrawBatch>& getBatches() const;
+	int addInstance(const glm::mat4& modelMatrix, const glm::mat3& normalMatrix); // Returns its index
+	int getInstanceCount() const;
+	void uploadInstances();
+
+	void begin(); // Forgets what is bound, call before drawing
+	void uploadFrameUniforms(const CameraUniforms& camera, const LightsUniforms& lights); // Call after begin()
+	void end(); // Binds the default VAO back, ends the streaming buffer's frame and publishes the stats
+
+	bool useShader(const Shader& shader); // Returns true if it changed. Uniforms stay with each shader, see Shader::setUniform().
+	void bindTexture(GLuint texture); // On unit 0
+	// VERTEX_LAYOUT_*. Arena location is the object's, see ObjectSnapshot::arenaLocation.
+	void bindGeometry(const ObjectGeometry& geometry, const std::shared_ptr<const GeometryArena::Location>& arenaLocation,
+		int layout, bool instanced = false);
+	void drawElements(); // Draws the bound geometry
+	void drawElementsInstanced(int firstInstance, int instanceCount); // Bind it instanced first
+	void addMergedGeometry(const ObjectGeometry& geometry, const GeometryArena::Location& arenaLocation); // The next drawElements() draws it too
+
+	DebugRenderer& getDebugRenderer();
+	StreamingBuffer& getStreamingBuffer();
+	RenderTarget& getRenderTarget();
+	GPUTimer& getGPUTimer();
+
+	const RenderStats& getStats() const;
+	static RenderStats getLastFrameStats(); // From any thread
+};
+
+#endif /* RENDER_QUEUE_HPP */
\ No newline at end of file
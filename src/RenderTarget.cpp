@@ -0,0 +1,157 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <RenderTarget.hpp>
+
+#include <Definitions.hpp>
+#include <Utils.hpp>
+
+#include <SDL.h> // For SDL_SaveBMP()
+
+#include <algorithm> // For std::swap_ranges()
+#include <vector>
+
+RenderTarget::RenderTarget()
+{
+	mFramebuffer = 0;
+	mColorTexture = 0;
+	mDepthRenderbuffer = 0;
+
+	mSize = glm::ivec2(0);
+	mIsComplete = false;
+}
+
+// Makes new attachments if the size changed, leaves the framebuffer bound
+bool RenderTarget::setSize(glm::ivec2 size)
+{
+	if(size.x <= 0 || size.y <= 0)
+		return false;
+
+	if(mFramebuffer != 0 && size == mSize)
+		return mIsComplete;
+
+	if(mFramebuffer == 0)
+		glGenFramebuffers(1, &mFramebuffer);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+
+	// New ones, changing the size of attached storage can leave the framebuffer incomplete on some drivers
+	glDeleteTextures(1, &mColorTexture);
+	glDeleteRenderbuffers(1, &mDepthRenderbuffer);
+
+	glGenTextures(1, &mColorTexture);
+	glBindTexture(GL_TEXTURE_2D, mColorTexture); // RenderQueue::begin() forgets what is bound, it binds its own textures again
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mColorTexture, 0);
+
+	glGenRenderbuffers(1, &mDepthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, mDepthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthRenderbuffer);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	mIsComplete = (status == GL_FRAMEBUFFER_COMPLETE);
+	mSize = size;
+
+	if(!mIsComplete)
+	{
+		Utils::WARN("Render target of " + std::to_string(size.x) + "x" + std::to_string(size.y) +
+			" is incomplete (status " + std::to_string(status) + "), drawing straight in the window instead.");
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	return mIsComplete;
+}
+
+glm::ivec2 RenderTarget::getSize() const
+{
+	return mSize;
+}
+
+void RenderTarget::bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glViewport(0, 0, mSize.x, mSize.y);
+}
+
+// Only the color, the depth isn't needed after the scene
+void RenderTarget::blit(glm::ivec2 windowSize)
+{
+	GLenum filter = (windowSize == mSize) ? GL_NEAREST : RENDER_TARGET_BLIT_FILTER;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, mFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowSize.x, windowSize.y);
+
+	glBlitFramebuffer(0, 0, mSize.x, mSize.y, 0, 0, windowSize.x, windowSize.y, GL_COLOR_BUFFER_BIT, filter);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// glReadPixels() waits for the frame to be drawn, fine for captures but don't call this every frame of a game
+bool RenderTarget::saveBMP(const std::string& filePath)
+{
+	if(!mIsComplete)
+	{
+		Utils::WARN("Cannot save render target to '" + filePath + "', it doesn't exist!");
+		return false;
+	}
+
+	std::size_t rowSize = static_cast<std::size_t>(mSize.x) * 4;
+	std::vector<unsigned char> pixels(rowSize * mSize.y);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, mFramebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, mSize.x, mSize.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	// OpenGL's first row is the bottom one
+	for(int y = 0; y < mSize.y / 2; y++)
+	{
+		std::swap_ranges(pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize,
+			pixels.begin() + (mSize.y - 1 - y) * rowSize);
+	}
+
+	// R, G, B, A in memory, whatever the byte order. Alpha is left out, the window doesn't have any either.
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(pixels.data(), mSize.x, mSize.y, 32, static_cast<int>(rowSize),
+		0xFF000000, 0x00FF0000, 0x0000FF00, 0);
+#else
+	SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(pixels.data(), mSize.x, mSize.y, 32, static_cast<int>(rowSize),
+		0x000000FF, 0x0000FF00, 0x00FF0000, 0);
+#endif
+
+	if(!surface)
+	{
+		Utils::WARN("Cannot save render target to '" + filePath + "'! SDL error: " + std::string(SDL_GetError()));
+		return false;
+	}
+
+	bool saved = (SDL_SaveBMP(surface, filePath.c_str()) == 0);
+	SDL_FreeSurface(surface);
+
+	if(!saved)
+		Utils::WARN("Cannot save render target to '" + filePath + "'! SDL error: " + std::string(SDL_GetError()));
+
+	return saved;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// An offscreen framebuffer the scene is drawn in, instead of straight in the window.
+// It can be smaller than the window (see DynamicResolution), blit() then scales it up to the window.
+// It can also be read back to a file, for captures (see saveBMP()).
+//
+// Framebuffer objects aren't shared between contexts, so it is created on the context that draws, the first time
+// it is needed, and deleted with that context (like the default VAO of RenderQueue).
+
+#ifndef RENDER_TARGET_HPP
+#define RENDER_TARGET_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+
+class RenderTarget
+{
+private:
+	GLuint mFramebuffer;
+	GLuint mColorTexture; // RGBA8, a texture so shaders could read it one day (post-processing)
+	GLuint mDepthRenderbuffer;
+
+	glm::ivec2 mSize; // 0 until created
+	bool mIsComplete;
+
+public:
+	RenderTarget();
+
+	bool setSize(glm::ivec2 size); // Call on the drawing context. Returns false if the framebuffer can't be used.
+	glm::ivec2 getSize() const;
+
+	void bind(); // For drawing, with a viewport of its size
+	void blit(glm::ivec2 windowSize); // To the window's framebuffer, scaled to fill it. Leaves it bound.
+
+	bool saveBMP(const std::string& filePath); // Waits for the GPU, only for captures
+};
+
+#endif /* RENDER_TARGET_HPP */
\ No newline at end of file
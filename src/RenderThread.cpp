@@ -0,0 +1,187 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <RenderThread.hpp>
+
+#include <Utils.hpp>
+#include <Profiler.hpp>
+#include <FramePacer.hpp>
+
+#include <utility> // For std::swap
+
+RenderThread::RenderThread()
+{
+	mWindow = nullptr;
+	mContext = nullptr;
+	mVSync = true;
+
+	mHasPendingSnapshot = false;
+	mStarting = false;
+	mStopping = false;
+	mRunning = false;
+}
+
+RenderThread::~RenderThread()
+{
+	stop();
+}
+
+void RenderThread::run()
+{
+	// The context must not be current on any other thread!
+	bool madeCurrent = (SDL_GL_MakeCurrent(mWindow, mContext) == 0);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStarting = false;
+		mRunning = madeCurrent;
+	}
+	mCondition.notify_all();
+
+	if(!madeCurrent)
+		return; // start() reports it
+
+	Profiler::setThreadName("Render");
+	FramePacer::setupVSync(mVSync); // Swap interval belongs to the context
+
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() {return mHasPendingSnapshot || mStopping;});
+
+			if(!mHasPendingSnapshot) // Stopping, and nothing left to draw
+				break;
+
+			mRenderedSnapshot.clear();
+			std::swap(mRenderedSnapshot, mPendingSnapshot);
+			mHasPendingSnapshot = false;
+		}
+		mCondition.notify_all(); // The game might be waiting to submit the next one
+
+		PROFILE_ZONE("RenderThread frame");
+
+		if(mRenderedSnapshot.resourceFence) // Make the GPU wait until new resources are ready, doesn't block us
+		{
+			glWaitSync(mRenderedSnapshot.resourceFence, 0, GL_TIMEOUT_IGNORED);
+			glDeleteSync(mRenderedSnapshot.resourceFence);
+			mRenderedSnapshot.resourceFence = nullptr;
+		}
+
+		mRenderedSnapshot.render(mRenderQueue);
+
+		if(!mRenderedSnapshot.offscreen) // Nothing was drawn in the window
+		{
+			PROFILE_ZONE("SDL_GL_SwapWindow"); // Waits for VSync, and often for the GPU to catch up
+			SDL_GL_SwapWindow(mWindow);
+		}
+
+		if(Utils::shouldPollGLErrors())
+			Utils::checkForGLErrors(); // Errors are per context, the game only checks its own
+	}
+
+	// Drop our resources while we still have a context
+	mRenderedSnapshot.clear();
+	mRenderedSnapshot = SceneSnapshot();
+
+	SDL_GL_MakeCurrent(mWindow, nullptr); // Give the context back
+}
+
+// Takes over the context, make sure it isn't current on the calling thread anymore!
+// Returns false if it failed, the caller can keep rendering by itself then.
+bool RenderThread::start(SDL_Window* window, SDL_GLContext context, bool vSync)
+{
+	if(isRunning())
+	{
+		Utils::WARN("Render thread already started!");
+		return true;
+	}
+
+	mWindow = window;
+	mContext = context;
+	mVSync = vSync;
+
+	mHasPendingSnapshot = false;
+	mStarting = true;
+	mStopping = false;
+
+	mThread = std::thread(&RenderThread::run, this);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mCondition.wait(lock, [this]() {return !mStarting;});
+
+	if(!mRunning)
+	{
+		lock.unlock();
+		mThread.join();
+
+		Utils::WARN("Render thread could not make the OpenGL context current: " + std::string(SDL_GetError()));
+		return false;
+	}
+
+	Utils::LOGPRINT("Render thread started.");
+	return true;
+}
+
+// Renders the last submitted snapshot, then gives the context back. Call before destroying the context!
+void RenderThread::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		if(!mRunning)
+			return;
+
+		mStopping = true;
+	}
+	mCondition.notify_all();
+
+	mThread.join();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mRunning = false;
+	mPendingSnapshot = SceneSnapshot(); // Already rendered, we only keep it for its memory
+}
+
+bool RenderThread::isRunning()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mRunning;
+}
+
+// Gives the snapshot to the render thread. Swaps it with an old one, so memory gets reused.
+// Waits if the previous snapshot wasn't picked up yet, so the game is never more than a frame ahead.
+void RenderThread::submit(SceneSnapshot& snapshot)
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		if(!mRunning)
+		{
+			Utils::WARN("Submitting a snapshot to a render thread that isn't running!");
+			return;
+		}
+
+		mCondition.wait(lock, [this]() {return !mHasPendingSnapshot;});
+
+		std::swap(mPendingSnapshot, snapshot);
+		mHasPendingSnapshot = true;
+	}
+	mCondition.notify_all();
+}
\ No newline at end of file
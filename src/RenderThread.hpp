@@ -0,0 +1,68 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Draws scene snapshots and swaps the window on its own thread, so the game can step the next frame meanwhile.
+// The thread owns the window's OpenGL context while it runs.
+// There is only one pending snapshot: if the game gets a frame ahead, submit() waits (one frame of latency at most).
+
+#ifndef RENDER_THREAD_HPP
+#define RENDER_THREAD_HPP
+
+#include <SceneSnapshot.hpp>
+
+#include <SDL.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class RenderThread
+{
+private:
+	SDL_Window* mWindow;
+	SDL_GLContext mContext;
+	bool mVSync;
+
+	std::thread mThread;
+	std::mutex mMutex; // Protects everything below
+	std::condition_variable mCondition;
+
+	SceneSnapshot mPendingSnapshot; // Submitted, not rendered yet
+	bool mHasPendingSnapshot;
+	bool mStarting; // Until the thread has taken the context (or failed to)
+	bool mStopping;
+	bool mRunning;
+
+	SceneSnapshot mRenderedSnapshot; // Only touched by the render thread
+	RenderQueue mRenderQueue; // Same
+
+	void run();
+
+public:
+	RenderThread();
+	~RenderThread();
+
+	bool start(SDL_Window* window, SDL_GLContext context, bool vSync);
+	void stop();
+	bool isRunning();
+
+	void submit(SceneSnapshot& snapshot);
+};
+
+#endif /* RENDER_THREAD_HPP */
\ No newline at end of file
@@ -19,6 +19,11 @@
 
 #include <ResourceManager.hpp>
 #include <Utils.hpp>
+#include <JobSystem.hpp>
+#include <Profiler.hpp>
+#include <GeometryArena.hpp>
+
+#include <SDL.h> // For SDL_RWFromFile()
 
 #include <fstream>
 #include <vector>
@@ -91,6 +96,33 @@ std::string ResourceManager::getBasename(const std::string& path)
 		return file.substr(0, firstDot); // The index of the first dot aka the length of the name
 }
 
+// Static
+// Adds "Instanced" before the first dot of the file name
+// Example: shaders/basic.v.glsl -> shaders/basicInstanced.v.glsl
+std::string ResourceManager::getInstancedShaderPath(const std::string& path)
+{
+	std::size_t lastSlash = path.find_last_of("/\\");
+	std::size_t fileStart = (lastSlash != std::string::npos) ? lastSlash + 1 : 0;
+	std::size_t firstDot = path.find('.', fileStart);
+
+	if(firstDot == std::string::npos) // No extension
+		return path + "Instanced";
+
+	return path.substr(0, firstDot) + "Instanced" + path.substr(firstDot);
+}
+
+// Static
+bool ResourceManager::fileExists(const std::string& path)
+{
+	SDL_RWops* file = SDL_RWFromFile(path.c_str(), "rb");
+
+	if(!file)
+		return false;
+
+	SDL_RWclose(file);
+	return true;
+}
+
 // The base path will be used to fetch resources and setup the script's require paths
 void ResourceManager::setBasePath(const std::string& basePath)
 {
@@ -127,6 +159,13 @@ ResourceManager::shaderPointer
 
 	shaderPointer shader(new Shader(name, vertexShaderPath, fragmentShaderPath)); // Create a smart pointer of a shader instance
 
+	// Instanced variant, if there is one. Same fragment shader, the vertex shader has "Instanced" before the extension:
+	// basic.v.glsl -> basicInstanced.v.glsl
+	std::string instancedVertexShaderPath = getInstancedShaderPath(vertexShaderPath);
+
+	if(fileExists(instancedVertexShaderPath))
+		shader->setInstancedVariant(std::make_shared<const Shader>(name + "Instanced", instancedVertexShaderPath, fragmentShaderPath));
+
 	shaderMapPair shaderPair(name, shader);
 	std::pair<shaderMap::iterator, bool> newlyAddedPair = mShaderMap.insert(shaderPair);
 	
@@ -176,6 +215,13 @@ ResourceManager::texturePointer ResourceManager::addTexture(const std::string& n
 	std::string path = getFullResourcePath(textureFile);
 	
 	texturePointer texture(new Texture(name, path, type));
+	return insertTexture(texture);
+}
+
+// Adds a texture that was already created, named after the texture
+ResourceManager::texturePointer ResourceManager::insertTexture(texturePointer texture)
+{
+	std::string name = texture->getName();
 	textureMapPair texturePair(name, texture);
 
 	std::pair<textureMap::iterator, bool> newlyAddedPair = mTextureMap.insert(texturePair); // Insert in map
@@ -197,6 +243,29 @@ ResourceManager::texturePointer ResourceManager::addTexture(const std::string& t
 	return addTexture(name, textureFile, type); // Create the texture and return it
 }
 
+// Like addTexture(textureFile, type) for each file, but the files are decoded on all cores at once
+// Only the upload to OpenGL is done one by one, on this thread
+std::vector<ResourceManager::texturePointer> ResourceManager::addTextures(const std::vector<std::string>& textureFiles, int type)
+{
+	PROFILE_ZONE("ResourceManager::addTextures");
+
+	std::vector<texturePointer> textures(textureFiles.size());
+
+	JobSystem::parallelFor(0, static_cast<int>(textureFiles.size()), 1, [this, &textureFiles, &textures, type](int begin, int end)
+	{
+		for(int i = begin; i < end; i++)
+			textures[i].reset(new Texture(getBasename(textureFiles[i]), getFullResourcePath(textureFiles[i]), type, true));
+	});
+
+	for(auto& texture : textures)
+	{
+		texture->finishLoading();
+		texture = insertTexture(texture);
+	}
+
+	return textures;
+}
+
 ResourceManager::texturePointer ResourceManager::findTexture(const std::string& name)
 {
 	textureMap::iterator got = mTextureMap.find(name);
@@ -234,6 +303,32 @@ ResourceManager::objectGeometryGroup_pointer
 	return addObjectGeometryGroup(name, objectFile);
 }
 
+// Like addObjectGeometryGroup(objectFile) for each file, but the files are parsed on all cores at once
+// Buffers are still created one by one, on this thread
+std::vector<ResourceManager::objectGeometryGroup_pointer>
+	ResourceManager::addObjectGeometryGroups(const std::vector<std::string>& objectFiles)
+{
+	PROFILE_ZONE("ResourceManager::addObjectGeometryGroups");
+
+	std::vector<ObjectGeometryGroup::geometryDataVector> parsedFiles(objectFiles.size());
+
+	JobSystem::parallelFor(0, static_cast<int>(objectFiles.size()), 1, [this, &objectFiles, &parsedFiles](int begin, int end)
+	{
+		for(int i = begin; i < end; i++)
+			ObjectGeometryGroup::parseOBJFile(getFullResourcePath(objectFiles[i]), getBasename(objectFiles[i]), parsedFiles[i]);
+	});
+
+	std::vector<objectGeometryGroup_pointer> groups;
+
+	for(std::size_t i = 0; i < objectFiles.size(); i++)
+	{
+		objectGeometryGroup_pointer group(new ObjectGeometryGroup(getBasename(objectFiles[i]), parsedFiles[i]));
+		groups.push_back(addObjectGeometryGroup(group));
+	}
+
+	return groups;
+}
+
 // Gets the name from the object geometry group pointer
 // This function lets us use Resourcemanager to keep track of custom-made object geometry groups
 ResourceManager::objectGeometryGroup_pointer
@@ -269,9 +364,11 @@ ResourceManager::objectGeometryGroup_pointer
 	return got->second;
 }
 
+// Geometry still used by objects stays, the arena is compacted around it
 void ResourceManager::clearObjectGeometryGroups()
 {
 	mObjectGeometryGroupMap.clear();
+	GeometryArena::compact();
 }
 
 /////// Scripts ///////
@@ -33,6 +33,7 @@
 
 #include <map>
 #include <memory> // For shared_ptr
+#include <vector>
 
 // All paths are prefixed with mResourceDir
 
@@ -64,6 +65,8 @@ private:
 	using soundMap     = std::map<std::string, soundPointer>;
 	using soundMapPair = std::pair<std::string, soundPointer>;
 
+	texturePointer insertTexture(texturePointer texture);
+
 	shaderMap mShaderMap; // Map, faster access: shaders[shaderName] = shaderID etc
 	textureMap mTextureMap;
 	objectGeometryGroup_map mObjectGeometryGroupMap;
@@ -78,6 +81,8 @@ public:
 	~ResourceManager();
 
 	static std::string getBasename(const std::string& path);
+	static std::string getInstancedShaderPath(const std::string& path);
+	static bool fileExists(const std::string& path);
 
 	void setBasePath(const std::string& basePath);
 	std::string getFullResourcePath(const std::string& path);
@@ -92,11 +97,13 @@ public:
 
 	texturePointer addTexture(const std::string& name, const std::string& textureFile, int type);
 	texturePointer addTexture(const std::string& textureFile, int type);
+	std::vector<texturePointer> addTextures(const std::vector<std::string>& textureFiles, int type);
 	texturePointer findTexture(const std::string& name);
 	void clearTextures();
 
 	objectGeometryGroup_pointer addObjectGeometryGroup(const std::string& name, const std::string& objectFile);
 	objectGeometryGroup_pointer addObjectGeometryGroup(const std::string& objectFile);
+	std::vector<objectGeometryGroup_pointer> addObjectGeometryGroups(const std::vector<std::string>& objectFiles);
 	objectGeometryGroup_pointer addObjectGeometryGroup(objectGeometryGroup_pointer objectGeometryGroupPointer);
 	objectGeometryGroup_pointer findObjectGeometryGroup(const std::string& objectName);
 	void clearObjectGeometryGroups();
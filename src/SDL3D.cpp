@@ -20,9 +20,12 @@
 
 #include <Game.hpp>
 #include <Utils.hpp>
+#include <Profiler.hpp>
 
 #include <stdio.h>
 #include <memory> // For smart pointers. C++ libraries have no .h
+#include <string>
+#include <cstdlib> // For atoi
 
 int main(int argc, char **argv)
 {
@@ -32,6 +35,96 @@ int main(int argc, char **argv)
 
 	Game game;
 
+	// Command line options
+	// --headless: no window, no rendering, steps as fast as possible
+	// --realtime: in headless mode, follow the real clock instead
+	// --steps N: quit after N steps
+	// --log-level debug/info/warning: hide messages under this level
+	// --gl-errors polling/callback/strict: how OpenGL errors are found, see Utils::setGLErrorMode()
+	// --no-render-thread: render on the main thread
+	// --no-vsync: don't wait for the screen, only the frame cap paces frames
+	// --jobs N: worker threads for the job system, 0 to do everything on the main thread
+	// --profile FILE: turn on the profiler and export a Chrome trace to FILE when quitting
+	// --record-input FILE: record the input of each step to FILE
+	// --replay-input FILE: replay the input recorded in FILE instead of reading the keyboard, quits when it is over
+	// --offscreen WIDTHxHEIGHT: hidden window, render at this fixed size, one frame per step as fast as possible
+	// --capture PREFIX: save frames to PREFIX + frame number + ".bmp"
+	// --capture-interval N: only save one frame out of N
+	std::string captureFilePrefix;
+	int captureInterval = 1;
+
+	for(int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+
+		if(argument == "--headless")
+			game.setHeadless(true);
+		else if(argument == "--realtime")
+			game.setHeadlessRealTime(true);
+		else if(argument == "--steps" && i + 1 < argc)
+			game.setMaxSteps(atoi(argv[++i]));
+		else if(argument == "--log-level" && i + 1 < argc)
+		{
+			std::string level = argv[++i];
+
+			if(level == "debug")
+				Utils::setLogLevel(LOG_LEVEL_DEBUG);
+			else if(level == "info")
+				Utils::setLogLevel(LOG_LEVEL_INFO);
+			else if(level == "warning")
+				Utils::setLogLevel(LOG_LEVEL_WARNING);
+			else
+				Utils::WARN("Unknown log level '" + level + "', use debug, info or warning.");
+		}
+		else if(argument == "--gl-errors" && i + 1 < argc)
+		{
+			std::string mode = argv[++i];
+
+			if(mode == "polling")
+				Utils::setGLErrorMode(GRAPHICS_ERROR_MODE_POLLING);
+			else if(mode == "callback")
+				Utils::setGLErrorMode(GRAPHICS_ERROR_MODE_CALLBACK);
+			else if(mode == "strict")
+				Utils::setGLErrorMode(GRAPHICS_ERROR_MODE_STRICT);
+			else
+				Utils::WARN("Unknown OpenGL error mode '" + mode + "', use polling, callback or strict.");
+		}
+		else if(argument == "--no-render-thread")
+			game.setThreadedRendering(false);
+		else if(argument == "--no-vsync")
+			game.setVSync(false);
+		else if(argument == "--jobs" && i + 1 < argc)
+			game.setJobWorkerCount(atoi(argv[++i]));
+		else if(argument == "--profile" && i + 1 < argc)
+		{
+			Profiler::setEnabled(true);
+			game.setProfilerTraceFile(argv[++i]);
+		}
+		else if(argument == "--record-input" && i + 1 < argc)
+			game.setInputRecordFile(argv[++i]);
+		else if(argument == "--replay-input" && i + 1 < argc)
+			game.setInputReplayFile(argv[++i]);
+		else if(argument == "--offscreen" && i + 1 < argc)
+		{
+			int width = 0;
+			int height = 0;
+
+			if(sscanf(argv[++i], "%dx%d", &width, &height) == 2)
+				game.setOffscreen(glm::ivec2(width, height));
+			else
+				Utils::WARN("Offscreen size '" + std::string(argv[i]) + "' is invalid, use WIDTHxHEIGHT.");
+		}
+		else if(argument == "--capture" && i + 1 < argc)
+			captureFilePrefix = argv[++i];
+		else if(argument == "--capture-interval" && i + 1 < argc)
+			captureInterval = atoi(argv[++i]);
+		else
+			Utils::WARN("Unknown command line argument '" + argument + "', ignoring it.");
+	}
+
+	if(!captureFilePrefix.empty())
+		game.setCapture(captureFilePrefix, captureInterval);
+
 	game.init();
 	game.startMainLoop(); // Runs the game, returns when the game quits
 
@@ -0,0 +1,231 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <SceneSnapshot.hpp>
+
+#include <Definitions.hpp>
+#include <Profiler.hpp>
+
+#include <algorithm> // For std::min()
+
+SceneSnapshot::SceneSnapshot()
+{
+	viewMatrix = glm::mat4(1.0f);
+	projectionMatrix = glm::mat4(1.0f);
+
+	viewportSize = glm::ivec2(0);
+	renderSize = glm::ivec2(0);
+	offscreen = false;
+	backgroundColor = glm::vec3(0.0f);
+
+	resourceFence = nullptr;
+}
+
+// Keeps the memory, snapshots are reused every frame
+void SceneSnapshot::clear()
+{
+	objects.clear();
+	lights.clear();
+	debugLines.clear();
+	debugLineShader = nullptr;
+
+	if(resourceFence)
+	{
+		glDeleteSync(resourceFence);
+		resourceFence = nullptr;
+	}
+}
+
+// Static
+// True if both can be in the same instanced draw
+bool SceneSnapshot::canInstanceTogether(const ObjectSnapshot& first, const ObjectSnapshot& second)
+{
+	return first.renderInstances == second.renderInstances && first.render == second.render
+		&& first.shader == second.shader && first.texture == second.texture && first.objectGeometry == second.objectGeometry;
+}
+
+// Static
+// True if both can be in the same multi-draw: only the geometry is different, and it is on the same arena page.
+// Rarely true for moving objects, but levels are often many geometries (of the same file) at the same place.
+bool SceneSnapshot::canMergeTogether(const ObjectSnapshot& first, const ObjectSnapshot& second)
+{
+	if(first.render != second.render || first.shader != second.shader || first.texture != second.texture
+		|| first.modelMatrix != second.modelMatrix)
+		return false;
+
+	return first.arenaLocation && second.arenaLocation && first.arenaLocation->page == second.arenaLocation->page
+		&& first.objectGeometry->getIndexType() == second.objectGeometry->getIndexType();
+}
+
+// The queue is sorted, so objects that can be drawn together are next to each other
+// Objects that can't be instanced might still be merged (see canMergeTogether())
+void SceneSnapshot::batchObjects(RenderQueue& queue) const
+{
+	const std::vector<RenderQueue::DrawItem>& items = queue.getItems();
+	std::size_t first = 0;
+
+	while(first < items.size())
+	{
+		const ObjectSnapshot& firstObject = objects[items[first].index];
+		std::size_t end = first + 1;
+
+		if(firstObject.renderInstances && firstObject.shader->getInstancedVariant())
+		{
+			while(end < items.size() && canInstanceTogether(firstObject, objects[items[end].index]))
+				end++;
+		}
+
+		int count = static_cast<int>(end - first);
+
+		if(count >= RENDER_QUEUE_MIN_INSTANCES)
+		{
+			int firstInstance = queue.getInstanceCount();
+
+			for(std::size_t i = first; i < end; i++)
+			{
+				const ObjectSnapshot& object = objects[items[i].index];
+				queue.addInstance(object.modelMatrix, object.normalMatrix);
+			}
+
+			queue.addBatch(first, count, firstInstance);
+		} else if(count == 1)
+		{
+			while(end < items.size() && canMergeTogether(firstObject, objects[items[end].index]))
+				end++;
+
+			queue.addBatch(first, static_cast<int>(end - first), -1);
+		} else
+		{
+			for(std::size_t i = first; i < end; i++)
+				queue.addBatch(i, 1, -1);
+		}
+
+		first = end;
+	}
+}
+
+// The camera and lights, for the shaders with the uniform blocks
+void SceneSnapshot::uploadFrameUniforms(RenderQueue& queue) const
+{
+	RenderQueue::CameraUniforms camera;
+	camera.viewMatrix = viewMatrix;
+	camera.projectionMatrix = projectionMatrix;
+	camera.viewProjectionMatrix = projectionMatrix * viewMatrix;
+
+	RenderQueue::LightsUniforms lightsUniforms = RenderQueue::LightsUniforms();
+	lightsUniforms.lightCount = static_cast<GLint>(std::min(lights.size(), static_cast<std::size_t>(LIGHT_MAX_COUNT)));
+
+	for(GLint i = 0; i < lightsUniforms.lightCount; i++)
+	{
+		const LightSnapshot& light = lights[i];
+		RenderQueue::LightUniforms& lightUniforms = lightsUniforms.lights[i];
+
+		lightUniforms.position = viewMatrix * glm::vec4(light.position, 1.0f); // Saves doing it for every vertex
+		lightUniforms.diffuseColor = glm::vec4(light.diffuseColor, light.power);
+		lightUniforms.specularColor = glm::vec4(light.specularColor, 0.0f);
+	}
+
+	queue.uploadFrameUniforms(camera, lightsUniforms);
+}
+
+// Draws the whole frame, does not swap
+// Needs a GL context on the calling thread
+void SceneSnapshot::render(RenderQueue& queue) const
+{
+	PROFILE_ZONE("SceneSnapshot::render");
+
+	queue.getGPUTimer().begin();
+
+	RenderTarget& renderTarget = queue.getRenderTarget();
+	bool useRenderTarget = renderTarget.setSize(renderSize); // False if it can't be used, draw straight in the window then
+
+	// The viewport is part of the context, and this might not be the context the game was resized on
+	if(useRenderTarget)
+		renderTarget.bind();
+	else
+		glViewport(0, 0, viewportSize.x, viewportSize.y);
+
+	// Set clear color
+	glClearColor(backgroundColor.r, backgroundColor.g, backgroundColor.b, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear both color buffers and depth (z-indexes) buffers to push a clean buffer when done
+
+	// It looks like it's better to call these each frame
+	glEnable(GL_DEPTH_TEST);// Enable depth test (check if z is closer to the screen than last fragement's z)
+	glDepthFunc(GL_LESS); // Accept the fragment closer to the camera
+
+	// Cull triangles which normal is not towards the camera
+	// If there are holes in the model because of this, click the "invert normals" button in your 3D modeler.
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+	glPolygonMode(GRAPHICS_RASTERIZE_FACE, GRAPHICS_RASTERIZE_MODE);
+
+	queue.clear();
+
+	for(std::size_t i = 0; i < objects.size(); i++)
+	{
+		const ObjectSnapshot& object = objects[i];
+
+		float depth = -(viewMatrix * object.modelMatrix[3]).z; // Distance in front of the camera
+		GLuint texture = object.texture ? object.texture->getID() : 0;
+
+		queue.add(RenderQueue::makeKey(RENDER_PASS_OPAQUE, object.shader->getID(), texture,
+			object.objectGeometry->getSortID(object.arenaLocation.get()), depth), static_cast<unsigned int>(i));
+	}
+
+	queue.sort();
+	queue.begin();
+
+	uploadFrameUniforms(queue);
+
+	batchObjects(queue);
+	queue.uploadInstances();
+
+	const std::vector<RenderQueue::DrawItem>& items = queue.getItems();
+
+	for(const auto& batch : queue.getBatches())
+	{
+		const ObjectSnapshot& firstObject = objects[items[batch.firstItem].index];
+
+		if(batch.firstInstance >= 0)
+		{
+			firstObject.renderInstances(firstObject, *this, queue, batch.firstInstance, batch.itemCount);
+		} else
+		{
+			for(int i = 1; i < batch.itemCount; i++) // Merged, drawn with the first one
+			{
+				const ObjectSnapshot& mergedObject = objects[items[batch.firstItem + i].index];
+				queue.addMergedGeometry(*mergedObject.objectGeometry, *mergedObject.arenaLocation);
+			}
+
+			firstObject.render(firstObject, *this, queue);
+		}
+	}
+
+	if(debugLineShader) // Before end(), the lines go in the queue's streaming buffer
+		queue.getDebugRenderer().render(debugLines, *debugLineShader, projectionMatrix * viewMatrix, queue.getStreamingBuffer());
+
+	if(!captureFile.empty()) // Warns if there is no render target
+		renderTarget.saveBMP(captureFile);
+
+	if(useRenderTarget && !offscreen)
+		renderTarget.blit(viewportSize);
+
+	queue.getGPUTimer().end(); // Before end(), so the stats have the newest time
+	queue.end();
+}
\ No newline at end of file
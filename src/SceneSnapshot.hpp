@@ -0,0 +1,111 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Everything needed to draw one frame, copied out of the entities.
+// Once it is built, nothing in here points back to entities, so it can be rendered on another thread
+// while the game steps. Resources are shared pointers, so they stay alive until the frame is drawn.
+//
+// The scene is drawn in the queue's RenderTarget at renderSize, then blitted to the window (see DynamicResolution).
+
+#ifndef SCENE_SNAPSHOT_HPP
+#define SCENE_SNAPSHOT_HPP
+
+#include <ObjectGeometry.hpp>
+#include <Shader.hpp>
+#include <Texture.hpp>
+#include <RenderQueue.hpp>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory> // For smart pointers
+#include <string>
+#include <vector>
+
+struct SceneSnapshot;
+
+struct ObjectSnapshot
+{
+	// Static functions only, since the object might not exist anymore when this is called
+	// Bind and draw through the queue, it skips what is already bound
+	using renderFunction = void (*)(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue);
+
+	// Draws instanceCount objects like this one at once, their matrices are in the queue's instance buffer.
+	// Null if this kind of object can't be instanced.
+	using renderInstancesFunction = void (*)(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue,
+		int firstInstance, int instanceCount);
+
+	renderFunction render;
+	renderInstancesFunction renderInstances;
+
+	std::shared_ptr<const ObjectGeometry> objectGeometry;
+	// Where the geometry is in the GeometryArena, null if it isn't. Read when snapshotting, so the frame never uses
+	// a place compacting copied it to after its resource fence (the copies might not be done).
+	std::shared_ptr<const GeometryArena::Location> arenaLocation;
+	std::shared_ptr<const Shader> shader;
+	std::shared_ptr<const Texture> texture; // Null if the object isn't textured
+
+	// Computed for all objects at once, see TransformBatch
+	glm::mat4 modelMatrix;
+	glm::mat4 mvpMatrix; // Projection * view * model
+	glm::mat3 normalMatrix; // Inverse transpose of the model matrix, model space
+};
+
+// See EntityManager::snapshotLights()
+struct LightSnapshot
+{
+	glm::vec3 position; // World space
+	glm::vec3 diffuseColor;
+	glm::vec3 specularColor;
+	float power;
+};
+
+struct SceneSnapshot
+{
+	glm::mat4 viewMatrix;
+	glm::mat4 projectionMatrix;
+
+	glm::ivec2 viewportSize; // Of the window
+	glm::ivec2 renderSize; // Of the RenderTarget the scene is drawn in, scaled to the window after. 0 to draw straight in the window.
+	bool offscreen; // Only draw in the render target, nothing goes to the window
+	std::string captureFile; // Where to save this frame, empty for most frames
+	glm::vec3 backgroundColor;
+
+	std::vector<ObjectSnapshot> objects;
+	std::vector<LightSnapshot> lights; // At most LIGHT_MAX_COUNT
+	// Physics debug shapes, drawn after the objects in one draw (see DebugRenderer)
+	std::vector<glm::vec3> debugLines; // World space, two points per line
+	std::shared_ptr<const Shader> debugLineShader; // Null if there is nothing to draw
+
+	// Resources created on another context (another thread) are only safe to use once this fence is done.
+	// Null if there is nothing to wait for.
+	GLsync resourceFence;
+
+	SceneSnapshot();
+
+	void clear();
+	static bool canInstanceTogether(const ObjectSnapshot& first, const ObjectSnapshot& second);
+	static bool canMergeTogether(const ObjectSnapshot& first, const ObjectSnapshot& second);
+	void batchObjects(RenderQueue& queue) const;
+	void uploadFrameUniforms(RenderQueue& queue) const;
+
+	void render(RenderQueue& queue) const; // The queue is only there to reuse its memory
+};
+
+#endif /* SCENE_SNAPSHOT_HPP */
\ No newline at end of file
@@ -129,6 +129,8 @@ bool Script::setLuaRequirePath(const std::string& absolutePath)
 #include <Shader.hpp>
 #include <Texture.hpp>
 #include <ObjectGeometryGroup.hpp>
+#include <MeshOptimizer.hpp>
+#include <GeometryArena.hpp>
 #include <ObjectGeometry.hpp>
 #include <Sound.hpp>
 #include <GPUBuffer.hpp>
@@ -139,6 +141,11 @@ bool Script::setLuaRequirePath(const std::string& absolutePath)
 #include <TexturedObject.hpp>
 #include <ShadedObject.hpp>
 #include <PhysicsBody.hpp>
+#include <Profiler.hpp>
+#include <JobSystem.hpp>
+#include <FramePacer.hpp>
+#include <DynamicResolution.hpp>
+#include <RenderQueue.hpp>
 
 #include <Utils.hpp>
 
@@ -178,10 +185,23 @@ void Script::bindInterface(Game& game)
 		.addFunction("getSize", &Game::getSize)
 
 		.addFunction("setMaxFramesPerSecond", &Game::setMaxFramesPerSecond)
+		.addFunction("isVSyncOn", &Game::isVSyncOn)
+		.addFunction("getFramePacer", &Game::getFramePacer)
+		.addFunction("setStepsPerSecond", &Game::setStepsPerSecond)
+		.addFunction("getStepsPerSecond", &Game::getStepsPerSecond)
+		.addFunction("setMaxStepsPerFrame", &Game::setMaxStepsPerFrame)
 		.addFunction("setMainWindowPosition", &Game::setMainWindowPosition)
 		.addFunction("getMainWindowPosition", &Game::getMainWindowPosition)
 		.addFunction("reCenterMainWindow", &Game::reCenterMainWindow)
 
+		.addFunction("isHeadless", &Game::isHeadless)
+		.addFunction("setMaxSteps", &Game::setMaxSteps)
+		.addFunction("getStepCount", &Game::getStepCount)
+		.addFunction("isReplayingInput", &Game::isReplayingInput)
+		.addFunction("isOffscreen", &Game::isOffscreen)
+		.addFunction("setCapture", &Game::setCapture)
+		.addFunction("getDynamicResolution", &Game::getDynamicResolution)
+
 		.addFunction("setGraphicsBackgroundColor", &Game::setGraphicsBackgroundColor)
 		.addFunction("getGraphicsBackgroundColor", &Game::getGraphicsBackgroundColor)
 
@@ -191,12 +211,106 @@ void Script::bindInterface(Game& game)
 	.endClass();
 
 
+	LuaBinding(luaState).beginClass<FramePacer>("FramePacer") // Times are in miliseconds
+		.addFunction("getFrameCount", &FramePacer::getFrameCount)
+		.addFunction("getAverageFrameTime", &FramePacer::getAverageFrameTime)
+		.addFunction("getFrameTimeJitter", &FramePacer::getFrameTimeJitter)
+		.addFunction("getFrameTimePercentile", &FramePacer::getFrameTimePercentile)
+		.addFunction("clearHistogram", &FramePacer::clearHistogram)
+		.addFunction("logHistogram", &FramePacer::logHistogram)
+	.endClass();
+
+	LuaBinding(luaState).beginClass<DynamicResolution>("DynamicResolution")
+		.addFunction("setEnabled", &DynamicResolution::setEnabled)
+		.addFunction("isEnabled", &DynamicResolution::isEnabled)
+		.addFunction("setTargetFramesPerSecond", &DynamicResolution::setTargetFramesPerSecond)
+		.addFunction("getTargetFramesPerSecond", &DynamicResolution::getTargetFramesPerSecond)
+		.addFunction("setScaleRange", &DynamicResolution::setScaleRange)
+		.addFunction("getMinScale", &DynamicResolution::getMinScale)
+		.addFunction("getMaxScale", &DynamicResolution::getMaxScale)
+		.addFunction("getScale", &DynamicResolution::getScale)
+		.addFunction("getAverageGPUTime", &DynamicResolution::getAverageGPUTime) // In miliseconds
+	.endClass();
+
+
+	LuaBinding(luaState).beginClass<RenderStats>("RenderStats")
+		.addVariable("drawCalls", &RenderStats::drawCalls, false) // Read-only
+		.addVariable("shaderChanges", &RenderStats::shaderChanges, false)
+		.addVariable("textureChanges", &RenderStats::textureChanges, false)
+		.addVariable("geometryChanges", &RenderStats::geometryChanges, false)
+		.addVariable("stateChanges", &RenderStats::stateChanges, false)
+		.addVariable("instancedObjects", &RenderStats::instancedObjects, false)
+		.addVariable("mergedObjects", &RenderStats::mergedObjects, false)
+		.addVariable("gpuFrameTime", &RenderStats::gpuFrameTime, false) // In miliseconds
+	.endClass();
+
+	// Stats of the last frame drawn, it might be drawn on another thread
+	LuaBinding(luaState).beginModule("RenderQueue")
+		.addFunction("getLastFrameStats", &RenderQueue::getLastFrameStats)
+	.endModule();
+
+
 	LuaBinding(luaState).beginModule("Engine")
 		.addConstant("Name", ENGINE_NAME)
 		.addConstant("Version", ENGINE_VERSION)
 	.endModule();
 
 
+	LuaBinding(luaState).beginModule("MeshOptimizer")
+		.addFunction("setEnabledOnLoad", &MeshOptimizer::setEnabledOnLoad)
+		.addFunction("isEnabledOnLoad", &MeshOptimizer::isEnabledOnLoad)
+		.addFunction("setLODsOnLoad", &MeshOptimizer::setLODsOnLoad)
+		.addFunction("areLODsOnLoad", &MeshOptimizer::areLODsOnLoad)
+	.endModule();
+
+
+	// For the last argument of the ObjectGeometry constructor
+	LuaBinding(luaState).beginClass<GeometryArena::Stats>("GeometryArenaStats")
+		.addVariable("pageCount", &GeometryArena::Stats::pageCount, false) // Read-only
+		.addVariable("geometryCount", &GeometryArena::Stats::geometryCount, false)
+		.addVariable("capacity", &GeometryArena::Stats::capacity, false)
+		.addVariable("usedSize", &GeometryArena::Stats::usedSize, false)
+		.addVariable("freeBlockCount", &GeometryArena::Stats::freeBlockCount, false)
+		.addVariable("largestFreeBlock", &GeometryArena::Stats::largestFreeBlock, false)
+		.addVariable("fragmentation", &GeometryArena::Stats::fragmentation, false)
+	.endClass();
+
+	LuaBinding(luaState).beginModule("GeometryArena")
+		.addFunction("setEnabled", &GeometryArena::setEnabled)
+		.addFunction("isEnabled", &GeometryArena::isEnabled)
+		.addFunction("getStats", &GeometryArena::getStats)
+		.addFunction("compact", &GeometryArena::compact)
+	.endModule();
+
+	LuaBinding(luaState).beginModule("VertexFormat")
+		.addConstant("Separate", VERTEX_FORMAT_SEPARATE)
+		.addConstant("Packed", VERTEX_FORMAT_PACKED)
+	.endModule();
+
+
+	LuaBinding(luaState).beginClass<Profiler::ZoneStats>("ProfilerZoneStats") // Times are in miliseconds
+		.addVariable("min", &Profiler::ZoneStats::min, false) // Read-only
+		.addVariable("average", &Profiler::ZoneStats::average, false)
+		.addVariable("p99", &Profiler::ZoneStats::p99, false)
+		.addVariable("count", &Profiler::ZoneStats::count, false)
+	.endClass();
+
+	LuaBinding(luaState).beginModule("Profiler")
+		.addFunction("setEnabled", &Profiler::setEnabled)
+		.addFunction("isEnabled", &Profiler::isEnabled)
+		.addFunction("clear", &Profiler::clear)
+		.addFunction("exportChromeTrace", &Profiler::exportChromeTrace)
+		.addFunction("getZoneStats", &Profiler::getZoneStats)
+	.endModule();
+
+
+	// Lua itself can't run on other threads, but the batch functions (ResourceManager:addTextures() etc) use all workers
+	LuaBinding(luaState).beginModule("JobSystem")
+		.addFunction("getWorkerCount", &JobSystem::getWorkerCount)
+		.addFunction("getDefaultWorkerCount", &JobSystem::getDefaultWorkerCount)
+	.endModule();
+
+
 	LuaBinding(luaState).beginClass<ResourceManager>("ResourceManager")
 		.addFunction("addShader",
 			// Specify which overload we want. Lua doesn't support functions with same names, though.
@@ -219,6 +333,8 @@ void Script::bindInterface(Game& game)
 			static_cast<ResourceManager::texturePointer(ResourceManager::*) (const std::string&, const std::string&, int)>
 				(&ResourceManager::addTexture))
 
+		.addFunction("addTextures", &ResourceManager::addTextures) // Table of files, decoded in parallel
+
 		.addFunction("findTexture", &ResourceManager::findTexture)
 		.addFunction("clearTextures", &ResourceManager::clearTextures)
 
@@ -234,6 +350,8 @@ void Script::bindInterface(Game& game)
 			static_cast<ResourceManager::objectGeometryGroup_pointer(ResourceManager::*) (ResourceManager::objectGeometryGroup_pointer)>
 			(&ResourceManager::addObjectGeometryGroup))
 
+		.addFunction("addObjectGeometryGroups", &ResourceManager::addObjectGeometryGroups) // Table of files, parsed in parallel
+
 		.addFunction("findObjectGeometryGroup", &ResourceManager::findObjectGeometryGroup)
 		.addFunction("clearObjectGeometryGroups", &ResourceManager::clearObjectGeometryGroups)
 
@@ -287,9 +405,11 @@ void Script::bindInterface(Game& game)
 			const ObjectGeometry::uintVector&,
 			const ObjectGeometry::vec3Vector&,
 			const ObjectGeometry::vec2Vector&,
-			const ObjectGeometry::vec3Vector&))
+			const ObjectGeometry::vec3Vector&,
+			_def<int, VERTEX_FORMAT_PACKED>)) // Optional vertex format
 
 		.addFunction("getName", &ObjectGeometry::getName)
+		.addFunction("getVertexFormat", &ObjectGeometry::getVertexFormat)
 		.addFunction("getIndexBuffer",
 			// To get the non-const version
 			static_cast<ObjectGeometry::uintBuffer&(ObjectGeometry::*) ()> (&ObjectGeometry::getIndexBuffer))
@@ -486,6 +606,13 @@ void Script::bindInterface(Game& game)
 
 	LuaBinding(luaState).beginClass<EntityManager>("EntityManager")
 		.addFunction("getGameCamera", &EntityManager::getGameCamera)
+		.addFunction("setDebugShapesVisible", &EntityManager::setDebugShapesVisible)
+		.addFunction("areDebugShapesVisible", &EntityManager::areDebugShapesVisible)
+		.addFunction("setDebugShapeShader", &EntityManager::setDebugShapeShader)
+		.addFunction("setFrustumCulling", &EntityManager::setFrustumCulling)
+		.addFunction("isFrustumCulling", &EntityManager::isFrustumCulling)
+		.addFunction("getVisibleObjectCount", &EntityManager::getVisibleObjectCount)
+		.addFunction("getCulledObjectCount", &EntityManager::getCulledObjectCount)
 		.addFunction("addObject", &EntityManager::addObject)
 
 		.addFunction("removeObjectByIndex",
@@ -590,6 +717,8 @@ void Script::bindInterface(Game& game)
 		.addFunction("getNearClippingDistance", &Camera::getNearClippingDistance)
 		.addFunction("setFarClippingDistance", &Camera::setFarClippingDistance)
 		.addFunction("getFarClippingDistance", &Camera::getFarClippingDistance)
+		.addFunction("setLODBias", &Camera::setLODBias)
+		.addFunction("getLODBias", &Camera::getLODBias)
 	.endClass();
 
 
@@ -649,6 +778,15 @@ void Script::bindInterface(Game& game)
 		{
 			Utils::directly_crash(msg);
 		})
+
+		.addFunction("setLogLevel", &Utils::setLogLevel)
+		.addFunction("getLogLevel", &Utils::getLogLevel)
+	.endModule();
+
+	LuaBinding(luaState).beginModule("LogLevel")
+		.addConstant("Debug", LOG_LEVEL_DEBUG)
+		.addConstant("Info", LOG_LEVEL_INFO)
+		.addConstant("Warning", LOG_LEVEL_WARNING)
 	.endModule();
 	
 	// Basic glm bindings
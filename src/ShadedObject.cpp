@@ -28,11 +28,13 @@
 // Uniforms:
 // - mat4 MVP (precalculated)
 // - mat4 modelMatrix
-// - mat4 viewMatrix
-// - mat4 projectionMatrix
-// - mat4 normalMatrix
+// - mat3 normalMatrix (model space)
 // - sampler2D textureSampler
 
+// Uniform blocks (see RenderQueue::uploadFrameUniforms()):
+// - Camera
+// - Lights
+
 ShadedObject::ShadedObject(constObjectGeometryPointer objectGeometry,
 						   constShaderPointer shaderPointer, constTexturePointer texturePointer,
 						   bool physicsCircularShape, int physicsType)
@@ -46,83 +48,46 @@ ShadedObject::~ShadedObject()
 	// Do nothing
 }
 
-void ShadedObject::render(const Camera& camera)
+void ShadedObject::snapshot(ObjectSnapshot& snapshot, float interpolation) const
 {
-	const ObjectGeometry::uintBuffer& indexBuffer = getObjectGeometry()->getIndexBuffer();
-	const ObjectGeometry::vec3Buffer& positionBuffer = getObjectGeometry()->getPositionBuffer();
-	const ObjectGeometry::vec2Buffer& UVBuffer = getObjectGeometry()->getUVBuffer();
-	const ObjectGeometry::vec3Buffer& normalBuffer = getObjectGeometry()->getNormalBuffer();
-
-	glm::mat4 modelMatrix = getPhysicsBody().generateModelMatrix();
-	glm::mat4 viewMatrix = camera.getViewMatrix();
-	glm::mat4 projectionMatrix = camera.getProjectionMatrix();
-
-	glm::mat4 MVP = projectionMatrix * viewMatrix * modelMatrix;
-	glm::mat4 modelViewMatrix = viewMatrix * modelMatrix;
-	glm::mat4 normalMatrix = glm::transpose(glm::inverse(modelViewMatrix));
-
-	glUseProgram(getShader()->getID());
-
-	glUniformMatrix4fv(getShader()->findUniform("MVP"), 1, GL_FALSE, &MVP[0][0]);
-	glUniformMatrix4fv(getShader()->findUniform("modelMatrix"), 1, GL_FALSE, &modelMatrix[0][0]);
-	glUniformMatrix4fv(getShader()->findUniform("viewMatrix"), 1, GL_FALSE, &viewMatrix[0][0]);
-	//glUniformMatrix4fv(getShader()->findUniform("projectionMatrix"), 1, GL_FALSE, &projectionMatrix[0][0]);
-	glUniformMatrix4fv(getShader()->findUniform("normalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
-
-	glUniform1i(getShader()->findUniform("textureSampler"), 0); // The first texture, not necessary for now
-
-	// Attribute 0, position buffer
-	glEnableVertexAttribArray(0);
-	positionBuffer.bind(GL_ARRAY_BUFFER);
-	glVertexAttribPointer(
-		0,					// Attribute 0, no particular reason but same as the vertex shader's layout and glEnableVertexAttribArray
-		3,					// Size. Number of values per vertex, must be 1, 2, 3 or 4.
-		GL_FLOAT,			// Type of data (GLfloats)
-		GL_FALSE,			// Normalized?
-		0,					// Stride
-		(void*)0			// Array buffer offset
-	);
-
-	// Attribute 1, UV buffer
-	glEnableVertexAttribArray(1);
-	UVBuffer.bind(GL_ARRAY_BUFFER);
-
-	glVertexAttribPointer(
-		1,                // Attribute
-		2,                // Size (values per vertex)
-		GL_FLOAT,         // Type
-		GL_FALSE,         // Normalize?
-		0,                // Stride
-		(void*)0          // Array buffer offset
-	);
-
-	// Attribute 2, normal buffer
-	glEnableVertexAttribArray(2);
-	normalBuffer.bind(GL_ARRAY_BUFFER);
-	glVertexAttribPointer(
-		2,                // Attribute
-		3,                // Size (values per vertex)
-		GL_FLOAT,         // Type
-		GL_FALSE,         // Normalize?
-		0,                // Stride
-		(void*)0          // Array buffer offset
-	);
-
-	// Texture
-	glActiveTexture(GL_TEXTURE0); // Set the active texture unit, you can have more than 1 texture at once
-	glBindTexture(GL_TEXTURE_2D, getTexture()->getID());
+	TexturedObject::snapshot(snapshot, interpolation);
+
+	snapshot.render = &ShadedObject::renderSnapshot;
+	snapshot.renderInstances = &ShadedObject::renderInstancedSnapshot;
+}
+
+// Static
+void ShadedObject::renderSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue)
+{
+	const Shader& shader = *object.shader;
+
+	// The camera and lights are in uniform blocks, set once per frame
+	queue.useShader(shader);
+	shader.setUniform(SHADER_UNIFORM_TEXTURE_SAMPLER, 0); // The first texture, only sent once
+	shader.setUniform(SHADER_UNIFORM_MVP, object.mvpMatrix);
+	shader.setUniform(SHADER_UNIFORM_MODEL_MATRIX, object.modelMatrix);
+	shader.setUniform(SHADER_UNIFORM_NORMAL_MATRIX, object.normalMatrix);
+
+	queue.bindGeometry(*object.objectGeometry, object.arenaLocation, VERTEX_LAYOUT_SHADED);
+	queue.bindTexture(object.texture->getID());
 
 	// Draw!
 	// Use the index buffer, more efficient!
-	glDrawElements(
-		GL_TRIANGLES,            // Mode
-		indexBuffer.getLength(), // Count
-		GL_UNSIGNED_INT,         // Type
-		(void*)0                 // Element array buffer offset
-	);
-
-	// Disable vertex attrib arrays
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
+	queue.drawElements();
+}
+
+// Static
+// The normal matrices come with the instances, they don't depend on the camera (see shadedInstanced.v.glsl)
+void ShadedObject::renderInstancedSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue,
+	int firstInstance, int instanceCount)
+{
+	const Shader& shader = *object.shader->getInstancedVariant();
+
+	queue.useShader(shader);
+	shader.setUniform(SHADER_UNIFORM_TEXTURE_SAMPLER, 0);
+
+	queue.bindGeometry(*object.objectGeometry, object.arenaLocation, VERTEX_LAYOUT_SHADED, true);
+	queue.bindTexture(object.texture->getID());
+
+	queue.drawElementsInstanced(firstInstance, instanceCount);
 }
\ No newline at end of file
@@ -34,7 +34,11 @@ public:
 		bool physicsCircularShape, int physicsType);
 	~ShadedObject() override;
 
-	void render(const Camera& camera) override;
+	void snapshot(ObjectSnapshot& snapshot, float interpolation) const override;
+
+	static void renderSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue);
+	static void renderInstancedSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue,
+		int firstInstance, int instanceCount);
 };
 
 #endif /* SHADED_OBJECT_HPP */
\ No newline at end of file
@@ -19,7 +19,9 @@
 
 #include <Shader.hpp>
 #include <Utils.hpp>
+#include <Definitions.hpp>
 
+#include <cstring> // For memcmp() and memcpy()
 #include <limits> // For numeric_limits
 
 // Takes the shader paths for better error logs
@@ -28,6 +30,17 @@ Shader::Shader(const std::string& name,
 			   const std::string& fragmentShaderPath)
 {
 	mName = name;
+	mID = 0;
+
+	for(int i = 0; i < SHADER_UNIFORM_COUNT; i++)
+	{
+		mUniformSlots[i] = -1;
+		mUniformCached[i] = false;
+	}
+
+	// No OpenGL context to compile for in headless mode, but keep the shader around so scripts can still find it
+	if(Utils::isHeadless())
+		return;
 
 	std::string vertexShaderCode = Utils::getFileContents(vertexShaderPath);
 	std::string fragmentShaderCode = Utils::getFileContents(fragmentShaderPath);
@@ -41,11 +54,14 @@ Shader::Shader(const std::string& name,
 		mID = 0; // Make sure it doesn't blow up. Error messages should have already been sent.
 
 	registerUniforms(); // Will find all uniforms in the shader and register them
+	bindUniformBlocks();
+	resolveUniformSlots();
 }
 
 Shader::~Shader()
 {
-	glDeleteShader(mID); // Free memory
+	if(mID != 0)
+		glDeleteShader(mID); // Free memory
 }
 
 // PRIVATE
@@ -140,6 +156,13 @@ void Shader::registerUniforms()
 
 	for(int i=0; i < numberOfUniforms; i++)
 	{
+		GLuint uniformIndex = static_cast<GLuint>(i);
+		GLint blockIndex;
+		glGetActiveUniformsiv(mID, 1, &uniformIndex, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+
+		if(blockIndex != -1) // In a uniform block, it has no location. See bindUniformBlocks().
+			continue;
+
 		glGetActiveUniformName(mID, i, bufferSize, &numberOfCharsReceived, uniformNameBuffer);
 
 		// Buffer is converted to an std::string using the null terminator placed by gl
@@ -173,6 +196,60 @@ GLuint Shader::registerUniform(const std::string& uniformName) // Uniform name i
 	return uniformLocation; // Return the newly added uniform location
 }
 
+// Points the shared blocks to their buffers, see RenderQueue::uploadFrameUniforms()
+// GLSL 330 can't choose the binding point itself. Shaders don't have to use the blocks.
+void Shader::bindUniformBlocks()
+{
+	GLuint cameraBlock = glGetUniformBlockIndex(mID, UNIFORM_BLOCK_CAMERA_NAME);
+	GLuint lightsBlock = glGetUniformBlockIndex(mID, UNIFORM_BLOCK_LIGHTS_NAME);
+
+	if(cameraBlock != GL_INVALID_INDEX)
+		glUniformBlockBinding(mID, cameraBlock, UNIFORM_BLOCK_CAMERA_BINDING);
+
+	if(lightsBlock != GL_INVALID_INDEX)
+		glUniformBlockBinding(mID, lightsBlock, UNIFORM_BLOCK_LIGHTS_BINDING);
+}
+
+// So drawing never has to look names up. Missing ones are told about here, once, instead of each draw:
+// drawing happens on the render thread, where crashing would pull everything down under the game's feet.
+void Shader::resolveUniformSlots()
+{
+	const char* slotNames[SHADER_UNIFORM_COUNT];
+	slotNames[SHADER_UNIFORM_MVP] = "MVP";
+	slotNames[SHADER_UNIFORM_MODEL_MATRIX] = "modelMatrix";
+	slotNames[SHADER_UNIFORM_NORMAL_MATRIX] = "normalMatrix";
+	slotNames[SHADER_UNIFORM_TEXTURE_SAMPLER] = "textureSampler";
+	slotNames[SHADER_UNIFORM_COLOR] = "color";
+
+	for(int i = 0; i < SHADER_UNIFORM_COUNT; i++)
+	{
+		GLuintMap::const_iterator got = mUniformMap.find(slotNames[i]);
+		mUniformSlots[i] = (got != mUniformMap.end()) ? static_cast<GLint>(got->second) : -1;
+
+		// Most shaders only use some of them (basic shaders have no normal matrix), so it's only a debug message
+		if(mUniformSlots[i] == -1 && mID != 0)
+			Utils::LOGPRINT_DEBUG("Shader '" + mName + "' has no uniform '" + slotNames[i] + "', objects setting it will draw without it.");
+	}
+}
+
+// -1 if the shader doesn't have it, setUniform() then skips it
+GLint Shader::getUniformSlotLocation(int slot) const
+{
+	return mUniformSlots[slot];
+}
+
+// Returns false if the uniform already has these values, true if they are new and have to be sent
+bool Shader::updateUniformCache(int slot, const float* values, std::size_t count) const
+{
+	if(mUniformCached[slot] && std::memcmp(mUniformCache[slot], values, count * sizeof(float)) == 0)
+		return false;
+
+	std::memcpy(mUniformCache[slot], values, count * sizeof(float));
+	mUniformCached[slot] = true;
+
+	return true;
+}
+
 // PUBLIC
 
 std::string Shader::getName() const
@@ -214,3 +291,47 @@ GLuint Shader::findUniform(const std::string& uniformName) const // Returns a re
 
 	return got->second;
 }
+
+
+void Shader::setInstancedVariant(std::shared_ptr<const Shader> instancedVariant)
+{
+	mInstancedVariant = instancedVariant;
+}
+
+std::shared_ptr<const Shader> Shader::getInstancedVariant() const
+{
+	return mInstancedVariant;
+}
+
+void Shader::setUniform(int slot, const glm::mat4& value) const
+{
+	GLint location = getUniformSlotLocation(slot);
+
+	if(location != -1 && updateUniformCache(slot, &value[0][0], 16))
+		glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
+void Shader::setUniform(int slot, const glm::mat3& value) const
+{
+	GLint location = getUniformSlotLocation(slot);
+
+	if(location != -1 && updateUniformCache(slot, &value[0][0], 9))
+		glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
+void Shader::setUniform(int slot, const glm::vec3& value) const
+{
+	GLint location = getUniformSlotLocation(slot);
+
+	if(location != -1 && updateUniformCache(slot, &value[0], 3))
+		glUniform3f(location, value.x, value.y, value.z);
+}
+
+void Shader::setUniform(int slot, GLint value) const
+{
+	GLint location = getUniformSlotLocation(slot);
+	float cachedValue = static_cast<float>(value); // Exact for texture units and such
+
+	if(location != -1 && updateUniformCache(slot, &cachedValue, 1))
+		glUniform1i(location, value);
+}
\ No newline at end of file
@@ -22,8 +22,12 @@
 
 #include <map>
 #include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory> // For smart pointers
 #include <string>
 
+#include <Definitions.hpp>
+
 class Shader
 {
 private:
@@ -35,12 +39,28 @@ private:
 	GLuint mID; // the ID of the shader, give this to OpenGL stuff. Could be const, but I left it non-const to make things easier.
 	GLuintMap mUniformMap; // Uniform variables, uniforms[uniformName] = uniform location
 
+	// Locations of the SHADER_UNIFORM_* uniforms, -1 if the shader doesn't have them
+	GLint mUniformSlots[SHADER_UNIFORM_COUNT];
+
+	// Last values set through setUniform(), the same value is never sent twice.
+	// Uniforms stay with the program, so this is right even after other shaders were used.
+	// Only touched by the thread that draws.
+	mutable float mUniformCache[SHADER_UNIFORM_COUNT][16];
+	mutable bool mUniformCached[SHADER_UNIFORM_COUNT];
+
+	std::shared_ptr<const Shader> mInstancedVariant; // Same shader, but reads the model matrix from instance attributes. Can be null.
+
 	// Static because they donnot need an instance to work
 	static GLuint compileShader(const std::string& shaderPath, const std::string& shaderCode, GLenum type);
 	static GLuint linkShaderProgram(const std::string& shaderProgramName, GLuint vertexShader, GLuint fragmentShader);
 
 	void registerUniforms();
 	GLuint registerUniform(const std::string& uniformName);
+	void bindUniformBlocks();
+	void resolveUniformSlots();
+
+	GLint getUniformSlotLocation(int slot) const;
+	bool updateUniformCache(int slot, const float* values, std::size_t count) const;
 
 public:
 	Shader(const std::string& name, const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
@@ -52,6 +72,16 @@ public:
 	static std::string getGLShaderDebugLog(GLuint object, PFNGLGETSHADERIVPROC glGet_iv, PFNGLGETSHADERINFOLOGPROC glGet__InfoLog);
 
 	GLuint findUniform(const std::string& uniformName) const;
+
+	// Slot is SHADER_UNIFORM_*, call with the shader in use (see RenderQueue::useShader())
+	void setUniform(int slot, const glm::mat4& value) const;
+	void setUniform(int slot, const glm::mat3& value) const;
+	void setUniform(int slot, const glm::vec3& value) const;
+	void setUniform(int slot, GLint value) const;
+
+	// See RenderQueue::drawElementsInstanced(). Set it when loading, it is read while rendering (maybe on another thread).
+	void setInstancedVariant(std::shared_ptr<const Shader> instancedVariant);
+	std::shared_ptr<const Shader> getInstancedVariant() const;
 };
 
 #endif /* SHADER_HPP */
\ No newline at end of file
@@ -23,8 +23,7 @@
 
 SimpleTimer::SimpleTimer()
 {
-	mStartTicks = 0;
-	mEndTicks = 0;
+	mStartNanoseconds = 0;
 }
 
 SimpleTimer::~SimpleTimer()
@@ -32,13 +31,32 @@ SimpleTimer::~SimpleTimer()
 	// Do nothing
 }
 
-int SimpleTimer::start() // Can be called multiple times (resets timer)
+// Static
+// Current time of SDL's performance counter, in nanoseconds. Only useful to compare with another time!
+Uint64 SimpleTimer::getCurrentNanoseconds()
 {
-	mStartTicks = SDL_GetTicks(); // SDL_GetTicks() returns the number of miliseconds since SDL started
-	return mStartTicks;
+	Uint64 counter = SDL_GetPerformanceCounter();
+	Uint64 frequency = SDL_GetPerformanceFrequency(); // Counts per second
+
+	// Split in seconds and the rest, otherwise counter * 1000000000 overflows after a few hours
+	Uint64 seconds = counter / frequency;
+	Uint64 remainder = counter % frequency;
+
+	return (seconds * 1000000000) + ((remainder * 1000000000) / frequency);
+}
+
+int SimpleTimer::start() // Can be called multiple times (resets timer). Returns the start time in miliseconds.
+{
+	mStartNanoseconds = getCurrentNanoseconds();
+	return static_cast<int>(mStartNanoseconds / 1000000);
+}
+
+int SimpleTimer::getTicks() // In miliseconds
+{
+	return static_cast<int>(getNanoseconds() / 1000000);
 }
 
-int SimpleTimer::getTicks()
+Uint64 SimpleTimer::getNanoseconds()
 {
-	return SDL_GetTicks() - mStartTicks;
+	return getCurrentNanoseconds() - mStartNanoseconds;
 }
\ No newline at end of file
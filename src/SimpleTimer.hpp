@@ -20,11 +20,13 @@
 #ifndef SIMPLETIMER_HPP
 #define SIMPLETIMER_HPP
 
+#include <SDL.h> // For Uint64
+
+// Uses SDL's high resolution performance counter, so it is precise enough for frame timing
 class SimpleTimer
 {
 private:
-	int mStartTicks; // The time when the timer was started
-	int mEndTicks; // The time when the timer has stopped
+	Uint64 mStartNanoseconds; // The time when the timer was started
 
 public:
 	SimpleTimer();
@@ -32,6 +34,9 @@ public:
 
 	int start();
 	int getTicks();
+	Uint64 getNanoseconds();
+
+	static Uint64 getCurrentNanoseconds();
 };
 
 #endif /* SIMPLETIMER_HPP */
\ No newline at end of file
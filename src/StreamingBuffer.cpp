@@ -0,0 +1,210 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <StreamingBuffer.hpp>
+
+#include <Utils.hpp>
+#include <Profiler.hpp>
+
+#include <cstring> // For memcpy()
+#include <string>
+
+#define STREAMING_BUFFER_WAIT_TIMEOUT 1000000 // Nanoseconds, we wait again after that (glClientWaitSync() wants a timeout)
+
+StreamingBuffer::StreamingBuffer()
+{
+	mID = 0;
+	mIsPersistent = false;
+	mMappedData = nullptr;
+
+	mRegionSize = 0;
+	mRegion = 0;
+	mRegionUsed = 0;
+
+	for(int i = 0; i < STREAMING_BUFFER_FRAME_COUNT; i++)
+		mFences[i] = nullptr;
+
+	mWaitCount = 0;
+}
+
+// Also used to grow, in the middle of a frame
+void StreamingBuffer::create(std::size_t regionSize)
+{
+	if(mID != 0)
+		mOldBuffers.push_back(mID); // Might still be bound to something this frame
+
+	// The fences were for the old buffer, the GPU isn't using the new one yet
+	for(int i = 0; i < STREAMING_BUFFER_FRAME_COUNT; i++)
+	{
+		if(mFences[i])
+		{
+			glDeleteSync(mFences[i]);
+			mFences[i] = nullptr;
+		}
+	}
+
+	mRegionSize = regionSize;
+	mRegion = 0;
+	mRegionUsed = 0;
+	mMappedData = nullptr;
+
+	// Any target would do, this one doesn't change what is bound for drawing
+	glGenBuffers(1, &mID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mID);
+
+	mIsPersistent = GLAD_GL_ARB_buffer_storage && glBufferStorage;
+
+	if(mIsPersistent)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT; // Coherent, no need to flush what we write
+		std::size_t size = regionSize * STREAMING_BUFFER_FRAME_COUNT;
+
+		glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+		mMappedData = static_cast<char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+
+		if(!mMappedData)
+		{
+			Utils::WARN("Cannot map streaming buffer, it will be orphaned each frame instead!");
+
+			// Immutable storage can't be changed, start over
+			glDeleteBuffers(1, &mID);
+			glGenBuffers(1, &mID);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, mID);
+
+			mIsPersistent = false;
+		}
+	}
+
+	if(!mIsPersistent) // Only one region, orphaned each frame
+		glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+}
+
+// Blocks until the GPU is done with what the region had
+void StreamingBuffer::waitForRegion(int region)
+{
+	GLsync fence = mFences[region];
+
+	if(!fence)
+		return;
+
+	GLenum result = glClientWaitSync(fence, 0, 0); // Usually long done
+
+	if(result == GL_TIMEOUT_EXPIRED)
+	{
+		PROFILE_ZONE("StreamingBuffer::waitForRegion");
+		mWaitCount++;
+
+		do
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAMING_BUFFER_WAIT_TIMEOUT);
+		} while(result == GL_TIMEOUT_EXPIRED);
+	}
+
+	if(result == GL_WAIT_FAILED)
+		Utils::WARN("Waiting for a streaming buffer fence failed!");
+
+	glDeleteSync(fence);
+	mFences[region] = nullptr;
+}
+
+void StreamingBuffer::beginFrame()
+{
+	if(mID == 0) // We are on the drawing context now
+		create(STREAMING_BUFFER_DEFAULT_REGION_SIZE);
+
+	// Nothing uses them anymore, the driver deletes them once the GPU is done with them
+	if(!mOldBuffers.empty())
+	{
+		glDeleteBuffers(static_cast<GLsizei>(mOldBuffers.size()), mOldBuffers.data());
+		mOldBuffers.clear();
+	}
+
+	mRegionUsed = 0;
+
+	if(mIsPersistent)
+	{
+		waitForRegion(mRegion);
+	} else
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, mID);
+		glBufferData(GL_COPY_WRITE_BUFFER, mRegionSize, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+void StreamingBuffer::endFrame()
+{
+	if(!mIsPersistent || mID == 0)
+		return;
+
+	mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	mRegion = (mRegion + 1) % STREAMING_BUFFER_FRAME_COUNT;
+}
+
+std::size_t StreamingBuffer::write(const void* data, std::size_t size, std::size_t alignment)
+{
+	std::size_t offset = (mRegionUsed + alignment - 1) & ~(alignment - 1);
+
+	if(offset + size > mRegionSize)
+	{
+		// Stays a power of 2, so regions stay aligned
+		std::size_t regionSize = mRegionSize * 2;
+
+		while(regionSize < size + alignment)
+			regionSize *= 2;
+
+		Utils::LOGPRINT("Streaming buffer grown to " + std::to_string(regionSize) + " bytes per frame.");
+
+		create(regionSize);
+		offset = 0;
+	}
+
+	mRegionUsed = offset + size;
+
+	if(mIsPersistent)
+	{
+		offset += mRegion * mRegionSize;
+		std::memcpy(mMappedData + offset, data, size);
+	} else
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, mID);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data); // Orphaned, nothing to wait for
+	}
+
+	return offset;
+}
+
+GLuint StreamingBuffer::getID() const
+{
+	return mID;
+}
+
+bool StreamingBuffer::isPersistent() const
+{
+	return mIsPersistent;
+}
+
+std::size_t StreamingBuffer::getRegionSize() const
+{
+	return mRegionSize;
+}
+
+int StreamingBuffer::getWaitCount() const
+{
+	return mWaitCount;
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// A buffer for data that is written again every frame (instances, uniform blocks, debug lines...).
+// Storage is allocated once, and each frame hands out pieces of it with write(), one after the other.
+//
+// With ARB_buffer_storage (core in OpenGL 4.4), the buffer is split in STREAMING_BUFFER_FRAME_COUNT regions
+// and mapped once, for good (persistent mapping). Each frame writes straight into its own region, and a fence is
+// placed when it is done. A region is only written again once its fence says the GPU is done reading it,
+// which is a few frames later, so we almost never wait.
+// Without it, the buffer is orphaned at the start of each frame and written with glBufferSubData(), the driver
+// gives us new memory instead of waiting for the GPU.
+//
+// If a frame needs more than a region, a bigger buffer is made right away. The old one is kept until the next
+// frame, so what is already bound to it stays valid. This means getID() can change after write(), bind after writing!
+
+#ifndef STREAMING_BUFFER_HPP
+#define STREAMING_BUFFER_HPP
+
+#include <Definitions.hpp>
+
+#include <glad/glad.h>
+
+#include <cstddef> // For std::size_t
+#include <vector>
+
+class StreamingBuffer
+{
+private:
+	// Created on the drawing context, deleted with it
+	GLuint mID;
+	std::vector<GLuint> mOldBuffers; // Replaced this frame by a bigger buffer, deleted next frame
+
+	bool mIsPersistent;
+	char* mMappedData; // All regions, when persistent
+
+	std::size_t mRegionSize; // In bytes, what one frame can use
+	int mRegion; // Of the current frame
+	std::size_t mRegionUsed; // Bytes written this frame
+	GLsync mFences[STREAMING_BUFFER_FRAME_COUNT]; // Placed when the frame using the region is done, null if there is none
+
+	int mWaitCount; // Times we had to wait for the GPU
+
+	void create(std::size_t regionSize);
+	void waitForRegion(int region);
+
+public:
+	StreamingBuffer();
+
+	void beginFrame(); // Call on the drawing context before the first write() of a frame
+	void endFrame(); // After the last draw using the frame's data
+
+	// Copies the data in the frame's region. Returns its offset in the buffer, aligned to alignment (a power of 2).
+	std::size_t write(const void* data, std::size_t size, std::size_t alignment = STREAMING_BUFFER_DEFAULT_ALIGNMENT);
+
+	GLuint getID() const;
+	bool isPersistent() const;
+	std::size_t getRegionSize() const;
+	int getWaitCount() const;
+};
+
+#endif /* STREAMING_BUFFER_HPP */
\ No newline at end of file
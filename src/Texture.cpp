@@ -32,7 +32,17 @@ Texture::Texture(const std::string& name, const std::string& path, int type)
 	mPath = path;
 	mType = type;
 
-	load();
+	load(true);
+}
+
+// Only decodes the file, so this can be called on any thread. Call finishLoading() on the OpenGL thread before using it.
+Texture::Texture(const std::string& name, const std::string& path, int type, bool uploadLater)
+{
+	mName = name;
+	mPath = path;
+	mType = type;
+
+	load(!uploadLater);
 }
 
 // Heavy! Reloads the texture. (Maybe we should change this, but it's quite a lot of work depending on the method)
@@ -43,130 +53,193 @@ Texture::Texture(const Texture& other)
 	mPath = other.mPath;
 	mType = other.mType;
 
-	load();
+	load(true);
 }
 
 Texture::~Texture()
 {
-	glDeleteTextures(1, &mID); // Delete this texture. Might save memory.
+	if(mID != 0)
+		glDeleteTextures(1, &mID); // Delete this texture. Might save memory.
 }
 
-bool Texture::load()
+// Decodes the file, then gives it to OpenGL (unless we are headless or it is done later)
+bool Texture::load(bool uploadNow)
 {
+	mID = 0;
+	mWidth = 0;
+	mHeight = 0;
+	mMipmapCount = 0;
+	mFormat = 0;
+
+	bool decoded = false;
+
 	switch(mType)
 	{
 	case TEXTURE_BMP:
-		mID = loadBMPTexture(mPath);
-		return true;
+		decoded = decodeBMPTexture();
+		break;
 
 	case TEXTURE_DDS:
-		mID = loadDDSTexture(mPath);
-		return true;
+		decoded = decodeDDSTexture();
+		break;
 
 	default:
 		Utils::CRASH("Texture type specified for '" + mName + "' is invalid!");
 		return false;
 	}
+
+	if(!decoded)
+		return false;
+
+	if(uploadNow)
+		finishLoading();
+
+	return true;
+}
+
+// Gives the decoded texture to OpenGL, needs a GL context on the calling thread
+// Does nothing if it is already done
+void Texture::finishLoading()
+{
+	if(Utils::isHeadless() || mID != 0 || mData.empty())
+		return;
+
+	upload();
+
+	// OpenGL has its own copy now
+	mData.clear();
+	mData.shrink_to_fit();
+}
+
+// Gives the decoded data to OpenGL
+void Texture::upload()
+{
+	// Create one OpenGL texture
+	glGenTextures(1, &mID);
+
+	// "Bind" the new texture so that future functions will modify this
+	glBindTexture(GL_TEXTURE_2D, mID);
+
+	if(mType == TEXTURE_BMP)
+	{
+		// Give the image to OpenGL
+		// The second color format (GL_RGB or GL_BGR) can be changed to invert colors
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, mWidth, mHeight, 0, mFormat, GL_UNSIGNED_BYTE, mData.data());
+
+		// Filtering
+		// When we stretch (magnify) the image, use linear filtering
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// When we minify the image, use a linear blend of two mipmaps, each filtered linearly too
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glGenerateMipmap(GL_TEXTURE_2D); // Generate the mipmaps (a bunch of copies of the texture of different sizes) for optimization
+	} else // DDS
+	{
+		unsigned int width = mWidth;
+		unsigned int height = mHeight;
+
+		// Fill each mipmap one after another
+		unsigned int blockSize = (mFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
+		unsigned int offset = 0;
+
+		// Load the mipmaps
+		for(unsigned int level = 0; level < mMipmapCount && (width || height); ++level)
+		{
+			unsigned int size = ((width+3)/4) * ((height+3)/4) * blockSize;
+
+			if(offset + size > mData.size()) // Truncated file, don't read garbage
+				break;
+
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, mFormat, width, height, 0, size, mData.data() + offset);
+
+			offset += size;
+			width /= 2;
+			height /= 2;
+
+			// Deal with non-power-of-two textures
+			if(width < 1) width = 1;
+			if(height < 1) height = 1;
+		}
+	}
 }
 
-// Static
 // When loading a BMP texture, mipmaps are generated automatically. Consider compressing textures into DDS files and use the corresponding function for adding them.
-GLuint Texture::loadBMPTexture(const std::string& texturePath) // Adds a texture to the map
+bool Texture::decodeBMPTexture()
 {
 	// Not the best code for getting BMP data
 	const int headerSize = 54;
 	std::vector<char> header(headerSize);
 
 	unsigned int dataPos;
-	unsigned width, height;
 	unsigned int imageSize;
-	std::vector<char> pixelData; // The actual pixel data
 
-	std::ifstream file(texturePath, std::ios::binary);
+	std::ifstream file(mPath, std::ios::binary);
 
 	if(!file)
 	{
-		std::string error = "BMP image '" + texturePath + "' could not be opened!";
+		std::string error = "BMP image '" + mPath + "' could not be opened!";
 		Utils::CRASH(error);
-		return 0;
+		return false;
 	}
 
 	file.read(header.data(), headerSize); // Give the address of the first element, and read() makes a pointer to it (internally)
 
 	if(file.gcount() != 54) // If it's not 54 bytes, crash!
 	{
-		std::string error = "BMP image '" + texturePath + "' is not a correct BMP file! (Header is not 54 bytes)";
+		std::string error = "BMP image '" + mPath + "' is not a correct BMP file! (Header is not 54 bytes)";
 		Utils::CRASH(error);
 		file.close();
 
-		return 0;
+		return false;
 	}
 
 	if(header[0] != 'B' || header[1] != 'M') // Not BMP file?
 	{
-		std::string error = "BMP image '" + texturePath + "' is not a correct BMP file! (No 'BM' present in header)";
+		std::string error = "BMP image '" + mPath + "' is not a correct BMP file! (No 'BM' present in header)";
 		Utils::CRASH(error);
 		file.close();
 
-		return 0;
+		return false;
 	}
 
 	dataPos    = *(int*)&(header[0x0A]);
 	imageSize  = *(int*)&(header[0x22]);
-	width      = *(int*)&(header[0x12]);
-	height     = *(int*)&(header[0x16]);
+	mWidth     = *(int*)&(header[0x12]);
+	mHeight    = *(int*)&(header[0x16]);
 
 	// Some BMP files suck and miss some info, lets find those out if they are
-	if(imageSize==0)	imageSize = width*height*3; // 3: RGB I guess
+	if(imageSize==0)	imageSize = mWidth*mHeight*3; // 3: RGB I guess
 	if(dataPos==0)	    dataPos = 54; // The header is done this way
 
 	// Create a buffer
-	pixelData.resize(imageSize);
+	mData.resize(imageSize);
 
 	// Read the actual data
-	file.read(pixelData.data(), imageSize);
+	file.read(mData.data(), imageSize);
 
 	// Everything is in memory now, close the file
 	file.close();
 
-	// OpenGL
-	// Create one OpenGL texture
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-
-	// "Bind" the new texture so that future functions will modify this
-	glBindTexture(GL_TEXTURE_2D, textureID);
+	mFormat = GL_BGR;
+	mMipmapCount = 1; // The others are generated by OpenGL
 
-	// Give the image to OpenGL
-	// The second color format (GL_RGB or GL_BGR) can be changed to invert colors
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, pixelData.data());
-
-	// Filtering
-	// When we stretch (magnify) the image, use linear filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// When we minify the image, use a linear blend of two mipmaps, each filtered linearly too
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glGenerateMipmap(GL_TEXTURE_2D); // Generate the mipmaps (a bunch of copies of the texture of different sizes) for optimization
-
-	return textureID; // Return the id
+	return true;
 }
 
-// Static
 // Loads .DDS textures. Compress using DXT1, DXT3 or DXT5.
-GLuint Texture::loadDDSTexture(const std::string& texturePath)
+bool Texture::decodeDDSTexture()
 {
 	const int headerSize = 124;
 	std::vector<char> header(headerSize);
 
 	// Try to open the file
-	std::ifstream file(texturePath, std::ios::binary);
+	std::ifstream file(mPath, std::ios::binary);
 
 	if(!file)
 	{
-		std::string error = "Texture '" + texturePath + "' cannot be opened or doesn't exist!";
+		std::string error = "Texture '" + mPath + "' cannot be opened or doesn't exist!";
 		Utils::CRASH(error);
-		return 0;
+		return false;
 	}
 
 	// Verify the type of file
@@ -177,82 +250,54 @@ GLuint Texture::loadDDSTexture(const std::string& texturePath)
 	{
 		file.close();
 
-		std::string error = "DDS file '" + texturePath + "' is not a correct DDS file!";
+		std::string error = "DDS file '" + mPath + "' is not a correct DDS file!";
 		Utils::CRASH(error);
-		return 0;
+		return false;
 	}
 
 	// Get the surface description
 	file.read(header.data(), headerSize);
 
-	unsigned int height        = *(unsigned int*)&(header[8]);
-	unsigned int width         = *(unsigned int*)&(header[12]);
+	mHeight                    = *(unsigned int*)&(header[8]);
+	mWidth                     = *(unsigned int*)&(header[12]);
 	unsigned int linearSize    = *(unsigned int*)&(header[16]);
-	unsigned int mipmapCount   = *(unsigned int*)&(header[24]);
+	mMipmapCount               = *(unsigned int*)&(header[24]);
 	unsigned int fourCC        = *(unsigned int*)&(header[80]);
 
-	std::vector<char> buffer;
 	unsigned int bufferSize;
 
 	// How big is it going to be, including all mipmaps?
-	bufferSize = mipmapCount > 1 ? linearSize * 2 : linearSize;
-	buffer.resize(bufferSize);
+	bufferSize = mMipmapCount > 1 ? linearSize * 2 : linearSize;
+	mData.resize(bufferSize);
 
-	file.read(buffer.data(), bufferSize);
+	file.read(mData.data(), bufferSize);
+	mData.resize(static_cast<std::size_t>(file.gcount())); // In case the file was shorter
 
 	// Close the file
 	file.close();
 
 	// See which format we are dealing with and tell OpenGL what to do with it
-	unsigned int components = (fourCC == FOURCC_DXT1) ? 3 : 4;
-	unsigned int format;
 	switch(fourCC)
 	{
 	case FOURCC_DXT1:
-		format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		mFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
 		break;
 
 	case FOURCC_DXT3:
-		format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+		mFormat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
 		break;
 
 	case FOURCC_DXT5:
-		format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		mFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
 		break;
 
 	default:
-		std::string error = "DDS file '" + texturePath + "' cannot be loaded as DDS file!";
+		std::string error = "DDS file '" + mPath + "' cannot be loaded as DDS file!";
 		Utils::CRASH(error);
-		return 0;
-	}
-
-	// Create one OpenGL texture
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-
-	// "Bind" the newly created texture : all future texture functions will modify this
-	glBindTexture(GL_TEXTURE_2D, textureID);
-
-	// Fill each mipmap one after another
-	unsigned int blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
-	unsigned int offset = 0;
-
-	// Load the mipmaps
-	for(unsigned int level = 0; level< mipmapCount && (width || height); ++level)
-	{
-		unsigned int size = ((width+3)/4) * ((height+3)/4) * blockSize;
-		glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, size, buffer.data() + offset);
-
-		offset += size;
-		width /= 2;
-		height /= 2;
-
-		// Deal with non-power-of-two textures
-		if(width < 1) width = 1;
-		if(height < 1) height = 1;
+		return false;
 	}
 
-	return textureID;
+	return true;
 }
 
 std::string Texture::getName() const
@@ -268,4 +313,20 @@ GLuint Texture::getID() const // Can be called from const instances
 GLuint Texture::getType() const
 {
 	return mType;
+}
+
+unsigned int Texture::getWidth() const
+{
+	return mWidth;
+}
+
+unsigned int Texture::getHeight() const
+{
+	return mHeight;
+}
+
+// Only holds something in headless mode, see load()
+const std::vector<char>& Texture::getData() const
+{
+	return mData;
 }
\ No newline at end of file
@@ -26,6 +26,7 @@
 #define FOURCC_DXT5 0x35545844
 
 #include <string>
+#include <vector>
 #include <glad/glad.h>
 
 // Since I am not feeling like rewriting OpenGL, this class is more of a datatype with functions
@@ -39,19 +40,35 @@ private:
 
 	GLuint mID;
 
-	bool load();
+	// Decoded image, ready to be given to OpenGL. Only kept after uploading in headless mode
+	// (there is nothing to upload to), otherwise it is freed once OpenGL has it.
+	std::vector<char> mData;
+	unsigned int mWidth;
+	unsigned int mHeight;
+	unsigned int mMipmapCount;
+	GLenum mFormat;
 
-	static GLuint loadBMPTexture(const std::string& texturePath);
-	static GLuint loadDDSTexture(const std::string& texturePath);
+	bool load(bool uploadNow);
+	void upload();
+
+	bool decodeBMPTexture();
+	bool decodeDDSTexture();
 
 public:
 	Texture(const std::string& name, const std::string& path, int type);
+	Texture(const std::string& name, const std::string& path, int type, bool uploadLater);
 	Texture(const Texture& other);
 	~Texture();
 
+	void finishLoading();
+
 	std::string getName() const;
 	GLuint getID() const;
 	GLuint getType() const;
+
+	unsigned int getWidth() const;
+	unsigned int getHeight() const;
+	const std::vector<char>& getData() const;
 };
 
 #endif /* TEXTURE_HPP */
\ No newline at end of file
@@ -51,57 +51,43 @@ TexturedObject::constTexturePointer TexturedObject::getTexture()
 	return mTexturePointer;
 }
 
-void TexturedObject::render(const Camera& camera)
+void TexturedObject::snapshot(ObjectSnapshot& snapshot, float interpolation) const
 {
-	const ObjectGeometry::uintBuffer& indexBuffer = getObjectGeometry()->getIndexBuffer();
-	const ObjectGeometry::vec3Buffer& positionBuffer = getObjectGeometry()->getPositionBuffer();
-	const ObjectGeometry::vec2Buffer& UVBuffer = getObjectGeometry()->getUVBuffer();
-
-	glm::mat4 modelMatrix = getPhysicsBody().generateModelMatrix();
-
-	glm::mat4 MVP = camera.getProjectionMatrix() * camera.getViewMatrix() * modelMatrix;
-	
-	glUseProgram(getShader()->getID());
-	glUniformMatrix4fv(getShader()->findUniform("MVP"), 1, GL_FALSE, &MVP[0][0]);
-	glUniform1i(getShader()->findUniform("textureSampler"), 0); // The first texture, not necessary for now
-
-	// Positions
-	glEnableVertexAttribArray(0);
-	positionBuffer.bind(GL_ARRAY_BUFFER);
-	glVertexAttribPointer(
-		0,					// Attribute 0, no particular reason but same as the vertex shader's layout and glEnableVertexAttribArray
-		3,					// Size. Number of values per vertex, must be 1, 2, 3 or 4.
-		GL_FLOAT,			// Type of data (GLfloats)
-		GL_FALSE,			// Normalized?
-		0,					// Stride
-		(void*)0			// Array buffer offset
-	);
-
-	// UV coords
-	glEnableVertexAttribArray(1);
-	UVBuffer.bind(GL_ARRAY_BUFFER);
-	glVertexAttribPointer(
-		1,					// Attribute 1, no particular reason but same as the vertex shader's layout and glEnableVertexAttribArray
-		2,					// Size. Number of values per cell, must be 1, 2, 3 or 4.
-		GL_FLOAT,			// Type of data (GLfloats)
-		GL_FALSE,			// Normalized?
-		0,					// Stride
-		(void*)0			// Array buffer offset
-	);
-
-	// Texture
-	glActiveTexture(GL_TEXTURE0); // Set the active texture unit, you can have more than 1 texture at once
-	glBindTexture(GL_TEXTURE_2D, mTexturePointer->getID());
+	Object::snapshot(snapshot, interpolation);
+
+	snapshot.render = &TexturedObject::renderSnapshot;
+	snapshot.renderInstances = &TexturedObject::renderInstancedSnapshot;
+	snapshot.texture = mTexturePointer;
+}
+
+// Static
+void TexturedObject::renderSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue)
+{
+	const Shader& shader = *object.shader;
+
+	queue.useShader(shader);
+	shader.setUniform(SHADER_UNIFORM_TEXTURE_SAMPLER, 0); // The first texture, only sent once
+	shader.setUniform(SHADER_UNIFORM_MVP, object.mvpMatrix);
+
+	queue.bindGeometry(*object.objectGeometry, object.arenaLocation, VERTEX_LAYOUT_TEXTURED);
+	queue.bindTexture(object.texture->getID());
 
 	// Draw!
 	// Use the index buffer, more efficient!
-	glDrawElements(
-		GL_TRIANGLES,            // Mode
-		indexBuffer.getLength(), // Count
-		GL_UNSIGNED_INT,         // Type
-		(void*)0                 // Element array buffer offset
-	);
-
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
+	queue.drawElements();
+}
+
+// Static
+void TexturedObject::renderInstancedSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue,
+	int firstInstance, int instanceCount)
+{
+	const Shader& shader = *object.shader->getInstancedVariant();
+
+	queue.useShader(shader); // The camera is in a uniform block
+	shader.setUniform(SHADER_UNIFORM_TEXTURE_SAMPLER, 0);
+
+	queue.bindGeometry(*object.objectGeometry, object.arenaLocation, VERTEX_LAYOUT_TEXTURED, true);
+	queue.bindTexture(object.texture->getID());
+
+	queue.drawElementsInstanced(firstInstance, instanceCount);
 }
\ No newline at end of file
@@ -43,7 +43,11 @@ public:
 	void setTexture(constTexturePointer texturePointer);
 	constTexturePointer getTexture();
 
-	void render(const Camera& camera) override;
+	void snapshot(ObjectSnapshot& snapshot, float interpolation) const override;
+
+	static void renderSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue);
+	static void renderInstancedSnapshot(const ObjectSnapshot& object, const SceneSnapshot& scene, RenderQueue& queue,
+		int firstInstance, int instanceCount);
 };
 
 #endif /* TEXTURED_OBJECT_HPP */
\ No newline at end of file
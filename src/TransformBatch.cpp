@@ -0,0 +1,269 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+#include <TransformBatch.hpp>
+
+#include <cmath> // For std::sin() and std::cos()
+
+// x86-64 always has SSE2, 32-bit x86 only if the compiler was told so
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define TRANSFORM_BATCH_USE_SSE
+	#include <emmintrin.h>
+#endif
+
+#ifdef TRANSFORM_BATCH_USE_SSE
+// Sine and cosine of 4 angles at once, same method as the Cephes library (sinf() and cosf()).
+// The angle is brought back between -pi/4 and pi/4, then a polynomial is used. Precise enough for |angle| < 8192.
+static inline void sinCos4(__m128 angle, __m128* sinResult, __m128* cosResult)
+{
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+
+	__m128 sinSign = _mm_and_ps(angle, signMask); // sin(-x) = -sin(x), cos(-x) = cos(x)
+	__m128 x = _mm_andnot_ps(signMask, angle);
+
+	// Which eighth of a turn we are in, rounded up to an even one
+	__m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f))); // 4 / pi
+	octant = _mm_and_si128(_mm_add_epi32(octant, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+	__m128 y = _mm_cvtepi32_ps(octant);
+
+	// Every half turn flips the sign of the sine, and every quarter turn swaps sine and cosine
+	sinSign = _mm_xor_ps(sinSign, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29)));
+	__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+		_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+	__m128 swapMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+	// x - y * pi / 4, in three parts to keep the precision
+	x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+	x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+	x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
+
+	__m128 z = _mm_mul_ps(x, x);
+
+	__m128 cosPolynomial = _mm_set1_ps(2.443315711809948e-5f);
+	cosPolynomial = _mm_add_ps(_mm_mul_ps(cosPolynomial, z), _mm_set1_ps(-1.388731625493765e-3f));
+	cosPolynomial = _mm_add_ps(_mm_mul_ps(cosPolynomial, z), _mm_set1_ps(4.166664568298827e-2f));
+	cosPolynomial = _mm_mul_ps(_mm_mul_ps(cosPolynomial, z), z);
+	cosPolynomial = _mm_sub_ps(cosPolynomial, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	cosPolynomial = _mm_add_ps(cosPolynomial, _mm_set1_ps(1.0f));
+
+	__m128 sinPolynomial = _mm_set1_ps(-1.9515295891e-4f);
+	sinPolynomial = _mm_add_ps(_mm_mul_ps(sinPolynomial, z), _mm_set1_ps(8.3321608736e-3f));
+	sinPolynomial = _mm_add_ps(_mm_mul_ps(sinPolynomial, z), _mm_set1_ps(-1.6666654611e-1f));
+	sinPolynomial = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPolynomial, z), x), x);
+
+	__m128 sinValue = _mm_or_ps(_mm_and_ps(swapMask, sinPolynomial), _mm_andnot_ps(swapMask, cosPolynomial));
+	__m128 cosValue = _mm_or_ps(_mm_and_ps(swapMask, cosPolynomial), _mm_andnot_ps(swapMask, sinPolynomial));
+
+	*sinResult = _mm_xor_ps(sinValue, sinSign);
+	*cosResult = _mm_xor_ps(cosValue, cosSign);
+}
+
+// One column of 4 matrices (one register per row) to the same column of each matrix
+static inline void storeColumns(__m128 row0, __m128 row1, __m128 row2, __m128 row3, float* const columns[4])
+{
+	_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+	_mm_storeu_ps(columns[0], row0);
+	_mm_storeu_ps(columns[1], row1);
+	_mm_storeu_ps(columns[2], row2);
+	_mm_storeu_ps(columns[3], row3);
+}
+
+// Same for 3 rows. Columns of a mat3 are 3 floats, so they go through the stack instead of writing one float too far.
+static inline void storeColumns3(__m128 row0, __m128 row1, __m128 row2, float* const columns[4])
+{
+	__m128 row3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+	float transposed[4][4];
+	_mm_storeu_ps(transposed[0], row0);
+	_mm_storeu_ps(transposed[1], row1);
+	_mm_storeu_ps(transposed[2], row2);
+	_mm_storeu_ps(transposed[3], row3);
+
+	for(int i = 0; i < 4; i++)
+	{
+		columns[i][0] = transposed[i][0];
+		columns[i][1] = transposed[i][1];
+		columns[i][2] = transposed[i][2];
+	}
+}
+#endif
+
+TransformBatch::TransformBatch()
+{
+	mCount = 0;
+}
+
+void TransformBatch::clear()
+{
+	mCount = 0;
+}
+
+// Returns false if the batch is full
+bool TransformBatch::add(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scaling)
+{
+	if(mCount >= SNAPSHOT_BATCH_SIZE)
+		return false;
+
+	int i = mCount;
+	mCount++;
+
+	mPositionX[i] = position.x * PHYSICS_PIXELS_PER_METER;
+	mPositionY[i] = position.y * PHYSICS_PIXELS_PER_METER;
+	mPositionZ[i] = position.z * PHYSICS_PIXELS_PER_METER;
+
+	// Whole turns are removed, the SSE sine isn't precise for huge angles. Same conversion as PhysicsBody::degreesToRadians().
+	glm::vec3 wrappedRotation = rotation - 360.0f * glm::floor(rotation / 360.0f); // Much faster than std::fmod()
+	mRotationX[i] = wrappedRotation.x * (CONST_PI / 180.0f);
+	mRotationY[i] = wrappedRotation.y * (CONST_PI / 180.0f);
+	mRotationZ[i] = wrappedRotation.z * (CONST_PI / 180.0f);
+
+	mScalingX[i] = scaling.x;
+	mScalingY[i] = scaling.y;
+	mScalingZ[i] = scaling.z;
+
+	return true;
+}
+
+int TransformBatch::getCount() const
+{
+	return mCount;
+}
+
+// Translation * rotation X * rotation Y * rotation Z * scaling, like PhysicsBody::generateModelMatrix().
+// The rotation has no scaling, so the inverse transpose of rotation * scaling is rotation * (1 / scaling).
+void TransformBatch::computeOne(int index, const glm::mat4& viewProjectionMatrix, ObjectSnapshot& object) const
+{
+	float sinX = std::sin(mRotationX[index]);
+	float cosX = std::cos(mRotationX[index]);
+	float sinY = std::sin(mRotationY[index]);
+	float cosY = std::cos(mRotationY[index]);
+	float sinZ = std::sin(mRotationZ[index]);
+	float cosZ = std::cos(mRotationZ[index]);
+
+	// Columns of the rotation
+	glm::vec3 rotation[3];
+	rotation[0] = glm::vec3(cosY * cosZ, sinX * sinY * cosZ + cosX * sinZ, sinX * sinZ - cosX * sinY * cosZ);
+	rotation[1] = glm::vec3(-cosY * sinZ, cosX * cosZ - sinX * sinY * sinZ, cosX * sinY * sinZ + sinX * cosZ);
+	rotation[2] = glm::vec3(sinY, -sinX * cosY, cosX * cosY);
+
+	glm::vec3 scaling(mScalingX[index], mScalingY[index], mScalingZ[index]);
+
+	for(int c = 0; c < 3; c++)
+	{
+		object.modelMatrix[c] = glm::vec4(rotation[c] * scaling[c], 0.0f);
+		object.normalMatrix[c] = rotation[c] / scaling[c];
+	}
+
+	object.modelMatrix[3] = glm::vec4(mPositionX[index], mPositionY[index], mPositionZ[index], 1.0f);
+	object.mvpMatrix = viewProjectionMatrix * object.modelMatrix;
+}
+
+void TransformBatch::compute(const glm::mat4& viewProjectionMatrix, ObjectSnapshot* objects) const
+{
+	int i = 0;
+
+#ifdef TRANSFORM_BATCH_USE_SSE
+	const glm::mat4& vp = viewProjectionMatrix;
+
+	for(; i + 4 <= mCount; i += 4)
+	{
+		__m128 sinX, cosX, sinY, cosY, sinZ, cosZ;
+		sinCos4(_mm_loadu_ps(mRotationX + i), &sinX, &cosX);
+		sinCos4(_mm_loadu_ps(mRotationY + i), &sinY, &cosY);
+		sinCos4(_mm_loadu_ps(mRotationZ + i), &sinZ, &cosZ);
+
+		__m128 sinXsinY = _mm_mul_ps(sinX, sinY);
+		__m128 cosXsinY = _mm_mul_ps(cosX, sinY);
+
+		// Same as computeOne(), [column][row]
+		__m128 rotation[3][3];
+		rotation[0][0] = _mm_mul_ps(cosY, cosZ);
+		rotation[0][1] = _mm_add_ps(_mm_mul_ps(sinXsinY, cosZ), _mm_mul_ps(cosX, sinZ));
+		rotation[0][2] = _mm_sub_ps(_mm_mul_ps(sinX, sinZ), _mm_mul_ps(cosXsinY, cosZ));
+		rotation[1][0] = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(cosY, sinZ));
+		rotation[1][1] = _mm_sub_ps(_mm_mul_ps(cosX, cosZ), _mm_mul_ps(sinXsinY, sinZ));
+		rotation[1][2] = _mm_add_ps(_mm_mul_ps(cosXsinY, sinZ), _mm_mul_ps(sinX, cosZ));
+		rotation[2][0] = sinY;
+		rotation[2][1] = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(sinX, cosY));
+		rotation[2][2] = _mm_mul_ps(cosX, cosY);
+
+		__m128 scaling[3] = {_mm_loadu_ps(mScalingX + i), _mm_loadu_ps(mScalingY + i), _mm_loadu_ps(mScalingZ + i)};
+
+		__m128 model[4][4];
+		__m128 normal[3][3];
+
+		for(int c = 0; c < 3; c++)
+		{
+			__m128 inverseScaling = _mm_div_ps(_mm_set1_ps(1.0f), scaling[c]);
+
+			for(int r = 0; r < 3; r++)
+			{
+				model[c][r] = _mm_mul_ps(rotation[c][r], scaling[c]);
+				normal[c][r] = _mm_mul_ps(rotation[c][r], inverseScaling);
+			}
+
+			model[c][3] = _mm_setzero_ps();
+		}
+
+		model[3][0] = _mm_loadu_ps(mPositionX + i);
+		model[3][1] = _mm_loadu_ps(mPositionY + i);
+		model[3][2] = _mm_loadu_ps(mPositionZ + i);
+		model[3][3] = _mm_set1_ps(1.0f);
+
+		// View projection * model, the view projection is the same for all 4
+		__m128 mvp[4][4];
+
+		for(int c = 0; c < 4; c++)
+		{
+			for(int r = 0; r < 4; r++)
+			{
+				mvp[c][r] = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(vp[0][r]), model[c][0]), _mm_mul_ps(_mm_set1_ps(vp[1][r]), model[c][1])),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(vp[2][r]), model[c][2]), _mm_mul_ps(_mm_set1_ps(vp[3][r]), model[c][3])));
+			}
+		}
+
+		// Back to one matrix per object
+		for(int c = 0; c < 4; c++)
+		{
+			float* const modelColumns[4] = {&objects[i].modelMatrix[c][0], &objects[i + 1].modelMatrix[c][0],
+				&objects[i + 2].modelMatrix[c][0], &objects[i + 3].modelMatrix[c][0]};
+			float* const mvpColumns[4] = {&objects[i].mvpMatrix[c][0], &objects[i + 1].mvpMatrix[c][0],
+				&objects[i + 2].mvpMatrix[c][0], &objects[i + 3].mvpMatrix[c][0]};
+
+			storeColumns(model[c][0], model[c][1], model[c][2], model[c][3], modelColumns);
+			storeColumns(mvp[c][0], mvp[c][1], mvp[c][2], mvp[c][3], mvpColumns);
+
+			if(c < 3)
+			{
+				float* const normalColumns[4] = {&objects[i].normalMatrix[c][0], &objects[i + 1].normalMatrix[c][0],
+					&objects[i + 2].normalMatrix[c][0], &objects[i + 3].normalMatrix[c][0]};
+
+				storeColumns3(normal[c][0], normal[c][1], normal[c][2], normalColumns);
+			}
+		}
+	}
+#endif
+
+	// What is left (or everything without SSE)
+	for(; i < mCount; i++)
+		computeOne(i, viewProjectionMatrix, objects[i]);
+}
\ No newline at end of file
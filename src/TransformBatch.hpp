@@ -0,0 +1,64 @@
+//// Copyright 2016 Carl Hewett
+////
+//// This file is part of SDL3D.
+////
+//// SDL3D is free software: you can redistribute it and/or modify
+//// it under the terms of the GNU General Public License as published by
+//// the Free Software Foundation, either version 3 of the License, or
+//// (at your option) any later version.
+////
+//// SDL3D is distributed in the hope that it will be useful,
+//// but WITHOUT ANY WARRANTY; without even the implied warranty of
+//// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//// GNU General Public License for more details.
+////
+//// You should have received a copy of the GNU General Public License
+//// along with SDL3D. If not, see <http://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// Computes the matrices of many objects at once: model, model view projection and normal matrices.
+// Transforms are kept as separate arrays (structure of arrays), so SSE does 4 objects with each instruction,
+// sines and cosines included. The rotation is built straight from the Euler angles instead of multiplying
+// three rotation matrices, and the normal matrix comes from the rotation and scaling instead of a full inverse.
+//
+// Gives the same matrices as PhysicsBody::generateModelMatrix().
+
+#ifndef TRANSFORM_BATCH_HPP
+#define TRANSFORM_BATCH_HPP
+
+#include <Definitions.hpp>
+#include <SceneSnapshot.hpp>
+
+#include <glm/glm.hpp>
+
+class TransformBatch
+{
+private:
+	// Position is already scaled by PHYSICS_PIXELS_PER_METER, rotation is in radians
+	float mPositionX[SNAPSHOT_BATCH_SIZE];
+	float mPositionY[SNAPSHOT_BATCH_SIZE];
+	float mPositionZ[SNAPSHOT_BATCH_SIZE];
+	float mRotationX[SNAPSHOT_BATCH_SIZE];
+	float mRotationY[SNAPSHOT_BATCH_SIZE];
+	float mRotationZ[SNAPSHOT_BATCH_SIZE];
+	float mScalingX[SNAPSHOT_BATCH_SIZE];
+	float mScalingY[SNAPSHOT_BATCH_SIZE];
+	float mScalingZ[SNAPSHOT_BATCH_SIZE];
+
+	int mCount;
+
+	void computeOne(int index, const glm::mat4& viewProjectionMatrix, ObjectSnapshot& object) const;
+
+public:
+	TransformBatch();
+
+	void clear();
+	bool add(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scaling); // Like PhysicsBody, rotation in degrees
+	int getCount() const;
+
+	// Sets modelMatrix, mvpMatrix and normalMatrix of objects[0] to objects[getCount() - 1]
+	void compute(const glm::mat4& viewProjectionMatrix, ObjectSnapshot* objects) const;
+};
+
+#endif /* TRANSFORM_BATCH_HPP */
\ No newline at end of file
@@ -19,24 +19,196 @@
 
 #include <Utils.hpp>
 #include <Definitions.hpp>
+#include <JobSystem.hpp> // For stopping the workers when crashing
 
 #include <SDL.h> // For quitting
 #include <SDL_mixer.h> // For quitting
 #include <fstream>
 
 #include <sstream> // For std::getLine()
+#include <chrono>
+#include <memory> // For smart pointers
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <cstring> // For strlen()
+#include <cstdlib> // For std::_Exit()
 
 namespace Utils
 {
+// Logging
+// Messages go in a lock-free queue (any thread can push), and a writer thread writes them to the file.
+// This way, logging never waits after the disk.
+
+struct LogRecord
+{
+	std::atomic<LogRecord*> next;
+	std::string text;
+};
+
+// Multiple producers, single consumer queue, see
+// http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+class LogQueue
+{
+private:
+	std::atomic<LogRecord*> mHead; // Producers push here
+	LogRecord* mTail; // Only touched by the consumer
+	LogRecord mStub; // Always in the queue somewhere, so it is never empty
+
+public:
+	LogQueue()
+	{
+		mStub.next.store(nullptr, std::memory_order_relaxed);
+		mHead.store(&mStub, std::memory_order_relaxed);
+		mTail = &mStub;
+	}
+
+	~LogQueue()
+	{
+		while(LogRecord* record = pop())
+			delete record;
+	}
+
+	// Wait-free, any thread
+	void push(LogRecord* record)
+	{
+		record->next.store(nullptr, std::memory_order_relaxed);
+		LogRecord* previous = mHead.exchange(record, std::memory_order_acq_rel);
+		previous->next.store(record, std::memory_order_release);
+	}
+
+	// Only one thread at a time! Returns null if empty (or if a push is half done, it will be there next time)
+	LogRecord* pop()
+	{
+		LogRecord* tail = mTail;
+		LogRecord* next = tail->next.load(std::memory_order_acquire);
+
+		if(tail == &mStub) // Skip the stub
+		{
+			if(!next)
+				return nullptr;
+
+			mTail = next;
+			tail = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+
+		if(next)
+		{
+			mTail = next;
+			return tail;
+		}
+
+		if(tail != mHead.load(std::memory_order_acquire))
+			return nullptr; // Someone is pushing
+
+		push(&mStub); // Put the stub back so we can take the last record
+		next = tail->next.load(std::memory_order_acquire);
+
+		if(next)
+		{
+			mTail = next;
+			return tail;
+		}
+
+		return nullptr;
+	}
+};
+
 std::ofstream gLogFile(LOG_FILE, std::ios::app); // Evil global
+std::atomic<int> gLogLevel(LOG_COMPILE_LEVEL);
+bool gHeadless = false; // Another evil global, but every resource needs to know if there is a GL context or not
+std::atomic<int> gGLErrorMode(GRAPHICS_ERROR_MODE_CALLBACK); // Falls back to polling if debug output isn't supported
+
+// How many times a GL debug message was seen, by source and ID
+std::mutex gGLDebugMessagesMutex; // Messages can come from driver threads
+std::unordered_map<Uint64, int> gGLDebugMessageCounts;
+
+LogQueue gLogQueue;
+std::mutex gLogConsumerMutex; // Only one thread writes to the file at a time (the writer thread, or whoever is closing it)
+std::atomic<bool> gLogWriterRunning(false);
+std::atomic<bool> gLogWriterStopping(false);
+std::mutex gLogWriterMutex; // For waking up the writer
+std::condition_variable gLogWriterCondition;
+std::thread gLogWriterThread;
+
+// Writes everything in the queue to the file
+static void writeLogQueue()
+{
+	std::lock_guard<std::mutex> lock(gLogConsumerMutex);
+	bool wroteSomething = false;
+
+	while(LogRecord* record = gLogQueue.pop())
+	{
+		gLogFile << record->text;
+		delete record;
+
+		wroteSomething = true;
+	}
+
+	if(wroteSomething)
+		gLogFile.flush(); // We are not in a hurry here, so get the logs out even if the game explodes later
+}
+
+static void runLogWriter()
+{
+	while(!gLogWriterStopping.load(std::memory_order_acquire))
+	{
+		writeLogQueue();
+
+		// Producers don't wake us up (that could block them), so check regularly
+		std::unique_lock<std::mutex> lock(gLogWriterMutex);
+		gLogWriterCondition.wait_for(lock, std::chrono::milliseconds(10));
+	}
+
+	writeLogQueue();
+}
+
+static void startLogWriter()
+{
+	if(gLogWriterRunning.load())
+		return;
+
+	gLogWriterStopping.store(false);
+	gLogWriterThread = std::thread(runLogWriter);
+	gLogWriterRunning.store(true);
+}
+
+static void stopLogWriter()
+{
+	if(!gLogWriterRunning.load())
+		return;
+
+	gLogWriterRunning.store(false); // New messages are written directly from now on
+	gLogWriterStopping.store(true, std::memory_order_release);
+	gLogWriterCondition.notify_all();
+
+	if(gLogWriterThread.joinable() && gLogWriterThread.get_id() != std::this_thread::get_id())
+		gLogWriterThread.join();
+
+	writeLogQueue(); // Anything pushed while stopping
+}
+
+// Makes sure the writer thread is joined when the program ends, even if closeLogFile() wasn't called
+struct LogWriterGuard
+{
+	~LogWriterGuard()
+	{
+		stopLogWriter();
+	}
+} gLogWriterGuard;
 
 void closeLogFile() // Log file opens by itself, but doesn't close by itself
 {
+	stopLogWriter(); // Flushes everything
 	gLogFile.close();
 }
 
 void clearDataOutput()
 {
+	stopLogWriter();
+
 	if(gLogFile.is_open()) // Close the file
 		gLogFile.close();
 
@@ -46,38 +218,74 @@ void clearDataOutput()
 	dataFile.close();
 
 	gLogFile.open(LOG_FILE, std::ios::app); // Reopen the file
+	startLogWriter();
+}
+
+// Messages under this level are ignored (without even being built, if you use the macros)
+// Can't go over warnings, and can't go under the compiled level (see LOG_COMPILE_LEVEL)
+void setLogLevel(int level)
+{
+	if(level > LOG_LEVEL_WARNING)
+		level = LOG_LEVEL_WARNING;
+
+	gLogLevel.store(level, std::memory_order_relaxed);
+}
+
+int getLogLevel()
+{
+	return gLogLevel.load(std::memory_order_relaxed);
 }
 
-void directly_logprint(const std::string& msg, int line, const char* file)
+void setHeadless(bool headless)
 {
-	gLogFile << msg << '\n';
+	gHeadless = headless;
+}
+
+bool isHeadless()
+{
+	return gHeadless;
+}
+
+// Thread-safe, doesn't wait for the file
+void directly_logprint(const std::string& msg, int line, const char* file, int level)
+{
+	if(!directly_shouldLog(level)) // The macros already checked, but not Lua
+		return;
+
+	std::unique_ptr<LogRecord> record(new LogRecord);
+	std::string& text = record->text;
+
+	text = msg + '\n';
 
 #ifndef NDEBUG // Debug
 	bool parametersDefined = false;
 
 	if(file != 0) // If file is defined
 	{
-		gLogFile << "----- from file: " << file << '\n';
+		text += "----- from file: " + std::string(file) + '\n';
 		parametersDefined = true;
 	}
 
 	if(line != -1) // If line is defined
 	{
-		gLogFile << "----- at line: " << line << '\n';
+		text += "----- at line: " + std::to_string(line) + '\n';
 		parametersDefined = true;
 	}
 
 	if(parametersDefined) // Add a newline if you outputted something, for prettyness.
-		gLogFile << '\n';
-
-	gLogFile.flush(); // Whatever happens, flush out the buffer so we get logs even if it exploded: this is debug!
+		text += '\n';
 #endif
+
+	gLogQueue.push(record.release());
+
+	if(!gLogWriterRunning.load(std::memory_order_relaxed)) // Before starting or after closing, write it ourselves
+		writeLogQueue();
 }
 
 void directly_warn(const std::string& msg, int line, const char* file)
 {
 	std::string fullString = "\nWarning: " + msg; // Newline for looks
-	directly_logprint(fullString, line, file);
+	directly_logprint(fullString, line, file, LOG_LEVEL_WARNING);
 }
 
 // This quits the game, so don't expect to be able to do other things after calling this (including logging)!
@@ -85,9 +293,16 @@ void directly_crash(const std::string& msg, int line, const char* file)
 {
 	std::string fullString = "\nCrash: " + msg;
 
-	directly_logprint(fullString, line, file);
+	directly_logprint(fullString, line, file, LOG_LEVEL_CRASH);
+
+	closeLogFile(); // Waits until everything is written
 
-	closeLogFile();
+	// Crashes in jobs (loading files...) happen on workers: they can't be joined from there, and SDL must be
+	// quit from the main thread. Skip the static destructors too, the other threads are still using what they destroy.
+	if(JobSystem::isWorkerThread())
+		std::_Exit(1); // The log is already written
+
+	JobSystem::stop(); // Running threads would abort the program when destroyed
 
 	// Lets be at least a bit nice
 	SDL_Quit();
@@ -101,7 +316,7 @@ void directly_crashFromSDL(const std::string& msg, int line, const char* file)
 {
 	std::string sdlError = SDL_GetError();
 
-	Utils::directly_logprint("\n" + msg, line, file);
+	Utils::directly_logprint("\n" + msg, line, file, LOG_LEVEL_CRASH);
 
 	if(!sdlError.empty())
 		Utils::directly_crash("SDL error: " + sdlError); // We already showed the line number and file up top
@@ -111,6 +326,165 @@ void directly_crashFromSDL(const std::string& msg, int line, const char* file)
 	SDL_ClearError();
 }
 
+// Static
+// Called by the driver, maybe on another thread, maybe in the middle of a GL call
+static void APIENTRY onGLDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity,
+	GLsizei length, const GLchar* message, const void* userParam)
+{
+	int count = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(gGLDebugMessagesMutex);
+		count = ++gGLDebugMessageCounts[(static_cast<Uint64>(source) << 32) | id];
+	}
+
+	// Some drivers repeat the same performance warning every frame, don't flood the log
+	if(count > GRAPHICS_MAX_DEBUG_MESSAGES_PER_ID)
+		return;
+
+	std::string text = "OpenGL";
+
+	if(type == GL_DEBUG_TYPE_ERROR)
+		text += " error";
+	else if(type == GL_DEBUG_TYPE_PERFORMANCE)
+		text += " performance warning";
+	else if(type == GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR || type == GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR)
+		text += " warning";
+
+	text += " (" + std::to_string(id) + "): " + std::string(message, length > 0 ? length : strlen(message));
+
+	if(count == GRAPHICS_MAX_DEBUG_MESSAGES_PER_ID)
+		text += " (Repeated too many times, hiding it from now on)";
+
+	if(type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH)
+		WARN(text);
+	else if(severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+		LOGPRINT_DEBUG(text);
+	else
+		LOGPRINT(text);
+}
+
+// Errors are per context, so contexts have to be created with this mode in mind.
+// In strict mode, ask for a debug context (SDL_GL_CONTEXT_DEBUG_FLAG) for the best messages.
+void setGLErrorMode(int mode)
+{
+	if(mode != GRAPHICS_ERROR_MODE_POLLING && mode != GRAPHICS_ERROR_MODE_CALLBACK && mode != GRAPHICS_ERROR_MODE_STRICT)
+	{
+		WARN("Unknown OpenGL error mode " + std::to_string(mode) + "!");
+		return;
+	}
+
+	gGLErrorMode.store(mode);
+}
+
+int getGLErrorMode()
+{
+	return gGLErrorMode.load();
+}
+
+// Registers our debug callback on the context current on this thread
+// Returns false if the driver doesn't support it. We fall back to polling then.
+bool setupGLDebugOutput()
+{
+	int mode = gGLErrorMode.load();
+
+	if(mode == GRAPHICS_ERROR_MODE_POLLING)
+		return false;
+
+	bool synchronous = (mode == GRAPHICS_ERROR_MODE_STRICT);
+
+	if(GLAD_GL_KHR_debug && glDebugMessageCallback)
+	{
+		glEnable(GL_DEBUG_OUTPUT);
+
+		if(synchronous)
+			glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		else
+			glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+
+		glDebugMessageCallback(onGLDebugMessage, nullptr);
+
+#if LOG_COMPILE_LEVEL > LOG_LEVEL_DEBUG
+		// Nobody would see them anyway, don't make the driver call us for nothing
+		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+#endif
+
+		LOGPRINT_DEBUG("Using KHR_debug for OpenGL errors.");
+		return true;
+	} else if(GLAD_GL_ARB_debug_output && glDebugMessageCallbackARB) // Older drivers, only works in debug contexts
+	{
+		if(synchronous)
+			glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+		else
+			glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+
+		glDebugMessageCallbackARB(onGLDebugMessage, nullptr);
+
+		GLint contextFlags = 0;
+		glGetIntegerv(GL_CONTEXT_FLAGS, &contextFlags);
+
+		if(!(contextFlags & GL_CONTEXT_FLAG_DEBUG_BIT))
+		{
+			// The callback might never be called, keep polling so errors aren't lost (release builds only ask for debug contexts in strict mode)
+			LOGPRINT("Not a debug context, ARB_debug_output might stay quiet. Checking for errors every frame too.");
+			gGLErrorMode.store(GRAPHICS_ERROR_MODE_POLLING);
+
+			return false;
+		}
+
+		LOGPRINT_DEBUG("Using ARB_debug_output for OpenGL errors.");
+		return true;
+	}
+
+	LOGPRINT("No OpenGL debug output on this system, checking for errors every frame instead.");
+	gGLErrorMode.store(GRAPHICS_ERROR_MODE_POLLING);
+
+	return false;
+}
+
+// False if the debug callback takes care of everything
+bool shouldPollGLErrors()
+{
+	return gGLErrorMode.load(std::memory_order_relaxed) != GRAPHICS_ERROR_MODE_CALLBACK;
+}
+
+// Warns about all errors of the OpenGL context current on this thread
+// Each call is a round-trip to the driver, see shouldPollGLErrors()
+void checkForGLErrors()
+{
+	const int maxGLErrors = 1000;
+	bool finishedGLErrors = false;
+
+	for(int i=0; i<maxGLErrors; i++) // Because meh, I don't like infinite loops
+	{
+		GLenum err = glGetError();
+		
+		if(err!=GL_NO_ERROR) // There is an error
+		{
+			if(err == GL_INVALID_ENUM)
+				WARN("OpenGL error: GL_INVALID_ENUM");
+			else if(err == GL_INVALID_VALUE)
+				WARN("OpenGL error: GL_INVALID_VALUE");
+			else if(err == GL_INVALID_OPERATION)
+				WARN("OpenGL error: GL_INVALID_OPERATION");
+			else if(err == GL_STACK_OVERFLOW)
+				WARN("OpenGL error: GL_STACK_OVERFLOW");
+			else if(err == GL_STACK_UNDERFLOW)
+				WARN("OpenGL error: GL_STACK_UNDERFLOW");
+			else if(err == GL_OUT_OF_MEMORY)
+				WARN("OpenGL error: GL_OUT_OF_MEMORY");
+		} else // No (more) errors!
+		{
+			finishedGLErrors = true;
+			break;
+		}
+	}
+
+	if(!finishedGLErrors)
+		// Is this even possible?
+		WARN("Over " + std::to_string(maxGLErrors) + " OpenGL errors?!");
+}
+
 // Does checks and returns the contents of the file
 // If it failed, it returns an empty string
 std::string getFileContents(const std::string& filePath)
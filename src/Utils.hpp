@@ -24,28 +24,76 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
 #include <cstddef> // For std::size_t
 
-// Macros simply replaces text
-#define LOGPRINT(msg) directly_logprint(msg) // Don't send the line and file for logprints, it would annoying
-#define LOGPRINT_DEBUG(msg) directly_logprint(msg, __LINE__, __FILE__) // But do whatever you want, fam
+// Log levels, a message is written if its level is at least the current level
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_CRASH 3 // Crashes are always written
+
+// Messages under this level are compiled out. Define it yourself to change it.
+#ifndef LOG_COMPILE_LEVEL
+	#ifndef NDEBUG // Debug
+		#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+	#else
+		#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+	#endif
+#endif
+
+// How OpenGL errors are found, see Utils::setGLErrorMode()
+#define GRAPHICS_ERROR_MODE_POLLING 0 // glGetError() every frame, forces a round-trip to the driver. Fallback if there is no debug output.
+#define GRAPHICS_ERROR_MODE_CALLBACK 1 // The driver tells us (KHR_debug/ARB_debug_output), no polling
+#define GRAPHICS_ERROR_MODE_STRICT 2 // Both, and the driver reports right in the GL call that caused it. Slow, for hunting errors.
 
-#define WARN(msg) directly_warn(msg, __LINE__, __FILE__)
+// Macros simply replaces text
+// The level is checked first, so the message isn't even built if it won't be written.
+// These are used as Utils::LOGPRINT(), so they have to start with something in Utils.
+#define LOGPRINT(msg) directly_shouldLog(LOG_LEVEL_INFO) ? \
+	Utils::directly_logprint(msg, -1, 0, LOG_LEVEL_INFO) : (void)0 // Don't send the line and file for logprints, it would annoying
+#define LOGPRINT_DEBUG(msg) directly_shouldLog(LOG_LEVEL_DEBUG) ? \
+	Utils::directly_logprint(msg, __LINE__, __FILE__, LOG_LEVEL_DEBUG) : (void)0 // But do whatever you want, fam
+
+#define WARN(msg) directly_shouldLog(LOG_LEVEL_WARNING) ? \
+	Utils::directly_warn(msg, __LINE__, __FILE__) : (void)0
 #define CRASH(msg) directly_crash(msg, __LINE__, __FILE__)
 
 #define CRASH_FROM_SDL(msg) directly_crashFromSDL(msg, __LINE__, __FILE__)
 
 namespace Utils
 {
-	void closeLogFile();
+	void closeLogFile(); // Writes everything left, use this before quitting
 	void clearDataOutput();
 
+	void setLogLevel(int level);
+	int getLogLevel();
+
+	// Headless mode: no window, no OpenGL context. Set this before initializing the game!
+	void setHeadless(bool headless);
+	bool isHeadless();
+
 	// Use macros above to access these
-	void directly_logprint(const std::string& msg, int line = -1, const char *file = 0);
+	extern std::atomic<int> gLogLevel;
+
+	inline bool directly_shouldLog(int level)
+	{
+		// The first part is known at compile time, so disabled messages disappear completely
+		return level >= LOG_COMPILE_LEVEL && level >= gLogLevel.load(std::memory_order_relaxed);
+	}
+
+	void directly_logprint(const std::string& msg, int line = -1, const char *file = 0, int level = LOG_LEVEL_INFO);
 	void directly_warn(const std::string& msg, int line = -1, const char *file = 0);
 	void directly_crash(const std::string& msg, int line = -1, const char *file = 0);
 	void directly_crashFromSDL(const std::string& msg, int line = -1, const char *file = 0);
 
+	// These need a GL context on the calling thread
+	void setGLErrorMode(int mode); // Before creating contexts
+	int getGLErrorMode();
+	bool setupGLDebugOutput(); // Once per context
+	bool shouldPollGLErrors();
+	void checkForGLErrors();
+
 	std::string getFileContents(const std::string& filePath);
 
 	std::vector<std::string>& splitString(const std::string& s, char delim, std::vector<std::string>& elems);